@@ -11,6 +11,8 @@ response from the computer. This effectively adds another
 buffer layer to prevent buffer starvation.
 
 CHANGELOG:
+- 20261018: Binary g-code frame streaming option. Requires
+    ENABLE_BINARY_GCODE in config.h.
 - 20170531: Status report feedback at 1.0 second intervals.
     Configurable baudrate and report intervals. Bug fixes.
 - 20161212: Added push message feedback for simple streaming
@@ -71,8 +73,44 @@ parser.add_argument('-s','--settings',action='store_true', default=False,
         help='settings write mode')        
 parser.add_argument('-c','--check',action='store_true', default=False,
         help='stream in check mode')
+parser.add_argument('-b','--binary',action='store_true', default=False,
+        help='stream g-code blocks as binary frames')
 args = parser.parse_args()
 
+# Encode a filtered g-code block into a binary frame. Returns None, if the block can't
+# be encoded, such as a '$' command. These are sent as ASCII lines instead.
+def crc16(data):
+    crc = 0xFFFF
+    for c in data:
+        crc ^= ord(c) << 8
+        for i in range(8):
+            if crc & 0x8000 : crc = ((crc << 1) ^ 0x1021) & 0xFFFF
+            else : crc = (crc << 1) & 0xFFFF
+    return crc
+
+def encode_frame(l_block):
+    if not re.match('^([A-Z][-+]?(\d+\.?\d*|\.\d+))+$',l_block) : return None
+    payload = ''
+    for letter,value,digits in re.findall('([A-Z])([-+]?(\d+\.?\d*|\.\d+))',l_block):
+        decimals = len(value.split('.')[1]) if '.' in value else 0
+        if decimals > 7 : return None
+        n = int(value.replace('.','').replace('+',''))
+        zigzag = 2*n if n >= 0 else -2*n-1
+        payload += chr((decimals << 5) | (ord(letter)-ord('A')+1))
+        while zigzag > 0x7F :
+            payload += chr((zigzag & 0x7F) | 0x80)
+            zigzag >>= 7
+        payload += chr(zigzag)
+    if len(payload) > RX_BUFFER_SIZE-4 : return None
+    crc = crc16(chr(len(payload)) + payload)
+    frame = '\x02'
+    for c in chr(len(payload)) + payload + chr(crc >> 8) + chr(crc & 0xFF) :
+        # Escape bytes Grbl would take for realtime commands, line ends or a frame start.
+        if c in '\x02\n\r\x1b\x18!?~' or 0x80 <= ord(c) <= 0xBF : frame += '\x1b' + chr(ord(c) ^ 0x40)
+        else : frame += c
+    if len(frame) >= RX_BUFFER_SIZE : return None
+    return frame
+
 # Periodic timer to query for status reports
 # TODO: Need to track down why this doesn't restart consistently before a release.
 def send_status_query():
@@ -115,6 +153,21 @@ if check_mode :
             if verbose: print 'REC:',grbl_out
             break
 
+binary_mode = False
+if args.binary and not settings_mode :
+    print "Enabling Grbl Binary Frames: SND: [$B=1]",
+    s.write("$B=1\n")
+    while 1:
+        grbl_out = s.readline().strip() # Wait for grbl response with carriage return
+        if grbl_out.find('error') >= 0 :
+            print "REC:",grbl_out
+            print "  Failed to enable binary frames. Aborting..."
+            quit()
+        elif grbl_out.find('ok') >= 0 :
+            if verbose: print 'REC:',grbl_out
+            break
+    binary_mode = True
+
 start_time = time.time();
 
 # Start status report periodic timer
@@ -159,7 +212,11 @@ else:
         l_count += 1 # Iterate line counter
         l_block = re.sub('\s|\(.*?\)','',line).upper() # Strip comments/spaces/new line and capitalize
         # l_block = line.strip()
-        c_line.append(len(l_block)+1) # Track number of characters in grbl serial read buffer
+        l_data = l_block + '\n'
+        if binary_mode :
+            frame = encode_frame(l_block)
+            if frame : l_data = frame
+        c_line.append(len(l_data)) # Track number of characters in grbl serial read buffer
         grbl_out = '' 
         while sum(c_line) >= RX_BUFFER_SIZE-1 | s.inWaiting() :
             out_temp = s.readline().strip() # Wait for grbl response
@@ -170,7 +227,7 @@ else:
                 g_count += 1 # Iterate g-code counter
                 if verbose: print "  REC<"+str(g_count)+": \""+out_temp+"\""
                 del c_line[0] # Delete the block character count corresponding to the last 'ok'
-        s.write(l_block + '\n') # Send g-code block to grbl
+        s.write(l_data) # Send g-code block to grbl
         if verbose: print "SND>"+str(l_count)+": \"" + l_block + "\""
     # Wait until all responses have been received.
     while l_count > g_count :
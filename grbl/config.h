@@ -130,6 +130,7 @@
 #define CMD_SAFETY_DOOR 0x84
 #define CMD_JOG_CANCEL  0x85
 #define CMD_DEBUG_REPORT 0x86 // Only when DEBUG enabled, sends debug report in '{}' braces.
+#define CMD_BINARY_STATUS_REPORT 0x87 // Only when ENABLE_BINARY_STATUS_REPORT enabled and set by $10.
 #define CMD_FEED_OVR_RESET 0x90         // Restores feed override value to 100%.
 #define CMD_FEED_OVR_COARSE_PLUS 0x91
 #define CMD_FEED_OVR_COARSE_MINUS 0x92
@@ -323,6 +324,34 @@
 // Enables code for debugging purposes. Not for general use and always in constant flux.
 //#define DEBUG // Uncomment to enable. Default disabled.
 
+// Enables a cycle-count profiler for the stepper driver and port reset interrupts. Timer5 is set up
+// as a free-running cycle counter, and the cost of each interrupt call is recorded as min, average,
+// max and a histogram of 5usec wide bins. Stepper interrupt calls are grouped by whether they loaded
+// a new step segment or a new stepper block, and by AMASS level. The '$P' command prints the profile
+// and '$P=0' clears it. Also works in the host simulator, where the numbers reflect host CPU time.
+// NOTE: Costs a few microseconds per interrupt and about 400 bytes of RAM. Not for production use.
+// #define STEPPER_ISR_PROFILE // Default disabled. Uncomment to enable.
+
+// Enables a trace of step events for post-mortem timing analysis of stutters. The stepper interrupt
+// logs a compact record with a Timer5 timestamp each time it loads a step segment, starts a new
+// block, switches AMASS level or finds the segment buffer empty, along with the segment timer period
+// and the number of segments still queued. An empty segment buffer while the planner still holds
+// blocks is an underrun. The ring keeps the last 64 records, and stops half a ring after the first
+// underrun so the records leading up to it are kept. The '$T' command stops the trace and prints it,
+// '$T=0' clears it and restarts recording. In the host simulator, timestamps follow the virtual clock.
+// NOTE: Uses Timer5, so it can't be combined with STEPPER_ISR_PROFILE. Costs about 450 bytes of RAM.
+// #define STEPPER_TRACE // Default disabled. Uncomment to enable.
+
+// Enables segment buffer health counters for tuning SEGMENT_BUFFER_SIZE, BLOCK_BUFFER_SIZE and the
+// streaming rate. The stepper interrupt counts underruns, where the segment buffer ran empty and
+// stopped the steppers mid-motion, near-underruns, where it loaded the last queued segment, and
+// planner starvations, where the planner ran empty while the steppers moved. It also tracks the
+// low-water mark of queued segments. The '$U' command prints the counters and '$U=0' clears them.
+// The optional status report field adds the counters to every status report as '|Sb:'.
+// NOTE: Adds a few microseconds to every segment load of the stepper interrupt.
+// #define SEGMENT_BUFFER_STATS // Default disabled. Uncomment to enable.
+// #define REPORT_FIELD_SEGMENT_BUFFER_STATS // Default disabled. Requires SEGMENT_BUFFER_STATS.
+
 // Configure rapid, feed, and spindle override settings. These values define the max and min
 // allowable override values and the coarse and fine increments per command received. Please
 // note the allowable values in the descriptions following each define.
@@ -361,6 +390,21 @@
 #define REPORT_FIELD_OVERRIDES // Default enabled. Comment to disable.
 #define REPORT_FIELD_LINE_NUMBERS // Default enabled. Comment to disable.
 
+// Adds a compact binary status frame, sent in answer to the CMD_BINARY_STATUS_REPORT realtime
+// command once enabled by bit 2 of the $10 status report mask. The frame carries the raw machine
+// position in steps, the buffer states, the override values and the pin states with a CRC-16, in
+// 30 bytes for four axes. That is a fraction of the ASCII report, so hosts may poll it at 100Hz and
+// more without crowding out the 'ok' responses of the stream. Frame layout is in interface.md.
+// #define ENABLE_BINARY_STATUS_REPORT // Default disabled. Uncomment to enable.
+
+// Pushes the machine position to the host at a fixed rate, set by the '$D=<milliseconds>' system
+// command, instead of the host polling with '?'. Each push is a small binary frame holding the
+// motion of each axis since the previous push in steps, as signed varints, so a 100Hz push of a
+// moving machine takes around 10 bytes. Once a second, a keyframe sends the whole position, so a
+// host recovers from a lost frame. Pushes are timed by Timer2 and sent by the main program.
+// Frame layout is in interface.md.
+// #define ENABLE_POSITION_PUSH // Default disabled. Uncomment to enable.
+
 // Some status report data isn't necessary for realtime, only intermittently, because the values don't
 // change often. The following macros configures how many times a status report needs to be called before
 // the associated data is refreshed and included in the status report. However, if one of these value
@@ -384,6 +428,40 @@
 // certain the step segment buffer is increased/decreased to account for these changes.
 #define ACCELERATION_TICKS_PER_SECOND 100
 
+// Computes the step segments from the planner blocks in fixed-point integer math, instead of floats.
+// Segment distances are tracked in 1/65536 steps, times in 1/65536 of a segment, and speeds in
+// 1/65536 steps per segment, so full segments mostly need only integer additions. Block velocity
+// profiles are still computed in floats, once per planner block. The end of every block is step-exact,
+// as the block distance is counted in whole steps from the planner. This cuts the main loop time
+// spent on each segment, which makes room for a higher ACCELERATION_TICKS_PER_SECOND or for short
+// line segments streamed at high feed rates.
+// NOTE: Acceleration is rounded to 1/65536 steps per segment squared. With very low step/mm or
+// acceleration settings and a high ACCELERATION_TICKS_PER_SECOND, this can be a few percent.
+// #define STEPPER_FIXED_POINT // Default disabled. Uncomment to enable.
+
+// Lets step segments that start in the cruise phase of a block run CRUISE_SEGMENT_TICKS acceleration
+// ticks long, instead of one, which cuts the main loop time spent preparing segments on cruise-heavy
+// jobs. Acceleration and deceleration ramps keep one-tick segments, and a long cruise segment ends
+// where the deceleration begins, so ramps keep their resolution. The segment buffer is then filled up
+// to SEGMENT_BUFFER_TICKS of queued segment time rather than to a number of segments, which keeps the
+// time a feed hold waits for queued segments the same. This also makes a higher
+// ACCELERATION_TICKS_PER_SECOND affordable for smoother ramps. Arc blocks of ARC_PLANNER_BLOCKS are
+// always stepped in one-tick segments to keep their chord error.
+// #define ADAPTIVE_SEGMENT_TIME // Default disabled. Uncomment to enable.
+// #define CRUISE_SEGMENT_TICKS 4 // Uncomment to override default in stepper.h.
+// #define SEGMENT_BUFFER_TICKS 9 // Uncomment to override default in stepper.h.
+
+// Adds jerk-limited (S-curve) speed ramps, selected by the $28 jerk setting in mm/sec^3. The
+// acceleration then changes at no more than $28 instead of stepping between zero and the $12x axis
+// accelerations, which reduces ringing on machines that otherwise need very low acceleration
+// settings. Ramps still reach the full axis accelerations. The stepper carries its speed and
+// acceleration across planner blocks and replans, so a ramp continues smoothly through short line
+// segments. The planner accounts for the extra distance the jerk limit takes to stop and to slow
+// down to low junction speeds. 0 keeps the constant acceleration ramps. Not supported with
+// STEPPER_FIXED_POINT.
+// #define S_CURVE_ACCELERATION // Default disabled. Uncomment to enable.
+#define DEFAULT_JERK (0.0*60*60*60) // mm/min^3. 0 disables the jerk limit.
+
 // Adaptive Multi-Axis Step Smoothing (AMASS) is an advanced feature that does what its name implies,
 // smoothing the stepping of multi-axis motions. This feature smooths motion particularly at low step
 // frequencies below 10kHz, where the aliasing between axes of multi-axis motions can cause audible
@@ -438,6 +516,21 @@
 // greater than zero. This option does that.
 // #define SPINDLE_ENABLE_OFF_WITH_ZERO_SPEED // Default disabled. Uncomment to enable.
 
+// By default, every spindle and coolant change (M3/M4/M5, M7/M8/M9 and S words) empties the planner
+// buffer and brings the machine to a stop before it is set, so it happens exactly where programmed.
+// Jobs that change spindle speed or coolant often then stop at each change. With this option,
+// spindle speed changes, spindle stop and coolant changes are carried by the next motion block
+// instead, and set by the stepper as that block starts, with no stop. A change with no motion after
+// it is set once the planner buffer drains, like before. Spindle starts and reversals (M3/M4 with
+// the spindle off or turning the other way) still stop the machine, so it never cuts with a
+// stopped spindle. Speed changes follow as quickly as the spindle drive responds.
+// #define QUEUE_ACCESSORY_CHANGES // Default disabled. Uncomment to enable.
+
+// Dwells for the given time after a programmed spindle start or reversal, before any motion,
+// for spindles without a spin-up feedback signal. Not applied in laser mode. Programs can also
+// dwell with G4 after M3/M4, and Grbl does not check either.
+// #define SPINDLE_SPINUP_DELAY 2.0 // (seconds) Default disabled. Uncomment to enable.
+
 // With this enabled, Grbl sends back an echo of the line it has received, which has been pre-parsed (spaces
 // removed, capitalized letters, no comments) and is to be immediately executed by Grbl. Echoes will not be
 // sent upon a line buffer overflow, but should for all normal lines sent to Grbl. For example, if a user
@@ -467,6 +560,28 @@
 // bogged down by too many trig calculations.
 #define N_ARC_CORRECTION 12 // Integer (1-255)
 
+// Generates arc segments lazily. By default, mc_arc() queues every line segment of an arc before
+// the g-code parser moves on, waiting in mc_line() whenever the planner buffer is full. Large arcs
+// then stop Grbl from reading serial data until almost all of the arc is planned. With this
+// option, mc_arc() only queues the segments that fit, answers the line, and the main loop queues
+// the rest as the planner buffer drains. Following blocks with motion, G92, or a dwell, program
+// flow or spindle or coolant change that syncs the planner wait for the arc to be queued before
+// they execute. Feed rate and other modal changes don't. Either way the blocks are already
+// received, so the sender can keep the serial buffer full.
+// The arc state takes about 130 bytes of RAM, with 4 axes.
+// #define LAZY_ARC_GENERATION // Default disabled. Uncomment to enable.
+
+// Plans G2/G3 arcs as single planner blocks, instead of line segments sized by the arc tolerance
+// setting. The planner plans the velocity over the full arc length, limited by the centripetal
+// acceleration of the plane axes, and the step segment generator steps along the true arc. Arcs
+// then take one planner block each, which leaves the rest for look-ahead, and have no slowdowns at
+// segment junctions. The arc geometry is kept in PLAN_ARC_BUFFER_SIZE slots, 8 by default, of about
+// 60 bytes each with 4 axes. When they are all in use, the next arc waits like a full planner.
+// Arcs the planner can't hold as one block fall back to line segments. Not supported with COREXY.
+// NOTE: Each step segment of an arc computes a sin() and cos(), which adds to the segment
+// generator load at high step segment rates.
+// #define ARC_PLANNER_BLOCKS // Default disabled. Uncomment to enable.
+
 // The arc G2/3 g-code standard is problematic by definition. Radius-based arcs have horrible numerical
 // errors when arc at semi-circles(pi) or full-circles(2*pi). Offset-based arcs are much more accurate
 // but still have a problem when arcs are full-circles (2*pi). This define accounts for the floating
@@ -502,6 +617,17 @@
 // up with planning new incoming motions as they are executed.
 // #define BLOCK_BUFFER_SIZE 36  // Uncomment to override default in planner.h.
 
+// Packs planner blocks to fit more look-ahead into the same RAM. Step counts are kept in 24 bits
+// and direction bits in one byte. The acceleration, rapid rate and junction speed limits, which
+// never change once planned, are kept as 16-bit floats rounded down, about 0.8% at worst. The
+// programmed rate and spindle speed are kept in a small buffer of run headers, shared by all
+// consecutive blocks with the same values. The block buffer is then sized to fit the RAM budget
+// PLANNER_BLOCK_RAM, instead of by BLOCK_BUFFER_SIZE. The default budget is the RAM taken by 36
+// unpacked blocks, which holds about 60 packed blocks with 4 axes. Lines of more than 2^23 steps
+// are split into several blocks. Homing and parking motions may not exceed 2^24 steps.
+// #define PACKED_PLANNER_BLOCKS // Default disabled. Uncomment to enable.
+// #define PLANNER_BLOCK_RAM 2340 // Bytes. Uncomment to override default in planner.h.
+
 // Governs the size of the intermediary step segment buffer between the step execution algorithm
 // and the planner blocks. Each segment is set of steps executed at a constant velocity over a
 // fixed time defined by ACCELERATION_TICKS_PER_SECOND. They are computed such that the planner
@@ -530,6 +656,45 @@
 // #define RX_BUFFER_SIZE 255 // Uncomment to override defaults in serial.h
 // #define TX_BUFFER_SIZE 255
 
+// Renders status reports and 'ok'/'error:' responses into a RAM scratch buffer and commits each
+// to the serial TX buffer in one block copy, instead of writing every character through the TX
+// ring buffer and its interrupt enable. Shortens the main loop time taken by frequent '?' status
+// polls and by the responses to streamed lines. Other messages are written as before.
+// #define BATCH_REPORT_TX // Default disabled. Uncomment to enable.
+// #define TX_BATCH_SIZE 128 // Uncomment to override default in serial.h
+
+// Accepts g-code blocks as binary frames alongside ASCII lines. A frame carries pre-tokenized
+// words, each a letter and an integer value with its number of decimals, and a CRC-16. Grbl
+// executes it through the same g-code parser checks as the equivalent ASCII line and answers
+// with the usual 'ok' or 'error:'. Dense 3D surfacing programs need about half the bytes, and
+// Grbl skips the per-character line filtering and number parsing. Frame bytes that could be taken
+// for realtime commands or line ends are escaped, so realtime commands work mid-frame and a
+// truncated frame is cut short by the next line end or frame. A sender enables the frames with
+// '$B=1'. A reset turns them off. See doc/markdown/interface.md for the frame format.
+// #define ENABLE_BINARY_GCODE // Default disabled. Uncomment to enable.
+
+// Parses g-code lines in place in the serial receive buffer, instead of copying every character
+// into a separate line buffer first. Spaces and comments are filtered out and letters are made
+// uppercase in place, behind the characters still to be read, and the g-code parser reads the
+// line directly from the buffer, wrapping around its end. The line keeps its space in the
+// receive buffer until it has been executed. Streaming g-code then skips a copy of every line.
+// '$' system commands are executed in place as well, and startup lines and build info are read
+// in place from EEPROM, 16 bytes at a time with JOURNALED_SETTINGS. No line buffer is left, which
+// frees LINE_BUFFER_SIZE bytes of SRAM.
+// NOTE: Requires the default RX_BUFFER_SIZE of 255. A line must fit in the receive buffer, as
+// it does with a character-counting sender. Not supported with ENABLE_BINARY_GCODE or with
+// REPORT_ECHO_LINE_RECEIVED.
+// #define PARSE_LINES_IN_RX_BUFFER // Default disabled. Uncomment to enable.
+
+// Moves the filtering of received lines from the main loop into the serial RX interrupt. The
+// interrupt strips spaces and comments, upcases letters and frames each line as it arrives, then
+// publishes the complete line into the RX buffer behind a length byte. The main loop copies out
+// whole lines instead of filtering them a character at a time, which shortens the time between
+// its segment buffer refills while streaming. A filtered line takes no more buffer space than the
+// characters it was sent as, so character-counting senders work unchanged.
+// NOTE: Not supported with ENABLE_BINARY_GCODE or with PARSE_LINES_IN_RX_BUFFER.
+// #define ASSEMBLE_LINES_IN_RX_ISR // Default disabled. Uncomment to enable.
+
 // The maximum line length of a data string stored in EEPROM. Used by startup lines and build
 // info. This size differs from the LINE_BUFFER_SIZE as the EEPROM is usually limited in size.
 // NOTE: Be very careful when changing this value. Check EEPROM address locations to make sure
@@ -617,6 +782,50 @@
 // job. At this time, this option only forces a planner buffer sync with these g-code commands.
 #define FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE // Default enabled. Comment to disable.
 
+// Keeps the work coordinate systems (G54-G59) and the G28 and G30 positions in RAM, loaded from
+// EEPROM once at power-up. G10 L2/L20, G28.1 and G30.1 only change the RAM copy and flag it. The
+// main program writes changed data back to EEPROM one byte at a time, and only when the EEPROM has
+// finished the previous byte, so interrupts are never held off waiting for it. These commands then
+// no longer force a planner buffer sync, and a probing routine that sets a work offset mid-program
+// does not stop the machine. Coordinate system changes (G54-G59) never read the EEPROM.
+// NOTE: Changing the active coordinate system still syncs with FORCE_BUFFER_SYNC_DURING_WCO_CHANGE.
+// NOTE: A changed vector takes about 60ms to reach the EEPROM. Changes made less than that before
+// a power loss are lost. Uses 4*N_AXIS*8 bytes of RAM, 128 bytes with 4 axes.
+// #define CACHE_COORD_DATA // Default disabled. Uncomment to enable.
+
+// Writes the EEPROM from its ready interrupt instead of waiting for each byte with interrupts
+// disabled. EEPROM writes, like storing a whole '$' setting block, are copied into a queue and
+// return immediately, while the interrupt writes one byte every 3.4ms in the background. Stepping,
+// serial data and status reports continue meanwhile, and EEPROM writes from g-code (G10, G28.1,
+// G30.1) only force the planner buffer sync of FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE when the
+// queue is full. Reads of bytes still in the queue are answered from it. The queue size is set by
+// EEPROM_QUEUE_SIZE in eeprom.h.
+// NOTE: A write is only safe from power loss once the queue has emptied. A full settings block
+// takes about half a second. '$RST=' waits for it before replying and resetting, which takes
+// several seconds, so the EEPROM is written once its reply is received.
+// #define EEPROM_WRITE_QUEUE // Default disabled. Uncomment to enable.
+
+// Stores settings, coordinate data, startup lines and build info as a journal of records instead
+// of at fixed EEPROM addresses. Each record has a sequence number and a CRC-16. A change appends
+// only the bytes that differ, with a small header, so changing one '$' setting or one axis of a
+// work offset writes about a dozen bytes, spread over the whole EEPROM instead of wearing out the
+// same cells. When half the EEPROM is used, the latest records are copied to the other half, at
+// boot or when it fills up. A write torn by a power loss is discarded at the next boot, and the
+// previous value is kept. Works with EEPROM_WRITE_QUEUE.
+// NOTE: Enabling or disabling this option restores all EEPROM data to defaults, like a settings
+// version change. Not supported with CACHE_COORD_DATA.
+// #define JOURNALED_SETTINGS // Default disabled. Uncomment to enable.
+
+// Keeps a table of tool lengths and diameters for tools T1 to N_TOOL_TABLE in EEPROM, loaded into
+// RAM at power-up. G10 L1 Pn sets tool n, its tool length offset axis word the length and R the
+// radius. G43 Hn applies the length of tool n as the tool length offset, and G43 without H that of
+// the tool last selected with a T word. H0 or tool 0 applies no offset. G49 cancels it, as after
+// G43.1. The table is printed by '$#' and cleared by '$RST=#'. T words and G43 only read the RAM
+// copy, so they never wait on the EEPROM. G10 L1 writes the EEPROM like G10 L2.
+// NOTE: Changing a tool with G10 L1 does not change an offset already applied by G43.
+// #define TOOL_TABLE // Default disabled. Uncomment to enable.
+#define N_TOOL_TABLE 8 // Number of tools (1-31). Uses 8 bytes of RAM each.
+
 // In Grbl v0.9 and prior, there is an old outstanding bug where the `WPos:` work position reported
 // may not correlate to what is executing, because `WPos:` is based on the g-code parser state, which
 // can be several motions behind. This option forces the planner buffer to empty, sync, and stop
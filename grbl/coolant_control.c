@@ -71,7 +71,7 @@ void coolant_stop()
 // Main program only. Immediately sets flood coolant running state and also mist coolant, 
 // if enabled. Also sets a flag to report an update to a coolant state.
 // Called by coolant toggle override, parking restore, parking retract, sleep mode, g-code
-// parser program end, and g-code parser coolant_sync().
+// parser program end, and g-code parser coolant_sync() or coolant_queue().
 void coolant_set_state(uint8_t mode)
 {
   if (sys.abort) { return; } // Block during abort.  
@@ -111,3 +111,61 @@ void coolant_sync(uint8_t mode)
   protocol_buffer_synchronize(); // Ensure coolant turns on when specified in program.
   coolant_set_state(mode);
 }
+
+
+#ifdef QUEUE_ACCESSORY_CHANGES
+  static uint8_t coolant_queued; // Flags a queued coolant change not yet set by coolant_apply_queued().
+  static uint8_t coolant_queued_mode;
+
+  // G-code parser entry-point for coolant changes without a planner buffer sync. With nothing
+  // queued, the coolant is set immediately. Otherwise, the stepper sets it as the next motion
+  // block starts, or coolant_apply_queued() does once the planner buffer drains. The mode is the
+  // complete coolant state after the change.
+  void coolant_queue(uint8_t mode)
+  {
+    if (sys.state == STATE_CHECK_MODE) { return; }
+    if ((sys.state == STATE_IDLE) && (plan_get_current_block() == NULL)) {
+      coolant_queued = false;
+      coolant_set_state(mode);
+    } else {
+      coolant_queued = true;
+      coolant_queued_mode = mode;
+    }
+  }
+
+
+  // Sets a queued coolant state, if any. Called once the planner buffer has drained.
+  void coolant_apply_queued()
+  {
+    if (coolant_queued) {
+      coolant_queued = false;
+      coolant_set_state(coolant_queued_mode);
+    }
+  }
+
+
+  // Stepper ISR only. Sets the coolant outputs flagged in changed to their state in mode and leaves
+  // the others, so a coolant override toggle holds until the program changes that output.
+  void coolant_apply_change(uint8_t mode, uint8_t changed)
+  {
+    if (changed & COOLANT_FLOOD_ENABLE) {
+      #ifdef INVERT_COOLANT_FLOOD_PIN
+        if (mode & COOLANT_FLOOD_ENABLE) { COOLANT_FLOOD_PORT &= ~(1 << COOLANT_FLOOD_BIT); }
+        else { COOLANT_FLOOD_PORT |= (1 << COOLANT_FLOOD_BIT); }
+      #else
+        if (mode & COOLANT_FLOOD_ENABLE) { COOLANT_FLOOD_PORT |= (1 << COOLANT_FLOOD_BIT); }
+        else { COOLANT_FLOOD_PORT &= ~(1 << COOLANT_FLOOD_BIT); }
+      #endif
+    }
+    if (changed & COOLANT_MIST_ENABLE) {
+      #ifdef INVERT_COOLANT_MIST_PIN
+        if (mode & COOLANT_MIST_ENABLE) { COOLANT_MIST_PORT &= ~(1 << COOLANT_MIST_BIT); }
+        else { COOLANT_MIST_PORT |= (1 << COOLANT_MIST_BIT); }
+      #else
+        if (mode & COOLANT_MIST_ENABLE) { COOLANT_MIST_PORT |= (1 << COOLANT_MIST_BIT); }
+        else { COOLANT_MIST_PORT &= ~(1 << COOLANT_MIST_BIT); }
+      #endif
+    }
+    sys.report_ovr_counter = 0; // Set to report change immediately
+  }
+#endif
@@ -44,4 +44,15 @@ void coolant_set_state(uint8_t mode);
 // G-code parser entry-point for setting coolant states. Checks for and executes additional conditions.
 void coolant_sync(uint8_t mode);
 
+#ifdef QUEUE_ACCESSORY_CHANGES
+  // G-code parser coolant changes, set as the next motion block starts instead of by a buffer sync.
+  void coolant_queue(uint8_t mode);
+
+  // Sets the coolant state last queued by coolant_queue(). Called when the planner buffer drains.
+  void coolant_apply_queued();
+
+  // Sets only the changed coolant outputs. Called by the stepper ISR.
+  void coolant_apply_change(uint8_t mode, uint8_t changed);
+#endif
+
 #endif
@@ -213,6 +213,74 @@
   #define DIRECTION_PORT(i) _DIRECTION_PORT(i)
   #define DIRECTION_PIN(i) _PIN(DIRECTION_PORT_##i)
 
+  // Group the axes by the port of their step and direction pins. The stepper interrupt writes each
+  // group with a single read-modify-write of its port, instead of one per axis.
+  // NOTE: Keep these in sync with the step and direction ports above. Each axis must be in the
+  // group of its port, and the mask of a group must hold the pin bits of all axes in it.
+  #define STEP_GROUP_0 0 // X Step - Port F
+  #define STEP_GROUP_1 0 // Y Step - Port F
+  #define STEP_GROUP_2 1 // Z Step - Port L
+  #define STEP_GROUP_PORT_0 F
+  #define STEP_GROUP_PORT_1 L
+  #define STEP_GROUP_MASK_0 ((1<<STEP_BIT_0)|(1<<STEP_BIT_1))
+  #if N_AXIS > 5
+    #define STEP_GROUP_MASK_1 ((1<<STEP_BIT_2)|(1<<STEP_BIT_5))
+  #else
+    #define STEP_GROUP_MASK_1 (1<<STEP_BIT_2)
+  #endif
+  #if N_AXIS > 3
+    #define STEP_GROUP_3 2 // Axis number 4 Step - Port A
+    #define STEP_GROUP_PORT_2 A
+    #define STEP_GROUP_MASK_2 (1<<STEP_BIT_3)
+  #endif
+  #if N_AXIS > 4
+    #define STEP_GROUP_4 3 // Axis number 5 Step - Port C
+    #define STEP_GROUP_PORT_3 C
+    #define STEP_GROUP_MASK_3 (1<<STEP_BIT_4)
+  #endif
+  #if N_AXIS > 5
+    #define STEP_GROUP_5 1 // Axis number 6 Step - Port L, with Z
+    #define STEP_PORT_GROUPS 4
+  #else
+    #define STEP_PORT_GROUPS (N_AXIS-1)
+  #endif
+  #define _STEP_GROUP(i) STEP_GROUP_##i
+  #define STEP_GROUP(i) _STEP_GROUP(i)
+  #define _STEP_GROUP_PORT(g) _PORT(STEP_GROUP_PORT_##g)
+  #define STEP_GROUP_PORT(g) _STEP_GROUP_PORT(g)
+  #define _STEP_GROUP_MASK(g) STEP_GROUP_MASK_##g
+  #define STEP_GROUP_MASK(g) _STEP_GROUP_MASK(g)
+
+  #define DIRECTION_GROUP_0 0 // X Dir - Port F
+  #define DIRECTION_GROUP_1 0 // Y Dir - Port F
+  #define DIRECTION_GROUP_2 1 // Z Dir - Port L
+  #define DIRECTION_GROUP_PORT_0 F
+  #define DIRECTION_GROUP_PORT_1 L
+  #define DIRECTION_GROUP_MASK_0 ((1<<DIRECTION_BIT_0)|(1<<DIRECTION_BIT_1))
+  #define DIRECTION_GROUP_MASK_1 (1<<DIRECTION_BIT_2)
+  #if N_AXIS > 3
+    #define DIRECTION_GROUP_3 2 // Axis number 4 Dir - Port A
+    #define DIRECTION_GROUP_PORT_2 A
+    #define DIRECTION_GROUP_MASK_2 (1<<DIRECTION_BIT_3)
+  #endif
+  #if N_AXIS > 4
+    #define DIRECTION_GROUP_4 3 // Axis number 5 Dir - Port C
+    #define DIRECTION_GROUP_PORT_3 C
+    #define DIRECTION_GROUP_MASK_3 (1<<DIRECTION_BIT_4)
+  #endif
+  #if N_AXIS > 5
+    #define DIRECTION_GROUP_5 4 // Axis number 6 Dir - Port B
+    #define DIRECTION_GROUP_PORT_4 B
+    #define DIRECTION_GROUP_MASK_4 (1<<DIRECTION_BIT_5)
+  #endif
+  #define DIRECTION_PORT_GROUPS (N_AXIS-1)
+  #define _DIRECTION_GROUP(i) DIRECTION_GROUP_##i
+  #define DIRECTION_GROUP(i) _DIRECTION_GROUP(i)
+  #define _DIRECTION_GROUP_PORT(g) _PORT(DIRECTION_GROUP_PORT_##g)
+  #define DIRECTION_GROUP_PORT(g) _DIRECTION_GROUP_PORT(g)
+  #define _DIRECTION_GROUP_MASK(g) DIRECTION_GROUP_MASK_##g
+  #define DIRECTION_GROUP_MASK(g) _DIRECTION_GROUP_MASK(g)
+
   // Define stepper driver enable/disable output pin.
   #define STEPPER_DISABLE_PORT_0 D
   #define STEPPER_DISABLE_PORT_1 F
@@ -304,21 +372,34 @@
   #define MAX_LIMIT_PORT(i) _PORT(MAX_LIMIT_PORT_##i)
   #define MAX_LIMIT_PIN(i) _PIN(MAX_LIMIT_PORT_##i)
 
-  //  #define LIMIT_INT       PCIE0  // Pin change interrupt enable pin
-  //  #define LIMIT_INT_vect  PCINT0_vect
-  //  #define LIMIT_PCMSK     PCMSK0 // Pin change interrupt register
-  //  #define LIMIT_MASK ((1<<X_LIMIT_BIT)|(1<<Y_LIMIT_BIT)|(1<<Z_LIMIT_BIT)) // All limit bits
-  // Hardware limits interrupts are not implemented in the RAMPS version of grbl-Mega
-  // since all the limit switch ports are not compatible with interrupts.
-  #define DISABLE_HW_LIMITS_INTERRUPT
-
-  // Enable Hardware limit support for RAMPS without using interrupt...
-  // Warning! bouncing switches can cause a state check like this to misread the pin.
-  // When hard limits are triggered, they should be 100% reliable.
-  // The RAMPS_HW_LIMIT is implemented inside the stepper driver interrupt. Depending of your
-  // hardware, this can affect the max speed possibility of movments
-  // Disabled by default for performance optimization, uncomment to enable.
-  #define ENABLE_RAMPS_HW_LIMITS
+  // Hard limit interrupts. The Y limit pins (shared by the cloned axis 4) are pin change interrupts
+  // PCINT9 and PCINT10 on port J. The X and Z limit pins are the external interrupts INT4, INT5 and
+  // INT2, INT3, set to trigger on any logical change. All of them run the same hard limit routine.
+  #define LIMIT_INT       PCIE1  // Pin change interrupt enable pin
+  #define LIMIT_INT_vect  PCINT1_vect
+  #define LIMIT_PCMSK     PCMSK1 // Pin change interrupt register
+  #define LIMIT_MASK      ((1<<PCINT9)|(1<<PCINT10)) // Y limit bits, PJ0 and PJ1
+  #define LIMIT_EXT_INT_MASK  ((1<<INT2)|(1<<INT3)|(1<<INT4)|(1<<INT5)) // X and Z limit bits
+  #define LIMIT_EICRA_MASK    ((1<<ISC21)|(1<<ISC20)|(1<<ISC31)|(1<<ISC30)) // INT2 and INT3 sense bits
+  #define LIMIT_EICRA_CHANGE  ((1<<ISC20)|(1<<ISC30))
+  #define LIMIT_EICRB_MASK    ((1<<ISC41)|(1<<ISC40)|(1<<ISC51)|(1<<ISC50)) // INT4 and INT5 sense bits
+  #define LIMIT_EICRB_CHANGE  ((1<<ISC40)|(1<<ISC50))
+
+  // Polls the limit pins inside the stepper driver interrupt instead of using the limit interrupts.
+  // Warning! bouncing switches can cause a state check like this to misread the pin, and the
+  // polling costs time in every step interrupt, which can affect the max speed of movements.
+  // Disabled by default. Uncomment to enable.
+  // #define DISABLE_HW_LIMITS_INTERRUPT
+
+  // The axis 5 and 6 limit pins on ports L and F cannot raise an interrupt. With more than four
+  // axes, the stepper driver interrupt still polls these pins, starting from LIMIT_POLL_AXIS.
+  #ifdef DISABLE_HW_LIMITS_INTERRUPT
+    #define ENABLE_RAMPS_HW_LIMITS
+    #define LIMIT_POLL_AXIS 0
+  #elif N_AXIS > 4
+    #define ENABLE_RAMPS_HW_LIMITS
+    #define LIMIT_POLL_AXIS 4
+  #endif
 
   // Define spindle enable and spindle direction output pins.
   #define SPINDLE_ENABLE_DDR      DDRG
@@ -23,6 +23,7 @@
 ****************************************************************************/
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include "grbl.h"
 
 /* These EEPROM bits have different names on different devices. */
 #ifndef EEPE
@@ -46,6 +47,7 @@
  *  \param  addr  EEPROM address to read from.
  *  \return  The byte read from the EEPROM address.
  */
+#ifndef EEPROM_WRITE_QUEUE
 unsigned char eeprom_get_char( unsigned int addr )
 {
 	do {} while( EECR & (1<<EEPE) ); // Wait for completion of previous write.
@@ -53,6 +55,7 @@ unsigned char eeprom_get_char( unsigned int addr )
 	EECR = (1<<EERE); // Start EEPROM read operation.
 	return EEDR; // Return the byte read from EEPROM.
 }
+#endif
 
 /*! \brief  Write byte to EEPROM.
  *
@@ -71,14 +74,20 @@ unsigned char eeprom_get_char( unsigned int addr )
  *  \param  addr  EEPROM address to write to.
  *  \param  new_value  New EEPROM value.
  */
+#ifdef EEPROM_WRITE_QUEUE
+static void eeprom_program_char( unsigned int addr, unsigned char new_value )
+#else
 void eeprom_put_char( unsigned int addr, unsigned char new_value )
+#endif
 {
 	char old_value; // Old EEPROM value.
 	char diff_mask; // Difference mask, i.e. old value XOR new value.
 
+	#ifndef EEPROM_WRITE_QUEUE
 	cli(); // Ensure atomic operation for the write operation.
 	
 	do {} while( EECR & (1<<EEPE) ); // Wait for completion of previous write.
+	#endif
 	#ifndef EEPROM_IGNORE_SELFPROG
 	do {} while( SPMCSR & (1<<SELFPRGEN) ); // Wait for completion of SPM.
 	#endif
@@ -121,12 +130,147 @@ void eeprom_put_char( unsigned int addr, unsigned char new_value )
 		}
 	}
 	
+	#ifndef EEPROM_WRITE_QUEUE
 	sei(); // Restore interrupt flag state.
+	#endif
 }
 
 // Extensions added as part of Grbl 
 
 
+#ifdef EEPROM_WRITE_QUEUE
+  // Bytes waiting to be written, in order. Consecutive addresses are grouped into runs, so whole
+  // records written with memcpy_to_eeprom_with_checksum() take one run each.
+  static uint8_t eeprom_queue[EEPROM_QUEUE_SIZE];
+  static uint8_t eeprom_queue_head;
+  static volatile uint8_t eeprom_queue_tail;
+  static volatile uint8_t eeprom_queue_count;
+  static unsigned int eeprom_run_addr[EEPROM_QUEUE_RUNS]; // Next address of each run
+  static uint8_t eeprom_run_length[EEPROM_QUEUE_RUNS];    // Bytes left in each run
+  static uint8_t eeprom_run_head;
+  static uint8_t eeprom_run_tail;
+  static volatile uint8_t eeprom_run_count;
+
+
+  // Writes the next queued byte. The EEPROM must be ready.
+  static void eeprom_write_next()
+  {
+    if (!eeprom_run_count) { return; }
+    eeprom_program_char(eeprom_run_addr[eeprom_run_tail], eeprom_queue[eeprom_queue_tail]);
+    if (++eeprom_queue_tail == EEPROM_QUEUE_SIZE) { eeprom_queue_tail = 0; }
+    eeprom_queue_count--;
+    eeprom_run_addr[eeprom_run_tail]++;
+    if (--eeprom_run_length[eeprom_run_tail] == 0) {
+      if (++eeprom_run_tail == EEPROM_QUEUE_RUNS) { eeprom_run_tail = 0; }
+      eeprom_run_count--;
+    }
+    // Programming rewrites EECR and clears the interrupt enable. Set it again for the next byte.
+    if (eeprom_run_count) { EECR |= (1<<EERIE); }
+  }
+
+
+  // Called while waiting on the queue. With interrupts disabled, as during power-up, the EEPROM
+  // ready interrupt can't run, so the next byte is written from here.
+  static void eeprom_queue_poll(uint8_t sreg)
+  {
+    if (!(sreg & (1<<SREG_I)) && !(EECR & (1<<EEPE))) { eeprom_write_next(); }
+  }
+
+
+  // Queues a byte for the EEPROM ready interrupt to write, and returns. Waits only while the
+  // queue is full, with interrupts left as they were, so the interrupt can make room.
+  void eeprom_put_char( unsigned int addr, unsigned char new_value )
+  {
+    uint8_t sreg = SREG;
+    for (;;) {
+      while (eeprom_queue_count == EEPROM_QUEUE_SIZE) { eeprom_queue_poll(sreg); }
+      cli();
+      uint8_t last = (eeprom_run_head == 0) ? EEPROM_QUEUE_RUNS-1 : eeprom_run_head-1;
+      if (eeprom_run_count && (eeprom_run_addr[last]+eeprom_run_length[last] == addr) &&
+          (eeprom_run_length[last] < 255)) {
+        eeprom_run_length[last]++; // Extends the run the interrupt is working on, if it's the last.
+      } else if (eeprom_run_count < EEPROM_QUEUE_RUNS) {
+        eeprom_run_addr[eeprom_run_head] = addr;
+        eeprom_run_length[eeprom_run_head] = 1;
+        if (++eeprom_run_head == EEPROM_QUEUE_RUNS) { eeprom_run_head = 0; }
+        eeprom_run_count++;
+      } else {
+        SREG = sreg;
+        while (eeprom_run_count == EEPROM_QUEUE_RUNS) { eeprom_queue_poll(sreg); } // Out of runs.
+        continue;
+      }
+      eeprom_queue[eeprom_queue_head] = new_value;
+      if (++eeprom_queue_head == EEPROM_QUEUE_SIZE) { eeprom_queue_head = 0; }
+      eeprom_queue_count++;
+      EECR |= (1<<EERIE); // Interrupt once the EEPROM is ready for it.
+      sei(); // Leaves interrupts enabled, as the unqueued write always has.
+      return;
+    }
+  }
+
+
+  // Returns true while queued bytes remain to be written.
+  uint8_t eeprom_write_pending()
+  {
+    return(eeprom_run_count != 0);
+  }
+
+
+  // Reads a byte. A byte still waiting in the queue is read from there, newest write first, so
+  // reads never wait on the queue. Otherwise the ready interrupt is held off while the byte being
+  // programmed finishes, at most 3.4ms, and the EEPROM is read.
+  unsigned char eeprom_get_char( unsigned int addr )
+  {
+    uint8_t sreg = SREG;
+    uint8_t found = false;
+    uint8_t value = 0;
+    cli();
+    uint16_t index = eeprom_queue_tail; // Queue index of the next byte of each run
+    uint8_t run = eeprom_run_tail;
+    uint8_t n;
+    for (n = eeprom_run_count; n > 0; n--) {
+      if ((addr >= eeprom_run_addr[run]) && (addr - eeprom_run_addr[run] < eeprom_run_length[run])) {
+        uint16_t i = index + (addr - eeprom_run_addr[run]);
+        if (i >= EEPROM_QUEUE_SIZE) { i -= EEPROM_QUEUE_SIZE; }
+        value = eeprom_queue[i];
+        found = true;
+      }
+      index += eeprom_run_length[run];
+      if (index >= EEPROM_QUEUE_SIZE) { index -= EEPROM_QUEUE_SIZE; }
+      if (++run == EEPROM_QUEUE_RUNS) { run = 0; }
+    }
+    if (!found) {
+      EECR &= ~(1<<EERIE);
+      SREG = sreg;
+      do {} while (EECR & (1<<EEPE)); // Wait for completion of previous write.
+      cli();
+      EEAR = addr;
+      EECR |= (1<<EERE);
+      value = EEDR;
+      if (eeprom_run_count) { EECR |= (1<<EERIE); }
+    }
+    SREG = sreg;
+    return(value);
+  }
+
+
+  // Returns the number of bytes that can be queued without waiting, as a new run.
+  uint8_t eeprom_queue_available()
+  {
+    if (eeprom_run_count == EEPROM_QUEUE_RUNS) { return(0); }
+    return(EEPROM_QUEUE_SIZE - eeprom_queue_count);
+  }
+
+
+  // Writes the next queued byte each time the EEPROM finishes the last. Unchanged bytes start no
+  // programming, so the interrupt fires again right away.
+  ISR(EE_READY_vect)
+  {
+    eeprom_write_next();
+  }
+#endif
+
+
 void memcpy_to_eeprom_with_checksum(unsigned int destination, char *source, unsigned int size) {
   unsigned char checksum = 0;
   for(; size > 0; size--) { 
@@ -143,7 +287,7 @@ int memcpy_from_eeprom_with_checksum(char *destination, unsigned int source, uns
     data = eeprom_get_char(source++);
     checksum = (checksum << 1) || (checksum >> 7);
     checksum += data;    
-    *(destination++) = data; 
+    if (destination) { *(destination++) = data; } // NULL only verifies the checksum.
   }
   return(checksum == eeprom_get_char(source));
 }
@@ -21,6 +21,19 @@
 #ifndef eeprom_h
 #define eeprom_h
 
+#ifdef EEPROM_WRITE_QUEUE
+  // Size of the EEPROM write queue in bytes, and the most separate address runs it holds.
+  #ifndef EEPROM_QUEUE_SIZE
+    #define EEPROM_QUEUE_SIZE 160 // (1-255)
+  #endif
+  #ifndef EEPROM_QUEUE_RUNS
+    #define EEPROM_QUEUE_RUNS 8
+  #endif
+
+  uint8_t eeprom_write_pending();
+  uint8_t eeprom_queue_available();
+#endif
+
 unsigned char eeprom_get_char(unsigned int addr);
 void eeprom_put_char(unsigned int addr, unsigned char new_value);
 void memcpy_to_eeprom_with_checksum(unsigned int destination, char *source, unsigned int size);
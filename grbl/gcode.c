@@ -64,7 +64,13 @@ void gc_sync_position()
 // characters have been removed. In this function, all units and positions are converted and
 // exported to grbl's internal functions in terms of (mm, mm/min) and absolute machine
 // coordinates, respectively.
-uint8_t gc_execute_line(char *line)
+uint8_t gc_execute_line(char *line) { return(gc_execute_line_at(line, 0)); }
+
+
+// Executes the line starting at line[line_start]. The line is indexed with a uint8_t, so a line
+// parsed in place in the serial RX buffer may wrap around its end. With PARSE_LINES_IN_RX_BUFFER,
+// a NULL line executes the stored line opened by settings_read_startup_line() in place.
+uint8_t gc_execute_line_at(char *line, uint8_t line_start)
 {
   /* -------------------------------------------------------------------------------------
      STEP 1: Initialize parser block struct and copy current g-code state modes. The parser
@@ -90,6 +96,9 @@ uint8_t gc_execute_line(char *line)
   uint8_t axis_v_mask = 0;
   uint8_t axis_w_mask = 0;
   uint8_t coord_select = 0; // Tracks G10 P coordinate selection for execution
+  #ifdef TOOL_TABLE
+    tool_data_t tool_data; // Tracks G10 L1 tool table entry for execution
+  #endif
 
   // Initialize bitflag tracking variables for axis indices compatible operations.
   uint32_t axis_dwords = 0; // XYZ tracking
@@ -101,7 +110,7 @@ uint8_t gc_execute_line(char *line)
   uint8_t gc_parser_flags = GC_PARSER_NONE;
 
   // Determine if the line is a jogging motion or a normal g-code block.
-  if (line[0] == '$') { // NOTE: `$J=` already parsed when passed to this function.
+  if (line_get_char(line, line_start) == '$') { // NOTE: `$J=` already parsed when passed to this function.
     // Set G1 and G94 enforced modes to ensure accurate error checks.
     gc_parser_flags |= GC_PARSER_JOG_MOTION;
     gc_block.modal.motion = MOTION_MODE_LINEAR;
@@ -121,16 +130,28 @@ uint8_t gc_execute_line(char *line)
   float value;
   uint8_t int_value = 0;
   uint16_t mantissa = 0;
-  if (gc_parser_flags & GC_PARSER_JOG_MOTION) { char_counter = 3; } // Start parsing after `$J=`
-  else { char_counter = 0; }
+  if (gc_parser_flags & GC_PARSER_JOG_MOTION) { char_counter = line_start+3; } // Start parsing after `$J=`
+  #ifdef ENABLE_BINARY_GCODE
+    else if (line[line_start] == SERIAL_FRAME_START) { char_counter = line_start+2; } // Start parsing after frame start and length
+  #endif
+  else { char_counter = line_start; }
 
-  while (line[char_counter] != 0) { // Loop until no more g-code words in line.
+  while (line_get_char(line, char_counter) != 0) { // Loop until no more g-code words in line.
 
     // Import the next g-code word, expecting a letter followed by a value. Otherwise, error out.
-    letter = line[char_counter];
+    #ifdef ENABLE_BINARY_GCODE
+      if (line[line_start] == SERIAL_FRAME_START) { // Binary frame word. Value is already tokenized.
+        if (!read_frame_word(line, &char_counter, &letter, &value)) { FAIL(STATUS_BAD_NUMBER_FORMAT); }
+        if((letter < 'A') || (letter > 'Z')) { FAIL(STATUS_EXPECTED_COMMAND_LETTER); }
+      } else {
+    #endif
+    letter = line_get_char(line, char_counter);
     if((letter < 'A') || (letter > 'Z')) { FAIL(STATUS_EXPECTED_COMMAND_LETTER); } // [Expected word letter]
     char_counter++;
     if (!read_float(line, &char_counter, &value)) { FAIL(STATUS_BAD_NUMBER_FORMAT); } // [Expected word value]
+    #ifdef ENABLE_BINARY_GCODE
+      }
+    #endif
 
     // Convert values to smaller uint8 significand and mantissa values for parsing this word.
     // NOTE: Mantissa is multiplied by 100 to catch non-integer command values. This is more
@@ -227,6 +248,10 @@ uint8_t gc_execute_line(char *line)
               gc_block.modal.tool_length = TOOL_LENGTH_OFFSET_CANCEL;
             } else if (mantissa == 10) { // G43.1
               gc_block.modal.tool_length = TOOL_LENGTH_OFFSET_ENABLE_DYNAMIC;
+            #ifdef TOOL_TABLE
+            } else if (mantissa == 0) { // G43
+              gc_block.modal.tool_length = TOOL_LENGTH_OFFSET_ENABLE_TABLE;
+            #endif
             } else { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [Unsupported G43.x command]
             mantissa = 0; // Set to zero to indicate valid non-integer G command.
             break;
@@ -302,7 +327,14 @@ uint8_t gc_execute_line(char *line)
         switch(letter){
           // case 'D': // Not supported
           case 'F': dword_bit = DWORD_F; gc_block.values.f = value; break;
-          // case 'H': // Not supported
+          #ifdef TOOL_TABLE
+            case 'H': dword_bit = DWORD_H;
+              if (value > MAX_TOOL_NUMBER) { FAIL(STATUS_GCODE_MAX_VALUE_EXCEEDED); }
+              gc_block.values.h = int_value;
+              break;
+          #else
+            // case 'H': // Not supported
+          #endif
           case 'I':
             dword_bit = DWORD_I;
             if (AXIS_1_NAME == 'X') { gc_block.values.ijk[AXIS_1] = value; ijk_words |= (1<<AXIS_1); }
@@ -405,9 +437,9 @@ uint8_t gc_execute_line(char *line)
 
         // NOTE: Variable 'dword_bit' is always assigned, if the non-command letter is valid.
         if (bit_istrue(value_dwords,dwbit(dword_bit))) { FAIL(STATUS_GCODE_WORD_REPEATED); } // [Word repeated]
-        // Check for invalid negative values for words F, N, P, T, and S.
+        // Check for invalid negative values for words F, H, N, P, T, and S.
         // NOTE: Negative value check is done here simply for code-efficiency.
-        if ( dwbit(dword_bit) & (dwbit(DWORD_F)|dwbit(DWORD_N)|dwbit(DWORD_P)|dwbit(DWORD_T)|dwbit(DWORD_S)) ) {
+        if ( dwbit(dword_bit) & (dwbit(DWORD_F)|dwbit(DWORD_H)|dwbit(DWORD_N)|dwbit(DWORD_P)|dwbit(DWORD_T)|dwbit(DWORD_S)) ) {
           if (value < 0.0) { FAIL(STATUS_NEGATIVE_VALUE); } // [Word value cannot be negative]
         }
         value_dwords |= dwbit(dword_bit); // Flag to indicate parameter assigned.
@@ -511,6 +543,10 @@ uint8_t gc_execute_line(char *line)
   // bit_false(value_dwords,dwbit(DWORD_S)); // NOTE: Single-meaning value word. Set at end of error-checking.
 
   // [5. Select tool ]: NOT SUPPORTED. Only tracks value. T is negative (done.) Not an integer. Greater than max tool value.
+  #ifdef TOOL_TABLE
+    // The tool stays selected until the next T word, for G43 without an H word.
+    if (bit_isfalse(value_dwords,dwbit(DWORD_T))) { gc_block.values.t = gc_state.tool; }
+  #endif
   // bit_false(value_dwords,dwbit(DWORD_T)); // NOTE: Single-meaning value word. Set at end of error-checking.
 
   // [6. Change tool ]: N/A
@@ -732,7 +768,7 @@ uint8_t gc_execute_line(char *line)
   //   NOTE: Since cutter radius compensation is never enabled, these G40 errors don't apply. Grbl supports G40
   //   only for the purpose to not error when G40 is sent with a g-code program header to setup the default modes.
 
-  // [14. Cutter length compensation ]: G43 NOT SUPPORTED, but G43.1 and G49 are.
+  // [14. Cutter length compensation ]: G43 NOT SUPPORTED, but G43.1 and G49 are. G43 with TOOL_TABLE.
   // [G43.1 Errors]: Motion command in same line.
   //   NOTE: Although not explicitly stated so, G43.1 should be applied to only one valid
   //   axis that is configured (in config.h). There should be an error if the configured axis
@@ -741,6 +777,24 @@ uint8_t gc_execute_line(char *line)
     if (gc_block.modal.tool_length == TOOL_LENGTH_OFFSET_ENABLE_DYNAMIC) {
       if (axis_dwords ^ (1<<TOOL_LENGTH_OFFSET_AXIS)) { FAIL(STATUS_GCODE_G43_DYNAMIC_AXIS_ERROR); }
     }
+    #ifdef TOOL_TABLE
+      // [G43 Errors]: Axis words present. H, or the selected tool without H, greater than N_TOOL_TABLE.
+      //   NOTE: The offset is loaded from the RAM copy of the tool table into the block XYZ value.
+      if (gc_block.modal.tool_length == TOOL_LENGTH_OFFSET_ENABLE_TABLE) {
+        if (axis_dwords) { FAIL(STATUS_GCODE_AXIS_WORDS_EXIST); } // [No axis words allowed]
+        uint8_t tool = gc_block.values.t;
+        if (bit_istrue(value_dwords,dwbit(DWORD_H))) {
+          tool = gc_block.values.h;
+          bit_false(value_dwords,dwbit(DWORD_H));
+        }
+        if (tool > N_TOOL_TABLE) { FAIL(STATUS_GCODE_MAX_VALUE_EXCEEDED); } // [Not in tool table]
+        gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS] = 0.0; // Tool 0 is no tool.
+        if (tool) {
+          settings_read_tool_data(tool,&tool_data);
+          gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS] = tool_data.length;
+        }
+      }
+    #endif
   }
 
   // [15. Coordinate system selection ]: *N/A. Error, if cutter radius comp is active.
@@ -748,6 +802,7 @@ uint8_t gc_execute_line(char *line)
   // is active. The read pauses the processor temporarily and may cause a rare crash. For
   // future versions on processors with enough memory, all coordinate data should be stored
   // in memory and written to EEPROM only when there is not a cycle active.
+  // NOTE: The CACHE_COORD_DATA option holds it in memory and writes it back in the background.
   float block_coord_system[N_AXIS];
   memcpy(block_coord_system,gc_state.coord_system,sizeof(gc_state.coord_system));
   if ( bit_istrue(command_dwords,bit(MODAL_GROUP_G12)) ) { // Check if called in block
@@ -768,6 +823,26 @@ uint8_t gc_execute_line(char *line)
   // all the current coordinate system and G92 offsets.
   switch (gc_block.non_modal_command) {
     case NON_MODAL_SET_COORDINATE_DATA:
+      #ifdef TOOL_TABLE
+        // [G10 L1 Errors]: P word missing. P not 1 to N_TOOL_TABLE. Axis word other than the tool
+        //   length offset axis. Neither it nor R present. Sets the tool number in coord_select.
+        if (gc_block.values.l == 1) {
+          if (bit_isfalse(value_dwords,dwbit(DWORD_P))) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [P word missing]
+          if ((gc_block.values.p < 1.0) || (gc_block.values.p >= N_TOOL_TABLE+1)) { FAIL(STATUS_GCODE_MAX_VALUE_EXCEEDED); } // [Not in tool table]
+          if (axis_dwords & ~bit(TOOL_LENGTH_OFFSET_AXIS)) { FAIL(STATUS_GCODE_AXIS_WORDS_EXIST); } // [Other axis words]
+          if (!axis_dwords && bit_isfalse(value_dwords,dwbit(DWORD_R))) { FAIL(STATUS_GCODE_NO_AXIS_WORDS); } // [Nothing to set]
+          coord_select = trunc(gc_block.values.p);
+          settings_read_tool_data(coord_select,&tool_data);
+          if (axis_dwords) { tool_data.length = gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS]; }
+          if (bit_istrue(value_dwords,dwbit(DWORD_R))) {
+            if (gc_block.modal.units == UNITS_MODE_INCHES) { gc_block.values.r *= MM_PER_INCH; }
+            tool_data.diameter = 2.0*gc_block.values.r;
+          }
+          bit_false(value_dwords,(dwbit(DWORD_L)|dwbit(DWORD_P)|dwbit(DWORD_R)));
+          if (settings_check_tool_write()) { FAIL(STATUS_SETTING_WRITE_FAIL); } // [EEPROM full]
+          break;
+        }
+      #endif
       // [G10 Errors]: L missing and is not 2 or 20. P word missing. (Negative P value done.)
       // [G10 L2 Errors]: R word NOT SUPPORTED. P value not 0 to nCoordSys(max 9). Axis words missing.
       // [G10 L20 Errors]: P must be 0 to nCoordSys(max 9). Axis words missing.
@@ -788,6 +863,7 @@ uint8_t gc_execute_line(char *line)
 
       // NOTE: Store parameter data in IJK values. By rule, they are not in use with this command.
       if (!settings_read_coord_data(coord_select,gc_block.values.ijk)) { FAIL(STATUS_SETTING_READ_FAIL); } // [EEPROM read fail]
+      if (settings_check_coord_write()) { FAIL(STATUS_SETTING_WRITE_FAIL); } // [EEPROM full]
 
       // Pre-calculate the coordinate data changes.
       for (idx=0; idx<N_AXIS; idx++) { // Axes indices are consistent, so loop may be used.
@@ -873,8 +949,9 @@ uint8_t gc_execute_line(char *line)
           break;
         case NON_MODAL_SET_HOME_0: // G28.1
         case NON_MODAL_SET_HOME_1: // G30.1
-          // [G28.1/30.1 Errors]: Cutter compensation is enabled.
+          // [G28.1/30.1 Errors]: Cutter compensation is enabled. EEPROM full.
           // NOTE: If axis words are passed here, they are interpreted as an implicit motion mode.
+          if (settings_check_coord_write()) { FAIL(STATUS_SETTING_WRITE_FAIL); } // [EEPROM full]
           break;
         case NON_MODAL_RESET_COORDINATE_OFFSET:
           // NOTE: If axis words are passed here, they are interpreted as an implicit motion mode.
@@ -1178,6 +1255,18 @@ uint8_t gc_execute_line(char *line)
      need to update the state and execute the block according to the order-of-execution.
   */
 
+  #ifdef LAZY_ARC_GENERATION
+    // Queue the rest of a pending arc, if this block queues motion after it. Other blocks, like
+    // feed rate or modal changes, leave it pending. Dwells, program flow and spindle and coolant
+    // syncs queue it in protocol_buffer_synchronize().
+    if ((axis_command == AXIS_COMMAND_MOTION_MODE) || (gc_parser_flags & GC_PARSER_JOG_MOTION) ||
+        (gc_block.non_modal_command == NON_MODAL_GO_HOME_0) || (gc_block.non_modal_command == NON_MODAL_GO_HOME_1) ||
+        (gc_block.non_modal_command == NON_MODAL_SET_COORDINATE_OFFSET)) {
+      mc_arc_synchronize();
+      if (sys.abort) { return(STATUS_OK); }
+    }
+  #endif
+
   // Initialize planner data struct for motion blocks.
   plan_line_data_t plan_data;
   plan_line_data_t *pl_data = &plan_data;
@@ -1252,9 +1341,15 @@ uint8_t gc_execute_line(char *line)
   if ((gc_state.spindle_speed != gc_block.values.s) || bit_istrue(gc_parser_flags,GC_PARSER_LASER_FORCE_SYNC)) {
     if (gc_state.modal.spindle != SPINDLE_DISABLE) {
       if (bit_isfalse(gc_parser_flags,GC_PARSER_LASER_ISMOTION)) {
-        if (bit_istrue(gc_parser_flags,GC_PARSER_LASER_DISABLE)) {
-           spindle_sync(gc_state.modal.spindle, 0.0);
-        } else { spindle_sync(gc_state.modal.spindle, gc_block.values.s); }
+        #ifdef QUEUE_ACCESSORY_CHANGES
+          if (bit_istrue(gc_parser_flags,GC_PARSER_LASER_DISABLE)) {
+             spindle_queue(gc_state.modal.spindle, 0.0);
+          } else { spindle_queue(gc_state.modal.spindle, gc_block.values.s); }
+        #else
+          if (bit_istrue(gc_parser_flags,GC_PARSER_LASER_DISABLE)) {
+             spindle_sync(gc_state.modal.spindle, 0.0);
+          } else { spindle_sync(gc_state.modal.spindle, gc_block.values.s); }
+        #endif
       }
     }
     gc_state.spindle_speed = gc_block.values.s; // Update spindle speed state.
@@ -1274,7 +1369,20 @@ uint8_t gc_execute_line(char *line)
     // Update spindle control and apply spindle speed when enabling it in this block.
     // NOTE: All spindle state changes are synced, even in laser mode. Also, pl_data,
     // rather than gc_state, is used to manage laser state for non-laser motions.
-    spindle_sync(gc_block.modal.spindle, pl_data->spindle_speed);
+    #ifdef QUEUE_ACCESSORY_CHANGES
+      // Spindle stop rides along with the next motion. Starts and reversals still sync, so no
+      // motion runs before the spindle does.
+      if (gc_block.modal.spindle == SPINDLE_DISABLE) { spindle_queue(SPINDLE_DISABLE, pl_data->spindle_speed); }
+      else { spindle_sync(gc_block.modal.spindle, pl_data->spindle_speed); }
+    #else
+      spindle_sync(gc_block.modal.spindle, pl_data->spindle_speed);
+    #endif
+    #ifdef SPINDLE_SPINUP_DELAY
+      // Dwell for the spindle to reach speed. Lasers need none.
+      if ((gc_block.modal.spindle != SPINDLE_DISABLE) && bit_isfalse(settings.flags,BITFLAG_LASER_MODE)) {
+        mc_dwell(SPINDLE_SPINUP_DELAY);
+      }
+    #endif
     gc_state.modal.spindle = gc_block.modal.spindle;
   }
   pl_data->condition |= gc_state.modal.spindle; // Set condition flag for planner use.
@@ -1283,9 +1391,14 @@ uint8_t gc_execute_line(char *line)
   if (gc_state.modal.coolant != gc_block.modal.coolant) {
     // NOTE: Coolant M-codes are modal. Only one command per line is allowed. But, multiple states
     // can exist at the same time, while coolant disable clears all states.
-    coolant_sync(gc_block.modal.coolant);
+    #ifndef QUEUE_ACCESSORY_CHANGES
+      coolant_sync(gc_block.modal.coolant);
+    #endif
     if (gc_block.modal.coolant == COOLANT_DISABLE) { gc_state.modal.coolant = COOLANT_DISABLE; }
     else { gc_state.modal.coolant |= gc_block.modal.coolant; }
+    #ifdef QUEUE_ACCESSORY_CHANGES
+      coolant_queue(gc_state.modal.coolant);
+    #endif
   }
   pl_data->condition |= gc_state.modal.coolant; // Set condition flag for planner use.
 
@@ -1309,7 +1422,7 @@ uint8_t gc_execute_line(char *line)
   // [13. Cutter radius compensation ]: G41/42 NOT SUPPORTED
   // gc_state.modal.cutter_comp = gc_block.modal.cutter_comp; // NOTE: Not needed since always disabled.
 
-  // [14. Cutter length compensation ]: G43.1 and G49 supported. G43 NOT SUPPORTED.
+  // [14. Cutter length compensation ]: G43.1 and G49 supported. G43 NOT SUPPORTED, except with TOOL_TABLE.
   // NOTE: If G43 were supported, its operation wouldn't be any different from G43.1 in terms
   // of execution. The error-checking step would simply load the offset value into the correct
   // axis of the block XYZ value array.
@@ -1317,7 +1430,7 @@ uint8_t gc_execute_line(char *line)
     gc_state.modal.tool_length = gc_block.modal.tool_length;
     if (gc_state.modal.tool_length == TOOL_LENGTH_OFFSET_CANCEL) { // G49
       gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS] = 0.0;
-    } // else G43.1
+    } // else G43.1, or G43 with its offset loaded by the error-checking step
     if ( gc_state.tool_length_offset != gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS] ) {
       gc_state.tool_length_offset = gc_block.values.xyz[TOOL_LENGTH_OFFSET_AXIS];
       system_flag_wco_change();
@@ -1342,6 +1455,12 @@ uint8_t gc_execute_line(char *line)
   // [19. Go to predefined position, Set G10, or Set axis offsets ]:
   switch(gc_block.non_modal_command) {
     case NON_MODAL_SET_COORDINATE_DATA:
+      #ifdef TOOL_TABLE
+        if (gc_block.values.l == 1) {
+          settings_write_tool_data(coord_select,&tool_data);
+          break;
+        }
+      #endif
       settings_write_coord_data(coord_select,gc_block.values.ijk);
       // Update system coordinate system if currently active.
       if (gc_state.modal.coord_select == coord_select) {
@@ -123,6 +123,7 @@
 // Modal Group G8: Tool length offset
 #define TOOL_LENGTH_OFFSET_CANCEL 0 // G49 (Default: Must be zero)
 #define TOOL_LENGTH_OFFSET_ENABLE_DYNAMIC 1 // G43.1
+#define TOOL_LENGTH_OFFSET_ENABLE_TABLE 2 // G43 (TOOL_TABLE)
 
 // Modal Group M9: Override control
 #ifdef DEACTIVATE_PARKING_UPON_INIT
@@ -157,6 +158,7 @@
 #define DWORD_U 16
 #define DWORD_V 17
 #define DWORD_W 18
+#define DWORD_H 19
 
 // Define g-code parser position updating flags
 #define GC_UPDATE_POS_TARGET   0 // Must be zero
@@ -195,7 +197,7 @@ typedef struct {
   // uint8_t distance_arc; // {G91.1} NOTE: Don't track. Only default supported.
   uint8_t plane_select;    // {G17,G18,G19}
   // uint8_t cutter_comp;  // {G40} NOTE: Don't track. Only default supported.
-  uint8_t tool_length;     // {G43.1,G49}
+  uint8_t tool_length;     // {G43,G43.1,G49}
   uint8_t coord_select;    // {G54,G55,G56,G57,G58,G59}
   // uint8_t control;      // {G61} NOTE: Don't track. Only default supported.
   uint8_t program_flow;    // {M0,M1,M2,M30}
@@ -211,6 +213,9 @@ typedef struct {
 #else
   float ijk[3];    // I,J,K Axis arc offsets
 #endif
+  #ifdef TOOL_TABLE
+    uint8_t h;     // Tool length offset index
+  #endif
   uint8_t l;       // G10 or canned cycles parameters
   int32_t n;       // Line number
   float p;         // G10 or dwell parameters
@@ -231,7 +236,7 @@ typedef struct {
 
   float spindle_speed;          // RPM
   float feed_rate;              // Millimeters/min
-  uint8_t tool;                 // Tracks tool number. NOT USED.
+  uint8_t tool;                 // Tracks tool number. Only used by G43 with TOOL_TABLE.
   int32_t line_number;          // Last line number sent
 
   float position[N_AXIS];       // Where the interpreter considers the tool to be at this point in the code
@@ -258,6 +263,9 @@ void gc_init();
 // Execute one block of rs275/ngc/g-code
 uint8_t gc_execute_line(char *line);
 
+// Execute one block of g-code starting at line[line_start], such as a line in the serial RX buffer
+uint8_t gc_execute_line_at(char *line, uint8_t line_start);
+
 // Set g-code parser position. Input in steps.
 void gc_sync_position();
 
@@ -32,6 +32,7 @@
 #include <avr/interrupt.h>
 #include <avr/wdt.h>
 #include <util/delay.h>
+#include <util/crc16.h>
 #include <math.h>
 #include <inttypes.h>
 #include <string.h>
@@ -49,6 +50,7 @@
 #include "planner.h"
 #include "coolant_control.h"
 #include "eeprom.h"
+#include "journal.h"
 #include "gcode.h"
 #include "limits.h"
 #include "motion_control.h"
@@ -62,6 +64,7 @@
 #include "stepper.h"
 #include "jog.h"
 #include "sleep.h"
+#include "push.h"
 
 // ---------------------------------------------------------------------------------------
 // COMPILE-TIME ERROR CHECKING OF DEFINE VALUES:
@@ -88,6 +91,47 @@
   #endif
 #endif
 
+#if defined(PARSE_LINES_IN_RX_BUFFER)
+  #if (RX_BUFFER_SIZE != 255)
+    #error "PARSE_LINES_IN_RX_BUFFER requires an RX_BUFFER_SIZE of 255."
+  #endif
+  #if defined(ENABLE_BINARY_GCODE) || defined(REPORT_ECHO_LINE_RECEIVED)
+    #error "PARSE_LINES_IN_RX_BUFFER is not supported with ENABLE_BINARY_GCODE or REPORT_ECHO_LINE_RECEIVED."
+  #endif
+#endif
+
+#if defined(ASSEMBLE_LINES_IN_RX_ISR) && (defined(ENABLE_BINARY_GCODE) || defined(PARSE_LINES_IN_RX_BUFFER))
+  #error "ASSEMBLE_LINES_IN_RX_ISR is not supported with ENABLE_BINARY_GCODE or PARSE_LINES_IN_RX_BUFFER."
+#endif
+
+#if defined(BATCH_REPORT_TX) && ((TX_BATCH_SIZE > TX_BUFFER_SIZE) || (TX_BATCH_SIZE > 255) || (TX_BUFFER_SIZE > 255))
+  #error "TX_BATCH_SIZE must not exceed TX_BUFFER_SIZE, and neither may exceed 255."
+#endif
+
+#if defined(S_CURVE_ACCELERATION) && defined(STEPPER_FIXED_POINT)
+  #error "S_CURVE_ACCELERATION is not supported with STEPPER_FIXED_POINT."
+#endif
+
+#if defined(STEPPER_TRACE) && defined(STEPPER_ISR_PROFILE)
+  #error "STEPPER_TRACE and STEPPER_ISR_PROFILE both use Timer5 and can't be enabled together."
+#endif
+
+#if defined(REPORT_FIELD_SEGMENT_BUFFER_STATS) && !defined(SEGMENT_BUFFER_STATS)
+  #error "REPORT_FIELD_SEGMENT_BUFFER_STATS requires SEGMENT_BUFFER_STATS."
+#endif
+
+#if defined(ADAPTIVE_SEGMENT_TIME) && ((CRUISE_SEGMENT_TICKS < 2) || (CRUISE_SEGMENT_TICKS > 255) || (CRUISE_SEGMENT_TICKS > SEGMENT_BUFFER_TICKS))
+  #error "CRUISE_SEGMENT_TICKS must be 2-255 and no more than SEGMENT_BUFFER_TICKS."
+#endif
+
+#if defined(JOURNALED_SETTINGS) && defined(CACHE_COORD_DATA)
+  #error "CACHE_COORD_DATA is not supported with JOURNALED_SETTINGS."
+#endif
+
+#if defined(TOOL_TABLE) && ((N_TOOL_TABLE < 1) || (N_TOOL_TABLE > 31))
+  #error "N_TOOL_TABLE must be 1-31."
+#endif
+
 #if (REPORT_WCO_REFRESH_BUSY_COUNT < REPORT_WCO_REFRESH_IDLE_COUNT)
   #error "WCO busy refresh is less than idle refresh."
 #endif
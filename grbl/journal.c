@@ -0,0 +1,313 @@
+/*
+  journal.c - Wear-levelled record store in EEPROM
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+#ifdef JOURNALED_SETTINGS
+
+#if JOURNAL_N_RECORDS > 16
+  #error "JOURNALED_SETTINGS supports up to 16 record ids."
+#endif
+
+#define JOURNAL_CHUNK_SIZE 16 // Bytes compared or copied at a time, on the stack.
+
+static uint16_t journal_index[JOURNAL_N_RECORDS]; // Address of the latest full record. Zero if none.
+static uint16_t journal_patched; // Bit per id with patch records after its latest full record.
+static uint16_t journal_base;    // Address of the active bank
+static uint16_t journal_end;     // Address the next record is appended at
+static uint16_t journal_seq;     // Sequence number of the last record written
+
+static uint16_t journal_addr;    // Next address and running CRC of the record being written
+static uint16_t journal_crc;
+
+
+static uint16_t journal_get_word(uint16_t addr)
+{
+  return(eeprom_get_char(addr) | (eeprom_get_char(addr+1) << 8));
+}
+
+
+static void journal_put(uint8_t value)
+{
+  journal_crc = _crc_xmodem_update(journal_crc, value);
+  eeprom_put_char(journal_addr++, value);
+}
+
+
+// Writes a record header at addr. The payload follows with journal_put() and journal_finish().
+static void journal_begin(uint16_t addr, uint8_t id, uint8_t length, uint16_t seq)
+{
+  journal_addr = addr;
+  journal_crc = 0xFFFF;
+  journal_put(id);
+  journal_put(length);
+  journal_put(seq & 0xFF);
+  journal_put(seq >> 8);
+}
+
+
+// Writes the CRC of the record. Returns the address following it.
+static uint16_t journal_finish()
+{
+  uint16_t crc = journal_crc;
+  eeprom_put_char(journal_addr++, crc & 0xFF);
+  eeprom_put_char(journal_addr++, crc >> 8);
+  return(journal_addr);
+}
+
+
+// Returns true if the CRC of the record at addr matches its contents.
+static uint8_t journal_check(uint16_t addr)
+{
+  uint16_t crc = 0xFFFF;
+  uint16_t end = addr + (JOURNAL_RECORD_OVERHEAD-2) + eeprom_get_char(addr+1);
+  for (; addr < end; addr++) { crc = _crc_xmodem_update(crc, eeprom_get_char(addr)); }
+  return(crc == journal_get_word(addr));
+}
+
+
+// Returns true if the bank at base has a valid header of this settings version.
+static uint8_t journal_bank_valid(uint16_t base, uint16_t *seq)
+{
+  if (eeprom_get_char(base) != JOURNAL_ID_BANK) { return(false); }
+  if (eeprom_get_char(base+1) != 1) { return(false); }
+  if (eeprom_get_char(base+4) != SETTINGS_VERSION) { return(false); }
+  if (!journal_check(base)) { return(false); }
+  *seq = journal_get_word(base+2);
+  return(true);
+}
+
+
+// Copies n bytes from offset of the latest record of an id, applying any patches after it.
+static void journal_load(uint8_t id, uint8_t offset, char *data, uint8_t n)
+{
+  uint16_t addr = journal_index[id];
+  uint8_t i;
+  for (i=0; i<n; i++) { data[i] = eeprom_get_char(addr+4+offset+i); }
+  if (!(journal_patched & bit(id))) { return; }
+  addr += JOURNAL_RECORD_OVERHEAD + eeprom_get_char(addr+1);
+  while (addr < journal_end) {
+    uint8_t length = eeprom_get_char(addr+1);
+    if (eeprom_get_char(addr) == (id | JOURNAL_ID_PATCH)) {
+      // Patch payload: offset, then the changed bytes. Copy where it overlaps the range read.
+      uint16_t start = eeprom_get_char(addr+4);
+      uint16_t lo = max(start, offset);
+      uint16_t hi = min(start+length-1, offset+n);
+      for (; lo < hi; lo++) { data[lo-offset] = eeprom_get_char(addr+5+(lo-start)); }
+    }
+    addr += JOURNAL_RECORD_OVERHEAD + length;
+  }
+}
+
+
+// Copies the latest records of all ids to the other bank, merging their patches. Its header is
+// invalidated first and written last, so a power loss meanwhile leaves the old bank active.
+static void journal_compact()
+{
+  uint16_t base = (journal_base ? 0 : JOURNAL_BANK_SIZE);
+  eeprom_put_char(base, JOURNAL_ID_END);
+  uint16_t bank_seq = ++journal_seq; // Older than the records copied after it
+  uint16_t addr = base + JOURNAL_RECORD_OVERHEAD + 1;
+  char chunk[JOURNAL_CHUNK_SIZE];
+  uint8_t id;
+  for (id=0; id<JOURNAL_N_RECORDS; id++) {
+    if (!journal_index[id]) { continue; }
+    uint8_t length = eeprom_get_char(journal_index[id]+1);
+    journal_begin(addr, id, length, ++journal_seq);
+    uint8_t offset, n, i;
+    for (offset=0; offset<length; offset+=n) {
+      n = min(JOURNAL_CHUNK_SIZE, length-offset);
+      journal_load(id, offset, chunk, n);
+      for (i=0; i<n; i++) { journal_put(chunk[i]); }
+    }
+    journal_index[id] = addr;
+    addr = journal_finish();
+  }
+  eeprom_put_char(addr, JOURNAL_ID_END);
+  journal_begin(base, JOURNAL_ID_BANK, 1, bank_seq);
+  journal_put(SETTINGS_VERSION);
+  journal_finish();
+  journal_base = base;
+  journal_end = addr;
+  journal_patched = 0;
+}
+
+
+// Makes room to append size bytes and an end marker. Returns false if they don't fit even in a
+// freshly compacted bank.
+static uint8_t journal_reserve(uint16_t size)
+{
+  if (journal_end + size + 1 <= journal_base + JOURNAL_BANK_SIZE) { return(true); }
+  journal_compact();
+  return(journal_end + size + 1 <= journal_base + JOURNAL_BANK_SIZE);
+}
+
+
+// Starts an empty bank 0, discarding all records.
+static void journal_format()
+{
+  uint16_t addr = JOURNAL_RECORD_OVERHEAD + 1;
+  eeprom_put_char(addr, JOURNAL_ID_END); // Before the header, so no stale record follows it.
+  journal_begin(0, JOURNAL_ID_BANK, 1, ++journal_seq);
+  journal_put(SETTINGS_VERSION);
+  journal_finish();
+  journal_base = 0;
+  journal_end = addr;
+}
+
+
+void journal_init()
+{
+  uint16_t seq_0 = 0, seq_1 = 0;
+  uint8_t valid_0 = journal_bank_valid(0, &seq_0);
+  uint8_t valid_1 = journal_bank_valid(JOURNAL_BANK_SIZE, &seq_1);
+  memset(journal_index, 0, sizeof(journal_index));
+  journal_patched = 0;
+  if (valid_1 && (!valid_0 || (int16_t)(seq_1-seq_0) > 0)) {
+    journal_base = JOURNAL_BANK_SIZE;
+    journal_seq = seq_1;
+  } else if (valid_0) {
+    journal_base = 0;
+    journal_seq = seq_0;
+  } else {
+    journal_format();
+    return;
+  }
+
+  // Index records up to the end marker, or the first one torn by a power loss. Every record
+  // has a newer sequence number than the one before it.
+  uint16_t addr = journal_base + JOURNAL_RECORD_OVERHEAD + 1;
+  while (addr + JOURNAL_RECORD_OVERHEAD <= journal_base + JOURNAL_BANK_SIZE) {
+    uint8_t id = eeprom_get_char(addr);
+    if (id == JOURNAL_ID_END) { break; }
+    uint8_t length = eeprom_get_char(addr+1);
+    if (addr + JOURNAL_RECORD_OVERHEAD + length > journal_base + JOURNAL_BANK_SIZE) { break; }
+    uint16_t seq = journal_get_word(addr+2);
+    if ((int16_t)(seq-journal_seq) <= 0) { break; }
+    if (!journal_check(addr)) { break; }
+    journal_seq = seq;
+    if (id & JOURNAL_ID_PATCH) {
+      id &= ~JOURNAL_ID_PATCH;
+      if ((id < JOURNAL_N_RECORDS) && journal_index[id]) { journal_patched |= bit(id); }
+    } else if (id < JOURNAL_N_RECORDS) {
+      journal_index[id] = addr;
+      journal_patched &= ~bit(id);
+    }
+    addr += JOURNAL_RECORD_OVERHEAD + length;
+  }
+  journal_end = addr;
+
+  if (journal_end - journal_base > JOURNAL_BANK_SIZE/2) { journal_compact(); }
+}
+
+
+int16_t journal_read(uint8_t id, char *data, uint16_t size)
+{
+  if (!journal_index[id]) { return(-1); }
+  uint8_t length = eeprom_get_char(journal_index[id]+1);
+  uint8_t n = min(length, size);
+  journal_load(id, 0, data, n);
+  memset(data+n, 0, size-n);
+  return(length);
+}
+
+
+int16_t journal_read_at(uint8_t id, uint8_t offset, char *data, uint8_t size)
+{
+  int16_t length = -1;
+  uint8_t n = 0;
+  if (journal_index[id]) {
+    length = eeprom_get_char(journal_index[id]+1);
+    if (offset < length) { n = min(length-offset, size); }
+    journal_load(id, offset, data, n);
+  }
+  memset(data+n, 0, size-n);
+  return(length);
+}
+
+
+uint8_t journal_write(uint8_t id, char *data, uint8_t length) { return(journal_write_at(id, data, 0, length)); }
+
+
+uint8_t journal_write_at(uint8_t id, char *data, uint8_t start, uint8_t length)
+{
+  if (journal_index[id] && (eeprom_get_char(journal_index[id]+1) == length)) {
+    // Find the span of changed bytes.
+    char chunk[JOURNAL_CHUNK_SIZE];
+    uint8_t first = length, last = 0;
+    uint8_t offset, n, i;
+    for (offset=0; offset<length; offset+=n) {
+      n = min(JOURNAL_CHUNK_SIZE, length-offset);
+      journal_load(id, offset, chunk, n);
+      for (i=0; i<n; i++) {
+        if (chunk[i] != data[(uint8_t)(start+offset+i)]) {
+          if (first == length) { first = offset+i; }
+          last = offset+i+1;
+        }
+      }
+    }
+    if (first == length) { return(STATUS_OK); } // Unchanged
+    if (1+(last-first) < length) {
+      if (!journal_reserve(JOURNAL_RECORD_OVERHEAD+1+(last-first))) { return(STATUS_SETTING_WRITE_FAIL); }
+      journal_begin(journal_end, id | JOURNAL_ID_PATCH, 1+(last-first), ++journal_seq);
+      journal_put(first);
+      for (; first<last; first++) { journal_put(data[(uint8_t)(start+first)]); }
+      journal_end = journal_finish();
+      eeprom_put_char(journal_end, JOURNAL_ID_END);
+      journal_patched |= bit(id);
+      return(STATUS_OK);
+    }
+  }
+  if (!journal_reserve(JOURNAL_RECORD_OVERHEAD+length)) { return(STATUS_SETTING_WRITE_FAIL); }
+  journal_index[id] = journal_end;
+  journal_patched &= ~bit(id);
+  journal_begin(journal_end, id, length, ++journal_seq);
+  uint8_t i;
+  for (i=0; i<length; i++) { journal_put(data[(uint8_t)(start+i)]); }
+  journal_end = journal_finish();
+  eeprom_put_char(journal_end, JOURNAL_ID_END);
+  return(STATUS_OK);
+}
+
+
+uint8_t journal_write_check(uint8_t length)
+{
+  uint16_t size = JOURNAL_RECORD_OVERHEAD + length;
+  if (journal_end + size + 1 <= journal_base + JOURNAL_BANK_SIZE) { return(STATUS_OK); }
+  // End of the record in a compacted bank, as journal_reserve() would leave it.
+  uint16_t end = JOURNAL_RECORD_OVERHEAD + 1 + size;
+  uint8_t id;
+  for (id=0; id<JOURNAL_N_RECORDS; id++) {
+    if (journal_index[id]) { end += JOURNAL_RECORD_OVERHEAD + eeprom_get_char(journal_index[id]+1); }
+  }
+  if (end + 1 <= JOURNAL_BANK_SIZE) { return(STATUS_OK); }
+  return(STATUS_SETTING_WRITE_FAIL);
+}
+
+
+uint8_t journal_write_fits(uint8_t length)
+{
+  uint16_t size = JOURNAL_RECORD_OVERHEAD + length + 1;
+  if (journal_end + size > journal_base + JOURNAL_BANK_SIZE) { return(false); }
+  #ifdef EEPROM_WRITE_QUEUE
+    if (eeprom_queue_available() < size) { return(false); }
+  #endif
+  return(true);
+}
+
+#endif
@@ -0,0 +1,67 @@
+/*
+  journal.h - Wear-levelled record store in EEPROM
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef journal_h
+#define journal_h
+
+#include "grbl.h"
+
+// The EEPROM is split into two banks. Records are appended to the active bank, which is copied to
+// the other one, keeping only the latest record of each id, when it fills up.
+#ifndef JOURNAL_EEPROM_SIZE
+  #define JOURNAL_EEPROM_SIZE (E2END+1UL)
+#endif
+#define JOURNAL_BANK_SIZE (JOURNAL_EEPROM_SIZE/2)
+
+// Record: id, payload length, 16-bit sequence number, payload and CRC-16 of all preceding bytes.
+#define JOURNAL_RECORD_OVERHEAD 6
+#define JOURNAL_ID_BANK   0xFE // Bank header. Its payload is the SETTINGS_VERSION.
+#define JOURNAL_ID_END    0xFF // Erased EEPROM. Written after the last record.
+#define JOURNAL_ID_PATCH  0x80 // Flags a record holding an offset and changed bytes of a record id.
+
+
+// Finds the active bank and indexes its records. Formats an empty bank if there is none, or if it
+// was written with another SETTINGS_VERSION. Compacts the bank if it is more than half full.
+void journal_init();
+
+// Copies the latest record of an id, with any patches since, zero-filling the rest of the size
+// bytes. Returns the record length, or -1 if there is none.
+int16_t journal_read(uint8_t id, char *data, uint16_t size);
+
+// Copies size bytes from offset of the latest record of an id, like journal_read(). Bytes past
+// the end of the record, or of a missing one, read as zero.
+int16_t journal_read_at(uint8_t id, uint8_t offset, char *data, uint8_t size);
+
+// Appends a record, or only the changed bytes if its length is unchanged. Nothing is written if
+// it is identical to the stored record. Returns STATUS_SETTING_WRITE_FAIL, writing nothing, if
+// the record doesn't fit even in a compacted bank.
+uint8_t journal_write(uint8_t id, char *data, uint8_t length);
+
+// Appends a record like journal_write(), from data[start]. Its index wraps around at 256, like a
+// line parsed in place in the serial RX buffer.
+uint8_t journal_write_at(uint8_t id, char *data, uint8_t start, uint8_t length);
+
+// Returns STATUS_SETTING_WRITE_FAIL if journal_write() could fail to store a record of the given
+// length, checking room for all of it, not only a patch.
+uint8_t journal_write_check(uint8_t length);
+
+// Returns true if a record of the given length can be appended without compacting the bank, or
+// waiting on the EEPROM_WRITE_QUEUE.
+uint8_t journal_write_fits(uint8_t length);
+
+#endif
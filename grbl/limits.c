@@ -111,9 +111,14 @@ void limits_init()
       #endif
     #endif
     #ifndef DISABLE_HW_LIMITS_INTERRUPT
+      // Trigger the external interrupts on any logical change, like a pin change interrupt.
+      EICRA = (EICRA & ~LIMIT_EICRA_MASK) | LIMIT_EICRA_CHANGE;
+      EICRB = (EICRB & ~LIMIT_EICRB_MASK) | LIMIT_EICRB_CHANGE;
       if (bit_istrue(settings.flags,BITFLAG_HARD_LIMIT_ENABLE)) {
         LIMIT_PCMSK |= LIMIT_MASK; // Enable specific pins of the Pin Change Interrupt
         PCICR |= (1 << LIMIT_INT); // Enable Pin Change Interrupt
+        EIFR = LIMIT_EXT_INT_MASK; // Clear any change flagged while the interrupts were disabled
+        EIMSK |= LIMIT_EXT_INT_MASK; // Enable External Interrupts
       } else {
         limits_disable();
       }
@@ -155,6 +160,7 @@ void limits_disable()
     #ifndef DISABLE_HW_LIMITS_INTERRUPT
       LIMIT_PCMSK &= ~LIMIT_MASK;  // Disable specific pins of the Pin Change Interrupt
       PCICR &= ~(1 << LIMIT_INT);  // Disable Pin Change Interrupt
+      EIMSK &= ~LIMIT_EXT_INT_MASK;  // Disable External Interrupts
     #endif
   #else
     LIMIT_PCMSK &= ~LIMIT_MASK;  // Disable specific pins of the Pin Change Interrupt
@@ -183,14 +189,10 @@ void limits_disable()
     static const uint8_t max_limit_bits[N_AXIS] = {MAX_LIMIT_BIT(0), MAX_LIMIT_BIT(1), MAX_LIMIT_BIT(2)};
     static const uint8_t min_limit_bits[N_AXIS] = {MIN_LIMIT_BIT(0), MIN_LIMIT_BIT(1), MIN_LIMIT_BIT(2)};
   #endif
-#endif // DEFAULTS_RAMPS_BOARD
 
-// Returns limit state as a bit-wise uint8 variable. Each bit indicates an axis limit, where
-// triggered is 1 and not triggered is 0. Invert mask is applied. Axes are defined by their
-// number in bit position, i.e. AXIS_3 is (1<<2) or bit 2, and AXIS_2 is (1<<1) or bit 1.
-uint8_t limits_get_state()
-{
-  #ifdef DEFAULTS_RAMPS_BOARD
+  // Returns the limit state of the axes from first_axis up, as limits_get_state().
+  static uint8_t limits_get_axes_state(uint8_t first_axis)
+  {
     uint8_t limit_state_max = 0;
     uint8_t limit_state_min = 0;
     uint8_t pin;
@@ -198,7 +200,7 @@ uint8_t limits_get_state()
     #ifdef INVERT_LIMIT_PIN_MASK
       #error "INVERT_LIMIT_PIN_MASK is not implemented, use INVERT_<MAX|MIN>_LIMIT_PIN_MASK"
     #endif
-    for (idx=0; idx<N_AXIS; idx++) {
+    for (idx=first_axis; idx<N_AXIS; idx++) {
       pin = *max_limit_pins[idx] & (1<<max_limit_bits[idx]);
       pin = !!pin;
       pin = !pin;
@@ -219,10 +221,30 @@ uint8_t limits_get_state()
       }
     }
     if (bit_istrue(settings.flags,BITFLAG_INVERT_LIMIT_PINS)) {
-      return(~(limit_state_max & limit_state_min));
+      // Masked to the axes read here, which a partial read by the stepper interrupt relies on.
+      return(~(limit_state_max & limit_state_min) & (uint8_t)((1<<N_AXIS)-(1<<first_axis)));
     } else {
       return(limit_state_max | limit_state_min);
     }
+  }
+
+
+  #ifdef ENABLE_RAMPS_HW_LIMITS
+    // Returns the limit state of the axes polled by the stepper driver interrupt.
+    uint8_t limits_get_polled_state()
+    {
+      return(limits_get_axes_state(LIMIT_POLL_AXIS));
+    }
+  #endif
+#endif // DEFAULTS_RAMPS_BOARD
+
+// Returns limit state as a bit-wise uint8 variable. Each bit indicates an axis limit, where
+// triggered is 1 and not triggered is 0. Invert mask is applied. Axes are defined by their
+// number in bit position, i.e. AXIS_3 is (1<<2) or bit 2, and AXIS_2 is (1<<1) or bit 1.
+uint8_t limits_get_state()
+{
+  #ifdef DEFAULTS_RAMPS_BOARD
+    return(limits_get_axes_state(0));
   #else //ifdef DEFAULTS_RAMPS_BOARD
     uint8_t limit_state = 0;
     uint8_t pin = (LIMIT_PIN & LIMIT_MASK);
@@ -241,34 +263,50 @@ uint8_t limits_get_state()
 }
 
 #ifdef DEFAULTS_RAMPS_BOARD
-  #ifndef DISABLE_HW_LIMITS_INTERRUPT
-    #error "HW limits interrupts are not implemented"
-  #endif
-  #ifdef ENABLE_RAMPS_HW_LIMITS
-    void ramps_hard_limit()
-    {
-      if (bit_istrue(settings.flags,BITFLAG_HARD_LIMIT_ENABLE)) {
-        // Ignore limit switches if already in an alarm state or in-process of executing an alarm.
-        // When in the alarm state, Grbl should have been reset or will force a reset, so any pending
-        // moves in the planner and serial buffers are all cleared and newly sent blocks will be
-        // locked out until a homing cycle or a kill lock command. Allows the user to disable the hard
-        // limit setting if their limits are constantly triggering after a reset and move their axes.
-        if ((sys.state != STATE_ALARM) && (sys.state != STATE_HOMING)) {
-          if (!(sys_rt_exec_alarm)) {
-            #ifdef HARD_LIMIT_FORCE_STATE_CHECK
-              // Check limit pin state.
-              if (limits_get_state()) {
-                mc_reset(); // Initiate system kill.
-                system_set_exec_alarm(EXEC_ALARM_HARD_LIMIT); // Indicate hard limit critical event
-              }
-            #else
+  // Hard limit routine of the RAMPS board, run by the limit interrupts or by the stepper driver
+  // interrupt polling the limit pins. See the limit pin change interrupt below for the rationale.
+  void ramps_hard_limit()
+  {
+    if (bit_istrue(settings.flags,BITFLAG_HARD_LIMIT_ENABLE)) {
+      // Ignore limit switches if already in an alarm state or in-process of executing an alarm.
+      // When in the alarm state, Grbl should have been reset or will force a reset, so any pending
+      // moves in the planner and serial buffers are all cleared and newly sent blocks will be
+      // locked out until a homing cycle or a kill lock command. Allows the user to disable the hard
+      // limit setting if their limits are constantly triggering after a reset and move their axes.
+      if ((sys.state != STATE_ALARM) && (sys.state != STATE_HOMING)) {
+        if (!(sys_rt_exec_alarm)) {
+          #ifdef HARD_LIMIT_FORCE_STATE_CHECK
+            // Check limit pin state.
+            if (limits_get_state()) {
               mc_reset(); // Initiate system kill.
               system_set_exec_alarm(EXEC_ALARM_HARD_LIMIT); // Indicate hard limit critical event
-            #endif
-          }
+            }
+          #else
+            mc_reset(); // Initiate system kill.
+            system_set_exec_alarm(EXEC_ALARM_HARD_LIMIT); // Indicate hard limit critical event
+          #endif
         }
       }
     }
+  }
+
+  #ifndef DISABLE_HW_LIMITS_INTERRUPT
+    // The Y limit pin change interrupt and the X and Z limit external interrupts share one vector.
+    #ifndef ENABLE_SOFTWARE_DEBOUNCE
+      ISR(LIMIT_INT_vect) { ramps_hard_limit(); }
+    #else // OPTIONAL: Software debounce limit pin routine.
+      // Upon limit pin change, enable watchdog timer to create a short delay.
+      ISR(LIMIT_INT_vect) { if (!(WDTCSR & (1<<WDIE))) { WDTCSR |= (1<<WDIE); } }
+      ISR(WDT_vect) // Watchdog timer ISR
+      {
+        WDTCSR &= ~(1<<WDIE); // Disable watchdog timer.
+        if (limits_get_state()) { ramps_hard_limit(); } // Check limit pin state.
+      }
+    #endif
+    ISR(INT2_vect, ISR_ALIASOF(LIMIT_INT_vect));
+    ISR(INT3_vect, ISR_ALIASOF(LIMIT_INT_vect));
+    ISR(INT4_vect, ISR_ALIASOF(LIMIT_INT_vect));
+    ISR(INT5_vect, ISR_ALIASOF(LIMIT_INT_vect));
   #endif
 #else // DEFAULTS_RAMPS_BOARD
 // This is the Limit Pin Change Interrupt, which handles the hard limit feature. A bouncing
@@ -338,6 +376,21 @@ uint8_t limits_get_state()
 
     return res;
   }
+
+
+  // Sets the homing axis lock of each step port group from the step pins of the unlocked axes.
+  // Each group is written in one byte, so the stepper ISR never sees a partly updated group.
+  static void homing_axis_lock_update(uint8_t *axislock)
+  {
+    uint8_t lock[STEP_PORT_GROUPS];
+    uint8_t idx;
+
+    memset(lock, 0, sizeof(lock));
+    for (idx = 0; idx < N_AXIS; idx++)
+      lock[get_step_port_group(idx)] |= axislock[idx];
+    for (idx = 0; idx < STEP_PORT_GROUPS; idx++)
+      sys.homing_axis_lock[idx] = lock[idx];
+  }
 #endif // DEFAULTS_RAMPS_BOARD
 
 
@@ -420,10 +473,10 @@ void limits_go_home(uint8_t cycle_mask)
           }
           // Apply axislock to the step port pins active in this cycle.
           axislock[idx] = step_pin[idx];
-          sys.homing_axis_lock[idx] = axislock[idx];
         }
 
       }
+      homing_axis_lock_update(axislock);
       homing_rate *= sqrt(n_active_axis); // [sqrt(N_AXIS)] Adjust so individual axes all move at homing rate.
 
 
@@ -458,8 +511,8 @@ void limits_go_home(uint8_t cycle_mask)
                 #endif
               }
             }
-            sys.homing_axis_lock[idx] = axislock[idx];
           }
+          homing_axis_lock_update(axislock);
         }
 
         st_prep_buffer(); // Check and prep segment buffer. NOTE: Should take no longer than 200us.
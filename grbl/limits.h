@@ -41,5 +41,8 @@ void limits_soft_check(float *target);
 // Hard limit error for RAMPS non interrupt hardware limits
 #ifdef ENABLE_RAMPS_HW_LIMITS
   void ramps_hard_limit();
+
+  // Returns the limit state of the RAMPS limit pins polled by the stepper driver interrupt
+  uint8_t limits_get_polled_state();
 #endif
 #endif
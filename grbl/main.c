@@ -44,6 +44,9 @@ unsigned char axis_name[N_AXIS]; // Global table of axis names
 #ifdef DEBUG
   volatile uint8_t sys_rt_exec_debug;
 #endif
+#ifdef ENABLE_BINARY_STATUS_REPORT
+  volatile uint8_t sys_rt_exec_status_frame;
+#endif
 #ifdef SORT_REPORT_BY_AXIS_NAME
   uint8_t n_axis_report;
 #endif
@@ -406,16 +409,28 @@ int main(void)
     sys_rt_exec_alarm = 0;
     sys_rt_exec_motion_override = 0;
     sys_rt_exec_accessory_override = 0;
+    #ifdef ENABLE_BINARY_STATUS_REPORT
+      sys_rt_exec_status_frame = false;
+    #endif
 
     // Reset Grbl primary systems.
     serial_reset_read_buffer(); // Clear serial read buffer
+    #ifdef ENABLE_BINARY_GCODE
+      serial_enable_binary_frames(false); // Back to ASCII. Senders re-enable frames after a reset.
+    #endif
     gc_init(); // Set g-code parser to default state
     spindle_init();
     coolant_init();
     limits_init();
     probe_init();
     sleep_init();
+    #ifdef ENABLE_POSITION_PUSH
+      push_init(); // Pushing stops. Hosts re-enable it after a reset.
+    #endif
     plan_reset(); // Clear block buffer and planner variables
+    #ifdef LAZY_ARC_GENERATION
+      mc_arc_reset(); // Discard any pending arc.
+    #endif
     st_reset(); // Clear stepper subsystem variables.
 
     // Sync cleared gcode and planner positions to current system position.
@@ -42,6 +42,31 @@ void mc_line(float *target, plan_line_data_t *pl_data)
   // If in check gcode mode, prevent motion by blocking planner. Soft limits still work.
   if (sys.state == STATE_CHECK_MODE) { return; }
 
+  #ifdef PACKED_PLANNER_BLOCKS
+    // Split lines with more steps than a packed planner block holds into equal collinear lines.
+    // Half the limit leaves room for CoreXY motors, which add up the steps of both axes.
+    float position[N_AXIS];
+    plan_get_planner_mpos(position);
+    float max_steps = 0.0;
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) {
+      position[idx] = target[idx]-position[idx]; // Line travel
+      max_steps = max(max_steps, fabs(position[idx])*settings.steps_per_mm[idx]);
+    }
+    if (max_steps > PLAN_BLOCK_MAX_STEPS/2) {
+      uint16_t segments = ceil(max_steps/(PLAN_BLOCK_MAX_STEPS/2));
+      // Inverse time feed rates apply to each line. See mc_arc().
+      if (pl_data->condition & PL_COND_FLAG_INVERSE_TIME) { pl_data->feed_rate *= segments; }
+      uint16_t i;
+      for (i=segments-1; i>0; i--) {
+        float segment_target[N_AXIS];
+        for (idx=0; idx<N_AXIS; idx++) { segment_target[idx] = target[idx]-position[idx]*i/segments; }
+        mc_line(segment_target, pl_data);
+        if (sys.abort) { return; }
+      }
+    }
+  #endif
+
   // NOTE: Backlash compensation may be installed here. It will need direction info to track when
   // to insert a backlash line motion(s) before the intended line motion and will require its own
   // plan_check_full_buffer() and check for system abort loop. Also for position reporting
@@ -78,6 +103,154 @@ void mc_line(float *target, plan_line_data_t *pl_data)
 }
 
 
+// Arc generator state. Holds everything needed to resume an arc at its next line segment.
+typedef struct {
+  float position[N_AXIS];    // End point of the last line segment
+  float target[N_AXIS];      // Arc end point
+  float increment[N_AXIS];   // Helical and other linear axis travel per segment
+  plan_line_data_t pl_data;  // Planner data of all segments
+  float center_axis0;        // Circle center in the arc plane
+  float center_axis1;
+  float offset_axis0;        // Offset from the arc start point to the circle center
+  float offset_axis1;
+  float r_axis0;             // Radius vector from center to the last segment end point
+  float r_axis1;
+  float theta_per_segment;
+  float cos_T;               // Small angle approximations of the rotation per segment
+  float sin_T;
+  uint16_t segment;          // Number of line segments queued. The arc is complete when equal to segments.
+  uint16_t segments;         // Number of line segments. The last one ends at the target.
+  uint8_t count;             // Segments since the last exact arc correction
+  uint8_t axis_0_mask;       // Axes set from the radius vector, including cloned axes
+  uint8_t axis_1_mask;
+} arc_generator_t;
+
+#ifdef LAZY_ARC_GENERATION
+  static arc_generator_t arc; // Pending arc, pulled by the main loop as planner space frees up.
+#endif
+
+
+// Computes the end point of the next arc line segment into arc->position and advances the arc.
+static void mc_arc_next_segment(arc_generator_t *arc)
+{
+  uint8_t idx;
+  arc->segment++;
+  if (arc->segment == arc->segments) {
+    // Ensure last segment arrives at target location.
+    memcpy(arc->position, arc->target, sizeof(arc->target));
+  } else {
+    if (arc->count < N_ARC_CORRECTION) {
+      // Apply vector rotation matrix. ~40 usec
+      float r_axisi = arc->r_axis0*arc->sin_T + arc->r_axis1*arc->cos_T;
+      arc->r_axis0 = arc->r_axis0*arc->cos_T - arc->r_axis1*arc->sin_T;
+      arc->r_axis1 = r_axisi;
+      arc->count++;
+    } else {
+      // Arc correction to radius vector. Computed only every N_ARC_CORRECTION increments. ~375 usec
+      // Compute exact location by applying transformation matrix from initial radius vector(=-offset).
+      float cos_Ti = cos(arc->segment*arc->theta_per_segment);
+      float sin_Ti = sin(arc->segment*arc->theta_per_segment);
+      arc->r_axis0 = -arc->offset_axis0*cos_Ti + arc->offset_axis1*sin_Ti;
+      arc->r_axis1 = -arc->offset_axis0*sin_Ti - arc->offset_axis1*cos_Ti;
+      arc->count = 0;
+    }
+
+    // Update arc_target location. Cloned axes follow the axis they are cloned from.
+    for (idx=0; idx<N_AXIS; idx++) {
+      if (bit_istrue(arc->axis_0_mask,bit(idx))) { arc->position[idx] = arc->center_axis0 + arc->r_axis0; }
+      if (bit_istrue(arc->axis_1_mask,bit(idx))) { arc->position[idx] = arc->center_axis1 + arc->r_axis1; }
+      arc->position[idx] += arc->increment[idx];
+    }
+  }
+}
+
+
+#ifdef LAZY_ARC_GENERATION
+  // Queues segments of the pending arc as long as the planner buffer has room. Never waits.
+  // Returns true, if segments remain to be queued.
+  uint8_t mc_arc_execute()
+  {
+    while (arc.segment < arc.segments) {
+      if (plan_check_full_buffer()) {
+        protocol_auto_cycle_start(); // Auto-cycle start when buffer is full, like mc_line().
+        return(true);
+      }
+      mc_arc_next_segment(&arc);
+      mc_line(arc.position, &arc.pl_data);
+      if (sys.abort) { return(false); } // Arc discarded by mc_arc_reset() upon re-initialization.
+    }
+    return(false);
+  }
+
+
+  // Queues all remaining segments of the pending arc, waiting for planner space like mc_line().
+  void mc_arc_synchronize()
+  {
+    while (mc_arc_execute()) {
+      protocol_execute_realtime(); // Check for any run-time commands
+      if (sys.abort) { return; } // Bail, if system abort.
+    }
+  }
+
+
+  // Discards the pending arc. Called upon system reset.
+  void mc_arc_reset()
+  {
+    arc.segment = 0;
+    arc.segments = 0;
+  }
+#endif
+
+
+#ifdef ARC_PLANNER_BLOCKS
+  // Queues an arc as a single planner block, which the stepper follows along the true arc. Returns
+  // false, if the planner cannot plan it as one block. Then the arc must be split into lines.
+  static uint8_t mc_arc_block(float *target, plan_line_data_t *pl_data, float *position, float *offset,
+    float radius, float angular_travel, uint8_t axis_0, uint8_t axis_1, uint8_t axis_0_mask, uint8_t axis_1_mask)
+  {
+    // If enabled, check for soft limit violations at the target and at every point of the arc
+    // furthest along one of the plane axes, which mc_line() can't do for a single block.
+    if (bit_istrue(settings.flags,BITFLAG_SOFT_LIMIT_ENABLE)) {
+      limits_soft_check(target);
+      float extreme[N_AXIS];
+      float start_angle = atan2(-offset[axis_1], -offset[axis_0]);
+      uint8_t idx, quadrant;
+      for (quadrant=0; quadrant<4; quadrant++) {
+        // Angle from the start to the extreme point in the direction of travel. In [0,2*pi).
+        float sweep = quadrant*(0.5*M_PI) - start_angle;
+        if (angular_travel < 0.0) { sweep = -sweep; }
+        sweep = fmod(sweep, 2*M_PI);
+        if (sweep < 0.0) { sweep += 2*M_PI; }
+        if (sweep >= fabs(angular_travel)) { continue; }
+        memcpy(extreme, target, sizeof(extreme));
+        for (idx=0; idx<N_AXIS; idx++) {
+          if (bit_istrue(axis_0_mask,bit(idx))) { extreme[idx] = position[axis_0] + offset[axis_0]; }
+          if (bit_istrue(axis_1_mask,bit(idx))) { extreme[idx] = position[axis_1] + offset[axis_1]; }
+          if (quadrant == 0 && bit_istrue(axis_0_mask,bit(idx))) { extreme[idx] += radius; }
+          if (quadrant == 1 && bit_istrue(axis_1_mask,bit(idx))) { extreme[idx] += radius; }
+          if (quadrant == 2 && bit_istrue(axis_0_mask,bit(idx))) { extreme[idx] -= radius; }
+          if (quadrant == 3 && bit_istrue(axis_1_mask,bit(idx))) { extreme[idx] -= radius; }
+        }
+        limits_soft_check(extreme);
+      }
+    }
+
+    // If in check gcode mode, prevent motion by blocking planner. Soft limits still work.
+    if (sys.state == STATE_CHECK_MODE) { return(true); }
+
+    // Wait for room in the block and arc buffers, like mc_line().
+    do {
+      protocol_execute_realtime(); // Check for any run-time commands
+      if (sys.abort) { return(true); } // Bail, if system abort.
+      if ( plan_check_full_buffer() || plan_check_full_arc_buffer() ) { protocol_auto_cycle_start(); }
+      else { break; }
+    } while (1);
+
+    return(plan_buffer_arc(target, pl_data, position, offset, angular_travel, axis_0, axis_1, axis_0_mask, axis_1_mask));
+  }
+#endif
+
+
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_X defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, isclockwise boolean. Used
@@ -85,29 +258,45 @@ void mc_line(float *target, plan_line_data_t *pl_data)
 // The arc is approximated by generating a huge number of tiny, linear segments. The chordal tolerance
 // of each segment is configured in settings.arc_tolerance, which is defined to be the maximum normal
 // distance from segment to the circle when the end points both lie on the circle.
+// NOTE: With LAZY_ARC_GENERATION, only the segments that fit into the planner buffer are queued here.
+// The main loop queues the rest as the buffer drains, so serial data keeps being processed.
+// NOTE: With ARC_PLANNER_BLOCKS, the arc is queued as a single planner block instead, if it fits.
 void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius,
   uint8_t axis_0, uint8_t axis_1, uint8_t axis_linear, uint8_t axis_0_mask, uint8_t axis_1_mask, uint8_t axis_linear_mask,
   uint8_t axis_a, uint8_t axis_b, uint8_t axis_c, uint8_t axis_a_mask, uint8_t axis_b_mask, uint8_t axis_c_mask,
   uint8_t axis_u, uint8_t axis_v, uint8_t axis_w, uint8_t axis_u_mask, uint8_t axis_v_mask, uint8_t axis_w_mask,
   uint8_t is_clockwise_arc)
 {
-  float center_axis0 = position[axis_0] + offset[axis_0];
-  float center_axis1 = position[axis_1] + offset[axis_1];
-  float r_axis0 = -offset[axis_0];  // Radius vector from center to current location
-  float r_axis1 = -offset[axis_1];
-  float rt_axis0 = target[axis_0] - center_axis0;
-  float rt_axis1 = target[axis_1] - center_axis1;
-  float a_per_segment, b_per_segment, c_per_segment;
-  float u_per_segment, v_per_segment, w_per_segment;
+  #ifdef LAZY_ARC_GENERATION
+    mc_arc_synchronize(); // Finish any pending arc first. Startup lines may hold several arcs.
+    if (sys.abort) { return; }
+  #else
+    arc_generator_t arc;
+  #endif
+  memcpy(arc.position, position, sizeof(arc.position));
+  memcpy(arc.target, target, sizeof(arc.target));
+  memcpy(&arc.pl_data, pl_data, sizeof(plan_line_data_t));
+  arc.center_axis0 = position[axis_0] + offset[axis_0];
+  arc.center_axis1 = position[axis_1] + offset[axis_1];
+  arc.offset_axis0 = offset[axis_0];
+  arc.offset_axis1 = offset[axis_1];
+  arc.r_axis0 = -offset[axis_0];  // Radius vector from center to current location
+  arc.r_axis1 = -offset[axis_1];
+  float rt_axis0 = target[axis_0] - arc.center_axis0;
+  float rt_axis1 = target[axis_1] - arc.center_axis1;
 
   // CCW angle between position and target from circle center. Only one atan2() trig computation required.
-  float angular_travel = atan2(r_axis0*rt_axis1-r_axis1*rt_axis0, r_axis0*rt_axis0+r_axis1*rt_axis1);
+  float angular_travel = atan2(arc.r_axis0*rt_axis1-arc.r_axis1*rt_axis0, arc.r_axis0*rt_axis0+arc.r_axis1*rt_axis1);
   if (is_clockwise_arc) { // Correct atan2 output per direction
     if (angular_travel >= -ARC_ANGULAR_TRAVEL_EPSILON) { angular_travel -= 2*M_PI; }
   } else {
     if (angular_travel <= ARC_ANGULAR_TRAVEL_EPSILON) { angular_travel += 2*M_PI; }
   }
 
+  #ifdef ARC_PLANNER_BLOCKS
+    if (mc_arc_block(target, pl_data, position, offset, radius, angular_travel, axis_0, axis_1, axis_0_mask, axis_1_mask)) { return; }
+  #endif
+
   // NOTE: Segment end points are on the arc, which can lead to the arc diameter being smaller by up to
   // (2x) settings.arc_tolerance. For 99% of users, this is just fine. If a different arc segment fit
   // is desired, i.e. least-squares, midpoint on arc, just change the mm_per_arc_segment calculation.
@@ -115,23 +304,43 @@ void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *of
   uint16_t segments = floor(fabs(0.5*angular_travel*radius)/
                           sqrt(settings.arc_tolerance*(2*radius - settings.arc_tolerance)) );
 
+  arc.segment = 0;
+  arc.segments = 1; // Straight to the target, if too short for segments.
   if (segments) {
     // Multiply inverse feed_rate to compensate for the fact that this movement is approximated
     // by a number of discrete segments. The inverse feed_rate should be correct for the sum of
     // all segments.
-    if (pl_data->condition & PL_COND_FLAG_INVERSE_TIME) {
-      pl_data->feed_rate *= segments;
-      bit_false(pl_data->condition,PL_COND_FLAG_INVERSE_TIME); // Force as feed absolute mode over arc segments.
+    if (arc.pl_data.condition & PL_COND_FLAG_INVERSE_TIME) {
+      arc.pl_data.feed_rate *= segments;
+      bit_false(arc.pl_data.condition,PL_COND_FLAG_INVERSE_TIME); // Force as feed absolute mode over arc segments.
     }
 
-    float theta_per_segment = angular_travel/segments;
+    arc.segments = segments;
+    arc.theta_per_segment = angular_travel/segments;
+    arc.axis_0_mask = axis_0_mask;
+    arc.axis_1_mask = axis_1_mask;
+
+    // Helical and other linear axis travel per segment. Each axis mask includes cloned axes.
     float linear_per_segment = (target[axis_linear] - position[axis_linear])/segments;
-    if ( axis_a_mask ) a_per_segment = (target[axis_a] - position[axis_a])/segments; else a_per_segment = 0;
-    if ( axis_b_mask ) b_per_segment = (target[axis_b] - position[axis_b])/segments; else b_per_segment = 0;
-    if ( axis_c_mask ) c_per_segment = (target[axis_c] - position[axis_c])/segments; else c_per_segment = 0;
-    if ( axis_u_mask ) u_per_segment = (target[axis_u] - position[axis_u])/segments; else u_per_segment = 0;
-    if ( axis_v_mask ) v_per_segment = (target[axis_v] - position[axis_v])/segments; else v_per_segment = 0;
-    if ( axis_w_mask ) w_per_segment = (target[axis_w] - position[axis_w])/segments; else w_per_segment = 0;
+    float a_per_segment = 0, b_per_segment = 0, c_per_segment = 0;
+    float u_per_segment = 0, v_per_segment = 0, w_per_segment = 0;
+    if ( axis_a_mask ) a_per_segment = (target[axis_a] - position[axis_a])/segments;
+    if ( axis_b_mask ) b_per_segment = (target[axis_b] - position[axis_b])/segments;
+    if ( axis_c_mask ) c_per_segment = (target[axis_c] - position[axis_c])/segments;
+    if ( axis_u_mask ) u_per_segment = (target[axis_u] - position[axis_u])/segments;
+    if ( axis_v_mask ) v_per_segment = (target[axis_v] - position[axis_v])/segments;
+    if ( axis_w_mask ) w_per_segment = (target[axis_w] - position[axis_w])/segments;
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) {
+      arc.increment[idx] = 0.0;
+      if (bit_istrue(axis_linear_mask,bit(idx))) { arc.increment[idx] += linear_per_segment; }
+      if (bit_istrue(axis_a_mask,bit(idx))) { arc.increment[idx] += a_per_segment; }
+      if (bit_istrue(axis_b_mask,bit(idx))) { arc.increment[idx] += b_per_segment; }
+      if (bit_istrue(axis_c_mask,bit(idx))) { arc.increment[idx] += c_per_segment; }
+      if (bit_istrue(axis_u_mask,bit(idx))) { arc.increment[idx] += u_per_segment; }
+      if (bit_istrue(axis_v_mask,bit(idx))) { arc.increment[idx] += v_per_segment; }
+      if (bit_istrue(axis_w_mask,bit(idx))) { arc.increment[idx] += w_per_segment; }
+    }
 
     /* Vector rotation by transformation matrix: r is the original vector, r_T is the rotated vector,
        and phi is the angle of rotation. Solution approach by Jens Geisler.
@@ -159,177 +368,22 @@ void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *of
        This is important when there are successive arc motions.
     */
     // Computes: cos_T = 1 - theta_per_segment^2/2, sin_T = theta_per_segment - theta_per_segment^3/6) in ~52usec
-    float cos_T = 2.0 - theta_per_segment*theta_per_segment;
-    float sin_T = theta_per_segment*0.16666667*(cos_T + 4.0);
-    cos_T *= 0.5;
-
-    float sin_Ti;
-    float cos_Ti;
-    float r_axisi;
-    uint16_t i;
-    uint8_t count = 0;
-
-    for (i = 1; i<segments; i++) { // Increment (segments-1).
-
-      if (count < N_ARC_CORRECTION) {
-        // Apply vector rotation matrix. ~40 usec
-        r_axisi = r_axis0*sin_T + r_axis1*cos_T;
-        r_axis0 = r_axis0*cos_T - r_axis1*sin_T;
-        r_axis1 = r_axisi;
-        count++;
-      } else {
-        // Arc correction to radius vector. Computed only every N_ARC_CORRECTION increments. ~375 usec
-        // Compute exact location by applying transformation matrix from initial radius vector(=-offset).
-        cos_Ti = cos(i*theta_per_segment);
-        sin_Ti = sin(i*theta_per_segment);
-        r_axis0 = -offset[axis_0]*cos_Ti + offset[axis_1]*sin_Ti;
-        r_axis1 = -offset[axis_0]*sin_Ti - offset[axis_1]*cos_Ti;
-        count = 0;
-      }
-
-      // Update arc_target location
-      /*
-      position[axis_0] = center_axis0 + r_axis0;
-      position[axis_1] = center_axis1 + r_axis1;
-      position[axis_linear] += linear_per_segment;
-      * */
-      if (bit_istrue((1<<AXIS_1), axis_0_mask)) {position[AXIS_1] = center_axis0 + r_axis0;}
-      if (bit_istrue((1<<AXIS_2), axis_0_mask)) {position[AXIS_2] = center_axis0 + r_axis0;}
-      if (bit_istrue((1<<AXIS_3), axis_0_mask)) {position[AXIS_3] = center_axis0 + r_axis0;}
-      #if N_AXIS > 3
-        if (bit_istrue((1<<AXIS_4), axis_0_mask)) {position[AXIS_4] = center_axis0 + r_axis0;}
-      #endif
-      #if N_AXIS > 4
-        if (bit_istrue((1<<AXIS_5), axis_0_mask)) {position[AXIS_5] = center_axis0 + r_axis0;}
-      #endif
-      #if N_AXIS > 5
-        if (bit_istrue((1<<AXIS_6), axis_0_mask)) {position[AXIS_6] = center_axis0 + r_axis0;}
-      #endif
-
-      if (bit_istrue((1<<AXIS_1), axis_1_mask)) {position[AXIS_1] = center_axis1 + r_axis1;}
-      if (bit_istrue((1<<AXIS_2), axis_1_mask)) {position[AXIS_2] = center_axis1 + r_axis1;}
-      if (bit_istrue((1<<AXIS_3), axis_1_mask)) {position[AXIS_3] = center_axis1 + r_axis1;}
-      #if N_AXIS > 3
-        if (bit_istrue((1<<AXIS_4), axis_1_mask)) {position[AXIS_4] = center_axis1 + r_axis1;}
-      #endif
-      #if N_AXIS > 4
-        if (bit_istrue((1<<AXIS_5), axis_1_mask)) {position[AXIS_5] = center_axis1 + r_axis1;}
-      #endif
-      #if N_AXIS > 5
-        if (bit_istrue((1<<AXIS_6), axis_1_mask)) {position[AXIS_6] = center_axis1 + r_axis1;}
-      #endif
-
-      if (bit_istrue((1<<AXIS_1), axis_linear_mask)) {position[AXIS_1] += linear_per_segment;}
-      if (bit_istrue((1<<AXIS_2), axis_linear_mask)) {position[AXIS_2] += linear_per_segment;}
-      if (bit_istrue((1<<AXIS_3), axis_linear_mask)) {position[AXIS_3] += linear_per_segment;}
-      #if N_AXIS > 3
-        if (bit_istrue((1<<AXIS_4), axis_linear_mask)) {position[AXIS_4] += linear_per_segment;}
-      #endif
-      #if N_AXIS > 4
-        if (bit_istrue((1<<AXIS_5), axis_linear_mask)) {position[AXIS_5] += linear_per_segment;}
-      #endif
-      #if N_AXIS > 5
-        if (bit_istrue((1<<AXIS_6), axis_linear_mask)) {position[AXIS_6] += linear_per_segment;}
-      #endif
-
-      if ( axis_a_mask ) {
-        if (bit_istrue((1<<AXIS_1), axis_a_mask)) {position[AXIS_1] += a_per_segment;}
-        if (bit_istrue((1<<AXIS_2), axis_a_mask)) {position[AXIS_2] += a_per_segment;}
-        if (bit_istrue((1<<AXIS_3), axis_a_mask)) {position[AXIS_3] += a_per_segment;}
-        #if N_AXIS > 3
-          if (bit_istrue((1<<AXIS_4), axis_a_mask)) {position[AXIS_4] += a_per_segment;}
-        #endif
-        #if N_AXIS > 4
-          if (bit_istrue((1<<AXIS_5), axis_a_mask)) {position[AXIS_5] += a_per_segment;}
-        #endif
-        #if N_AXIS > 5
-          if (bit_istrue((1<<AXIS_6), axis_a_mask)) {position[AXIS_6] += a_per_segment;}
-        #endif
-      }
-
-      if ( axis_b_mask ) {
-        if (bit_istrue((1<<AXIS_1), axis_b_mask)) {position[AXIS_1] += b_per_segment;}
-        if (bit_istrue((1<<AXIS_2), axis_b_mask)) {position[AXIS_2] += b_per_segment;}
-        if (bit_istrue((1<<AXIS_3), axis_b_mask)) {position[AXIS_3] += b_per_segment;}
-        #if N_AXIS > 3
-          if (bit_istrue((1<<AXIS_4), axis_b_mask)) {position[AXIS_4] += b_per_segment;}
-        #endif
-        #if N_AXIS > 4
-          if (bit_istrue((1<<AXIS_5), axis_b_mask)) {position[AXIS_5] += b_per_segment;}
-        #endif
-        #if N_AXIS > 5
-          if (bit_istrue((1<<AXIS_6), axis_b_mask)) {position[AXIS_6] += b_per_segment;}
-        #endif
-      }
-
-      if ( axis_c_mask ) {
-        if (bit_istrue((1<<AXIS_1), axis_c_mask)) {position[AXIS_1] += c_per_segment;}
-        if (bit_istrue((1<<AXIS_2), axis_c_mask)) {position[AXIS_2] += c_per_segment;}
-        if (bit_istrue((1<<AXIS_3), axis_c_mask)) {position[AXIS_3] += c_per_segment;}
-        #if N_AXIS > 3
-          if (bit_istrue((1<<AXIS_4), axis_c_mask)) {position[AXIS_4] += c_per_segment;}
-        #endif
-        #if N_AXIS > 4
-          if (bit_istrue((1<<AXIS_5), axis_c_mask)) {position[AXIS_5] += c_per_segment;}
-        #endif
-        #if N_AXIS > 5
-          if (bit_istrue((1<<AXIS_6), axis_c_mask)) {position[AXIS_6] += c_per_segment;}
-        #endif
-      }
-
-      if ( axis_u_mask ) {
-        if (bit_istrue((1<<AXIS_1), axis_u_mask)) {position[AXIS_1] += u_per_segment;}
-        if (bit_istrue((1<<AXIS_2), axis_u_mask)) {position[AXIS_2] += u_per_segment;}
-        if (bit_istrue((1<<AXIS_3), axis_u_mask)) {position[AXIS_3] += u_per_segment;}
-        #if N_AXIS > 3
-          if (bit_istrue((1<<AXIS_4), axis_u_mask)) {position[AXIS_4] += u_per_segment;}
-        #endif
-        #if N_AXIS > 4
-          if (bit_istrue((1<<AXIS_5), axis_u_mask)) {position[AXIS_5] += u_per_segment;}
-        #endif
-        #if N_AXIS > 5
-          if (bit_istrue((1<<AXIS_6), axis_u_mask)) {position[AXIS_6] += u_per_segment;}
-        #endif
-      }
-
-      if ( axis_v_mask ) {
-        if (bit_istrue((1<<AXIS_1), axis_v_mask)) {position[AXIS_1] += v_per_segment;}
-        if (bit_istrue((1<<AXIS_2), axis_v_mask)) {position[AXIS_2] += v_per_segment;}
-        if (bit_istrue((1<<AXIS_3), axis_v_mask)) {position[AXIS_3] += v_per_segment;}
-        #if N_AXIS > 3
-          if (bit_istrue((1<<AXIS_4), axis_v_mask)) {position[AXIS_4] += v_per_segment;}
-        #endif
-        #if N_AXIS > 4
-          if (bit_istrue((1<<AXIS_5), axis_v_mask)) {position[AXIS_5] += v_per_segment;}
-        #endif
-        #if N_AXIS > 5
-          if (bit_istrue((1<<AXIS_6), axis_v_mask)) {position[AXIS_6] += v_per_segment;}
-        #endif
-      }
-
-      if ( axis_w_mask ) {
-        if (bit_istrue((1<<AXIS_1), axis_w_mask)) {position[AXIS_1] += w_per_segment;}
-        if (bit_istrue((1<<AXIS_2), axis_w_mask)) {position[AXIS_2] += w_per_segment;}
-        if (bit_istrue((1<<AXIS_3), axis_w_mask)) {position[AXIS_3] += w_per_segment;}
-        #if N_AXIS > 3
-          if (bit_istrue((1<<AXIS_4), axis_w_mask)) {position[AXIS_4] += w_per_segment;}
-        #endif
-        #if N_AXIS > 4
-          if (bit_istrue((1<<AXIS_5), axis_w_mask)) {position[AXIS_5] += w_per_segment;}
-        #endif
-        #if N_AXIS > 5
-          if (bit_istrue((1<<AXIS_6), axis_w_mask)) {position[AXIS_6] += w_per_segment;}
-        #endif
-      }
-
-      mc_line(position, pl_data);
+    arc.cos_T = 2.0 - arc.theta_per_segment*arc.theta_per_segment;
+    arc.sin_T = arc.theta_per_segment*0.16666667*(arc.cos_T + 4.0);
+    arc.cos_T *= 0.5;
+    arc.count = 0;
+  }
 
+  #ifdef LAZY_ARC_GENERATION
+    mc_arc_execute(); // Queue what fits now. The main loop queues the rest.
+  #else
+    while (arc.segment < arc.segments) {
+      mc_arc_next_segment(&arc);
+      mc_line(arc.position, &arc.pl_data);
       // Bail mid-circle on system abort. Runtime command check already performed by mc_line.
       if (sys.abort) { return; }
     }
-  }
-  // Ensure last segment arrives at target location.
-  mc_line(target, pl_data);
+  #endif
 }
 
 
@@ -45,6 +45,17 @@ void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *of
   uint8_t axis_u, uint8_t axis_v, uint8_t axis_w, uint8_t axis_u_mask, uint8_t axis_v_mask, uint8_t axis_w_mask,
   uint8_t is_clockwise_arc);
 
+#ifdef LAZY_ARC_GENERATION
+  // Queues segments of a pending arc while the planner buffer has room. Returns true, if some remain.
+  uint8_t mc_arc_execute();
+
+  // Queues all remaining segments of a pending arc. Waits for planner space like mc_line().
+  void mc_arc_synchronize();
+
+  // Discards any pending arc.
+  void mc_arc_reset();
+#endif
+
 // Dwell for a specific number of seconds
 void mc_dwell(float seconds);
 
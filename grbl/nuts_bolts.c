@@ -33,21 +33,23 @@
 // Scientific notation is officially not supported by g-code, and the 'E' character may
 // be a g-code word on some CNC systems. So, 'E' notation will not be recognized.
 // NOTE: Thanks to Radu-Eosif Mihailescu for identifying the issues with using strtod().
+// NOTE: The line is indexed with a uint8_t, so a line parsed in place in the 256-byte serial
+// RX buffer may wrap around its end. A stored line may be read in place, see line_get_char().
 uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
 {
-  char *ptr = line + *char_counter;
+  uint8_t idx = *char_counter;
   unsigned char c;
 
-  // Grab first character and increment pointer. No spaces assumed in line.
-  c = *ptr++;
+  // Grab first character and increment index. No spaces assumed in line.
+  c = line_get_char(line, idx++);
 
   // Capture initial positive/minus character
   bool isnegative = false;
   if (c == '-') {
     isnegative = true;
-    c = *ptr++;
+    c = line_get_char(line, idx++);
   } else if (c == '+') {
-    c = *ptr++;
+    c = line_get_char(line, idx++);
   }
 
   // Extract number into fast integer. Track decimal in terms of exponent value.
@@ -70,12 +72,25 @@ uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
     } else {
       break;
     }
-    c = *ptr++;
+    c = line_get_char(line, idx++);
   }
 
   // Return if no digits have been read.
   if (!ndigit) { return(false); };
 
+  // Convert integer into floating point with correct sign.
+  *float_ptr = convert_decimal_to_float(intval, exp, isnegative);
+
+  *char_counter = idx - 1; // Set char_counter to next statement
+
+  return(true);
+}
+
+
+// Converts an integer and its decimal exponent into floating point. Used by both the ASCII and
+// the binary g-code readers, so the same digits always give the same value.
+float convert_decimal_to_float(uint32_t intval, int8_t exp, bool isnegative)
+{
   // Convert integer into floating point.
   float fval;
   fval = (float)intval;
@@ -97,16 +112,39 @@ uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
   }
 
   // Assign floating point value with correct sign.
-  if (isnegative) {
-    *float_ptr = -fval;
-  } else {
-    *float_ptr = fval;
-  }
+  if (isnegative) { return(-fval); }
+  return(fval);
+}
 
-  *char_counter = ptr - line - 1; // Set char_counter to next statement
 
-  return(true);
-}
+#ifdef ENABLE_BINARY_GCODE
+  // Extracts a g-code word from a binary frame payload. The header byte holds the word letter in
+  // bits 0-4, counted from 'A'=1, and the number of decimals in bits 5-7. The value follows as a
+  // zigzag-encoded base-128 varint, low 7-bit group first with bit 7 set on all but the last.
+  // Zigzag encoding maps 0,-1,1,-2,... to 0,1,2,3,... The letter is returned unchecked.
+  uint8_t read_frame_word(char *line, uint8_t *char_counter, char *letter, float *float_ptr)
+  {
+    uint8_t *ptr = (uint8_t *)line + *char_counter;
+    uint8_t *end = (uint8_t *)line + 2 + (uint8_t)line[1]; // End of payload. Length at line[1].
+    uint8_t header = *ptr++;
+    *letter = 'A'-1 + (header & 0x1f);
+
+    uint32_t zigzag = 0;
+    uint8_t shift = 0;
+    uint8_t c;
+    do {
+      if (ptr == end) { return(false); } // Truncated
+      c = *ptr++;
+      if ((shift == 28) && (c & 0xf0)) { return(false); } // More than 32 bits, or a 6th byte
+      zigzag |= (uint32_t)(c & 0x7f) << shift;
+      shift += 7;
+    } while (c & 0x80);
+
+    *float_ptr = convert_decimal_to_float((zigzag >> 1) + (zigzag & 1), -(int8_t)(header >> 5), zigzag & 1);
+    *char_counter = ptr - (uint8_t *)line; // Set char_counter to next word
+    return(true);
+  }
+#endif
 
 
 // Non-blocking delay function used for general operation and suspend features.
@@ -199,3 +237,41 @@ float limit_value_by_axis_maximum(float *max_value, float *unit_vec)
   }
   return(limit_value);
 }
+
+
+float limit_value_by_axis_maximum_inv(float *max_value_inv, float *unit_vec)
+{
+  uint8_t idx;
+  float limit_value_inv = 0.0;
+  for (idx=0; idx<N_AXIS; idx++) {
+    if (unit_vec[idx] != 0) {  // Avoid 0*inf from a zero axis maximum.
+      limit_value_inv = max(limit_value_inv,fabs(unit_vec[idx]*max_value_inv[idx]));
+    }
+  }
+  if (limit_value_inv == 0.0) { return(SOME_LARGE_VALUE); }
+  return(1.0/limit_value_inv);
+}
+
+
+#ifdef PACKED_PLANNER_BLOCKS
+  typedef union {
+    float value;
+    uint32_t bits;
+  } float_bits_t;
+
+
+  uint16_t pack_float(float value)
+  {
+    float_bits_t f;
+    f.value = value;
+    return(f.bits >> 16);
+  }
+
+
+  float unpack_float(uint16_t value)
+  {
+    float_bits_t f;
+    f.bits = (uint32_t)value << 16;
+    return(f.value);
+  }
+#endif
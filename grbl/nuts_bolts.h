@@ -64,6 +64,22 @@
 // a pointer to the result variable. Returns true when it succeeds
 uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr);
 
+// Returns character idx of a line. With PARSE_LINES_IN_RX_BUFFER, a NULL line is the stored line
+// opened by settings_read_startup_line() or settings_read_build_info(), read in place in EEPROM.
+#ifdef PARSE_LINES_IN_RX_BUFFER
+  #define line_get_char(line,idx) ((line) ? (line)[idx] : settings_line_char(idx))
+#else
+  #define line_get_char(line,idx) ((line)[idx])
+#endif
+
+// Converts an integer and decimal exponent to floating point, exactly as read_float() does.
+float convert_decimal_to_float(uint32_t intval, int8_t exp, bool isnegative);
+
+#ifdef ENABLE_BINARY_GCODE
+  // Read a word letter and value from a binary g-code frame, starting at line[char_counter].
+  uint8_t read_frame_word(char *line, uint8_t *char_counter, char *letter, float *float_ptr);
+#endif
+
 // Non-blocking delay function used for general operation and suspend features.
 void delay_sec(float seconds, uint8_t mode);
 
@@ -79,4 +95,15 @@ float hypot_f(float x, float y);
 float convert_delta_vector_to_unit_vector(float *vector);
 float limit_value_by_axis_maximum(float *max_value, float *unit_vec);
 
+// Same as limit_value_by_axis_maximum(), given the reciprocals of the axis maximums. Multiplies per
+// axis and divides only once.
+float limit_value_by_axis_maximum_inv(float *max_value_inv, float *unit_vec);
+
+#ifdef PACKED_PLANNER_BLOCKS
+  // Packs a non-negative float into 16 bits by dropping the low half of its mantissa, which
+  // rounds it down by up to 0.8%. Packed values keep the order of the floats.
+  uint16_t pack_float(float value);
+  float unpack_float(uint16_t value);
+#endif
+
 #endif
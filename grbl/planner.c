@@ -30,6 +30,34 @@ static uint8_t block_buffer_head;     // Index of the next block to be pushed
 static uint8_t next_buffer_head;      // Index of the next buffer head
 static uint8_t block_buffer_planned;  // Index of the optimally planned block
 
+#ifdef PLANNER_VISIT_COUNT
+  // Blocks visited by the reverse and forward passes. Host builds only, read by the planner benchmark.
+  uint32_t planner_visits;
+  #define planner_count_visit() planner_visits++
+#else
+  #define planner_count_visit()
+#endif
+
+#ifdef PACKED_PLANNER_BLOCKS
+  // Run headers of the blocks in the buffer. The last one is reserved for system motions.
+  static plan_run_t run_buffer[PLAN_RUN_BUFFER_SIZE+1];
+  static uint8_t run_buffer_tail;       // Index of the run of the tail block
+  static uint8_t run_buffer_head;       // Index of the run of the newest block
+  #define PLAN_RUN_SYSTEM_MOTION PLAN_RUN_BUFFER_SIZE
+#endif
+
+#ifdef ARC_PLANNER_BLOCKS
+  // Geometry of the arc blocks in the buffer, in the order of their blocks.
+  static plan_arc_t arc_buffer[PLAN_ARC_BUFFER_SIZE];
+  static uint8_t arc_buffer_tail;       // Index of the arc of the oldest arc block
+  static uint8_t arc_buffer_head;       // Index of the next arc to be pushed
+
+  // Arc blocks keep half of the axis acceleration for the centripetal acceleration, which limits
+  // their nominal speed. The remainder, sqrt(1-0.5^2), is left for speed changes along the arc.
+  #define ARC_CENTRIPETAL_ACCELERATION 0.5
+  #define ARC_TANGENTIAL_ACCELERATION 0.8660254
+#endif
+
 // Define planner variables
 typedef struct {
   int32_t position[N_AXIS];          // The planner position of the tool in absolute steps. Kept separate
@@ -50,6 +78,28 @@ uint8_t plan_next_block_index(uint8_t block_index)
 }
 
 
+#ifdef ARC_PLANNER_BLOCKS
+  // Returns the index of the next arc in the ring buffer.
+  static uint8_t plan_next_arc_index(uint8_t arc_index)
+  {
+    arc_index++;
+    if (arc_index == PLAN_ARC_BUFFER_SIZE) { arc_index = 0; }
+    return(arc_index);
+  }
+#endif
+
+
+#ifdef PACKED_PLANNER_BLOCKS
+  // Returns the index of the next run header in the ring buffer.
+  static uint8_t plan_next_run_index(uint8_t run_index)
+  {
+    run_index++;
+    if (run_index == PLAN_RUN_BUFFER_SIZE) { run_index = 0; }
+    return(run_index);
+  }
+#endif
+
+
 // Returns the index of the previous block in the ring buffer
 static uint8_t plan_prev_block_index(uint8_t block_index)
 {
@@ -59,6 +109,146 @@ static uint8_t plan_prev_block_index(uint8_t block_index)
 }
 
 
+#ifdef S_CURVE_ACCELERATION
+/* With the $28 jerk limit, the stepper ramps its acceleration up and down, so how soon it has to brake
+   depends on its acceleration as well as its speed, and a speed per junction no longer says what it
+   must do there. The stepper brakes for braking limits instead: reach a speed, with the acceleration
+   back at zero, at some point ahead. Each block keeps the strictest limit past its entry, other than
+   its maximum entry speed: brake_speed at brake_mm past the entry. That is the maximum entry speed of
+   the next block, lowered to what still reaches the limit kept by the next block, or that limit
+   carried back over the block. The stepper brakes just in time for both the maximum entry speed and
+   the limit of the next block, and for the next stop, so a braking ramp runs on through short blocks
+   and junctions instead of restarting in each of them. The limits are carried back on each replan up
+   to the executing block, as they still change behind the planned pointer.
+   entry_speed_sqr ranks the limits by how soon they make the stepper brake, so the passes below keep
+   their constant acceleration form. From a cruise at v, braking to u takes (v^2-u^2)/(2*A)+(v+u)*A/(2*J)
+   mm at the acceleration A and jerk J, as early as a constant deceleration to u^2-u*A^2/J-c^2/3 at the
+   same place, where c = A^2/(2*J) is the speed change while the acceleration ramps to A. A limit ranks
+   as that plus 2*A times its distance. Without a jerk limit, it is the speed squared. The ranks only
+   hold well above u. Below u = 2c, reaching u ranks stricter than a stop at the same place, so a new
+   block may tighten the plan behind it. The stepper stops at such a limit, where it is too late to
+   ramp its acceleration back to zero at u. */
+
+// Returns the rank of a stop at the junction. It is -c^2/3, as the acceleration ramps back to zero
+// over the last A^3/(6*J^2) mm of a stop instead of the c^2/(2*A) mm of a constant deceleration.
+float plan_s_curve_stop_speed_sqr(plan_block_t *block)
+{
+  float c = 0.5*plan_block_acceleration(block)*plan_block_acceleration(block)*settings_inverse.jerk_inv;
+  return(-c*c*(1.0/3.0));
+}
+
+
+// Returns the rank of reaching the maximum entry speed of the block at its entry.
+static float plan_s_curve_max_entry_speed_sqr(plan_block_t *block)
+{
+  float max_entry_speed_sqr = plan_block_max_entry_speed_sqr(block);
+  if (settings_inverse.jerk_inv == 0.0) { return(max_entry_speed_sqr); }
+  float acceleration = plan_block_acceleration(block);
+  float speed = sqrt(max_entry_speed_sqr);
+  return(max_entry_speed_sqr-speed*acceleration*acceleration*settings_inverse.jerk_inv+plan_s_curve_stop_speed_sqr(block));
+}
+
+
+// Returns the distance to brake from a cruise at the speed down to the target speed in the block.
+static float plan_s_curve_brake_mm(plan_block_t *block, float speed, float target)
+{
+  if (speed <= target) { return(0.0); }
+  float acceleration = plan_block_acceleration(block);
+  if ((speed-target)*settings.jerk < acceleration*acceleration) { // Acceleration peaks below A.
+    return((speed+target)*sqrt((speed-target)*settings_inverse.jerk_inv));
+  }
+  return((speed*speed-target*target)/(2.0*acceleration)+(speed+target)*acceleration*(0.5*settings_inverse.jerk_inv));
+}
+
+
+// Returns the highest speed a cruise brakes down from to the target speed within mm in the block.
+static float plan_s_curve_brake_speed(plan_block_t *block, float target, float mm)
+{
+  float acceleration = plan_block_acceleration(block);
+  float ramp_speed = acceleration*acceleration*settings_inverse.jerk_inv; // Speed change to ramp to A and back.
+  float speed = 0.5*(sqrt(ramp_speed*ramp_speed+4.0*(target*(target-ramp_speed)+2.0*acceleration*mm))-ramp_speed);
+  if (speed-target < ramp_speed) {
+    // Acceleration peaks below A. Solve (v+u)^2*(v-u) = J*mm^2 by Newton iterations from above.
+    float jerk_mm_sqr = settings.jerk*mm*mm;
+    float speed_change = cbrt(jerk_mm_sqr);
+    if ((target > 0.0) && (jerk_mm_sqr < 4.0*target*target*speed_change)) { speed_change = jerk_mm_sqr/(4.0*target*target); }
+    speed = target+speed_change;
+    uint8_t idx;
+    for (idx=0; idx<3; idx++) {
+      speed -= ((speed+target)*(speed+target)*(speed-target)-jerk_mm_sqr)/((speed+target)*(3.0*speed-target));
+    }
+  }
+  return(speed);
+}
+
+
+// Sets the braking limit of the block from the next block: its maximum entry speed, or less where
+// the limit of the next block is out of reach from there, or else that limit, whichever a cruise at
+// the nominal speed has to brake for first.
+static void plan_s_curve_brake_before(plan_block_t *block, plan_block_t *next)
+{
+  float speed = plan_compute_profile_nominal_speed(block);
+  float entry_speed = sqrt(plan_block_max_entry_speed_sqr(next));
+  float brake_speed = plan_s_curve_brake_speed(next, next->brake_speed, next->brake_mm);
+  if (entry_speed > brake_speed) { entry_speed = brake_speed; }
+  if (next->brake_mm-plan_s_curve_brake_mm(block, speed, next->brake_speed) <
+      -plan_s_curve_brake_mm(block, speed, entry_speed)) {
+    block->brake_speed = next->brake_speed;
+    block->brake_mm = next->brake_mm+block->millimeters;
+  } else {
+    block->brake_speed = entry_speed;
+    block->brake_mm = block->millimeters;
+  }
+}
+
+
+// Carries the braking limits back from the last block to the one after the tail, which the stepper
+// reads. Unlike the entry speeds, the limits behind the planned pointer still follow the blocks added
+// after them, up to the first one that keeps its limit.
+static void plan_s_curve_update_brakes()
+{
+  uint8_t block_index = plan_prev_block_index(block_buffer_head);
+  plan_block_t *next = &block_buffer[block_index];
+  next->brake_speed = 0.0; // Stop at the end of the last block.
+  next->brake_mm = next->millimeters;
+  uint8_t planned = (block_index == block_buffer_planned);
+  while (block_index != block_buffer_tail) {
+    block_index = plan_prev_block_index(block_index);
+    if (block_index == block_buffer_tail) { // Limit of the block after the executing one changed.
+      st_update_plan_block_parameters();
+      break;
+    }
+    plan_block_t *block = &block_buffer[block_index];
+    float brake_speed = block->brake_speed;
+    float brake_mm = block->brake_mm;
+    plan_s_curve_brake_before(block, next);
+    if (planned && (block->brake_speed == brake_speed) && (block->brake_mm == brake_mm)) { break; }
+    if (block_index == block_buffer_planned) { planned = true; }
+    next = block;
+  }
+}
+
+
+// Returns an upper bound of the rank of a stop the stepper can reach by the end of the block, ramping
+// up from its entry. At a speed v and the full acceleration, the rank is (v+4c)^2-32c^2/3.
+static float plan_s_curve_reach_speed_sqr(plan_block_t *block)
+{
+  float acceleration = plan_block_acceleration(block);
+  float ramp_speed = 2.0*acceleration*acceleration*settings_inverse.jerk_inv; // 4c
+  float speed_sqr = 2.0*acceleration*block->millimeters;
+  if (block->entry_speed_sqr > 0.0) { speed_sqr += block->entry_speed_sqr; }
+  float speed = sqrt(speed_sqr)+ramp_speed;
+  return(speed*speed-ramp_speed*ramp_speed*(2.0/3.0));
+}
+
+  #define plan_planned_max_entry_speed_sqr(block) plan_s_curve_max_entry_speed_sqr(block)
+  #define plan_planned_stop_speed_sqr(block) plan_s_curve_stop_speed_sqr(block)
+#else
+  #define plan_planned_max_entry_speed_sqr(block) plan_block_max_entry_speed_sqr(block)
+  #define plan_planned_stop_speed_sqr(block) 0.0
+#endif
+
+
 /*                            PLANNER SPEED DEFINITION
                                      +--------+   <- current->nominal_speed
                                     /          \
@@ -126,6 +316,10 @@ static uint8_t plan_prev_block_index(uint8_t block_index)
 */
 static void planner_recalculate()
 {
+  #ifdef S_CURVE_ACCELERATION
+    if (settings_inverse.jerk_inv != 0.0) { plan_s_curve_update_brakes(); }
+  #endif
+
   // Initialize block index to the last block in the planner buffer.
   uint8_t block_index = plan_prev_block_index(block_buffer_head);
 
@@ -140,7 +334,8 @@ static void planner_recalculate()
   plan_block_t *current = &block_buffer[block_index];
 
   // Calculate maximum entry speed for last block in buffer, where the exit speed is always zero.
-  current->entry_speed_sqr = min( current->max_entry_speed_sqr, 2*current->acceleration*current->millimeters);
+  current->entry_speed_sqr = min( plan_planned_max_entry_speed_sqr(current),
+                                  plan_planned_stop_speed_sqr(current)+2*plan_block_acceleration(current)*current->millimeters);
 
   block_index = plan_prev_block_index(block_index);
   if (block_index == block_buffer_planned) { // Only two plannable blocks in buffer. Reverse pass complete.
@@ -148,6 +343,7 @@ static void planner_recalculate()
     if (block_index == block_buffer_tail) { st_update_plan_block_parameters(); }
   } else { // Three or more plan-able blocks
     while (block_index != block_buffer_planned) {
+      planner_count_visit();
       next = current;
       current = &block_buffer[block_index];
       block_index = plan_prev_block_index(block_index);
@@ -156,12 +352,13 @@ static void planner_recalculate()
       if (block_index == block_buffer_tail) { st_update_plan_block_parameters(); }
 
       // Compute maximum entry speed decelerating over the current block from its exit speed.
-      if (current->entry_speed_sqr != current->max_entry_speed_sqr) {
-        entry_speed_sqr = next->entry_speed_sqr + 2*current->acceleration*current->millimeters;
-        if (entry_speed_sqr < current->max_entry_speed_sqr) {
+      float max_entry_speed_sqr = plan_planned_max_entry_speed_sqr(current);
+      if (current->entry_speed_sqr != max_entry_speed_sqr) {
+        entry_speed_sqr = next->entry_speed_sqr + 2*plan_block_acceleration(current)*current->millimeters;
+        if (entry_speed_sqr < max_entry_speed_sqr) {
           current->entry_speed_sqr = entry_speed_sqr;
         } else {
-          current->entry_speed_sqr = current->max_entry_speed_sqr;
+          current->entry_speed_sqr = max_entry_speed_sqr;
         }
       }
     }
@@ -172,6 +369,7 @@ static void planner_recalculate()
   next = &block_buffer[block_buffer_planned]; // Begin at buffer planned pointer
   block_index = plan_next_block_index(block_buffer_planned);
   while (block_index != block_buffer_head) {
+    planner_count_visit();
     current = next;
     next = &block_buffer[block_index];
 
@@ -179,7 +377,15 @@ static void planner_recalculate()
     // pointer forward, since everything before this is all optimal. In other words, nothing
     // can improve the plan from the buffer tail to the planned pointer by logic.
     if (current->entry_speed_sqr < next->entry_speed_sqr) {
-      entry_speed_sqr = current->entry_speed_sqr + 2*current->acceleration*current->millimeters;
+      entry_speed_sqr = current->entry_speed_sqr + 2*plan_block_acceleration(current)*current->millimeters;
+      #ifdef S_CURVE_ACCELERATION
+        // With the jerk limit, the stepper ramps up on its own and only brakes to the planned entries,
+        // so they are left as they are. Move the planned pointer once next entry is out of reach.
+        if (settings_inverse.jerk_inv != 0.0) {
+          if (plan_s_curve_reach_speed_sqr(current) < next->entry_speed_sqr) { block_buffer_planned = block_index; }
+          entry_speed_sqr = next->entry_speed_sqr; // Skips the update below.
+        }
+      #endif
       // If true, current block is full-acceleration and we can move the planned pointer forward.
       if (entry_speed_sqr < next->entry_speed_sqr) {
         next->entry_speed_sqr = entry_speed_sqr; // Always <= max_entry_speed_sqr. Backward pass sets this.
@@ -191,7 +397,7 @@ static void planner_recalculate()
     // point in the buffer. When the plan is bracketed by either the beginning of the
     // buffer and a maximum entry speed or two maximum entry speeds, every block in between
     // cannot logically be further improved. Hence, we don't have to recompute them anymore.
-    if (next->entry_speed_sqr == next->max_entry_speed_sqr) { block_buffer_planned = block_index; }
+    if (next->entry_speed_sqr == plan_planned_max_entry_speed_sqr(next)) { block_buffer_planned = block_index; }
     block_index = plan_next_block_index( block_index );
   }
 }
@@ -210,6 +416,14 @@ void plan_reset_buffer()
   block_buffer_head = 0; // Empty = tail
   next_buffer_head = 1; // plan_next_block_index(block_buffer_head)
   block_buffer_planned = 0; // = block_buffer_tail;
+  #ifdef PACKED_PLANNER_BLOCKS
+    run_buffer_tail = 0;
+    run_buffer_head = 0;
+  #endif
+  #ifdef ARC_PLANNER_BLOCKS
+    arc_buffer_tail = 0;
+    arc_buffer_head = 0;
+  #endif
 }
 
 
@@ -219,7 +433,15 @@ void plan_discard_current_block()
     uint8_t block_index = plan_next_block_index( block_buffer_tail );
     // Push block_buffer_planned pointer, if encountered.
     if (block_buffer_tail == block_buffer_planned) { block_buffer_planned = block_index; }
+    #ifdef ARC_PLANNER_BLOCKS
+      // Free the arc geometry of a discarded arc block.
+      if (block_buffer[block_buffer_tail].arc_index != PLAN_NO_ARC) { arc_buffer_tail = plan_next_arc_index(arc_buffer_tail); }
+    #endif
     block_buffer_tail = block_index;
+    #ifdef PACKED_PLANNER_BLOCKS
+      // Free the runs before the new tail block. Left as is, when the buffer is empty.
+      if (block_index != block_buffer_head) { run_buffer_tail = block_buffer[block_index].run_index; }
+    #endif
   }
 }
 
@@ -247,23 +469,134 @@ float plan_get_exec_block_exit_speed_sqr()
 }
 
 
+#ifdef S_CURVE_ACCELERATION
+  // Returns the maximum entry speed (sqr) of the block after the executing one, or zero at the end
+  // of the buffer. Unlike the planned entry, this is a speed limit at the junction.
+  float plan_get_exec_block_exit_max_speed_sqr()
+  {
+    uint8_t block_index = plan_next_block_index(block_buffer_tail);
+    if (block_index == block_buffer_head) { return( 0.0 ); }
+    return( plan_block_max_entry_speed_sqr(&block_buffer[block_index]) );
+  }
+
+
+  // Gets the braking limit kept by the block after the executing one and the distance past the
+  // executing block to the next stop, at a junction from rest or at the end of the buffer.
+  void plan_get_exec_block_exit_brake(float *brake_speed, float *brake_mm, float *stop_mm)
+  {
+    uint8_t block_index = plan_next_block_index(block_buffer_tail);
+    *brake_speed = 0.0; // Stop at the end of the executing block.
+    *brake_mm = 0.0;
+    if (block_index != block_buffer_head) {
+      *brake_speed = block_buffer[block_index].brake_speed;
+      *brake_mm = block_buffer[block_index].brake_mm;
+    }
+    *stop_mm = 0.0;
+    while ((block_index != block_buffer_head) && (plan_block_max_entry_speed_sqr(&block_buffer[block_index]) > 0.0)) {
+      *stop_mm += block_buffer[block_index].millimeters;
+      block_index = plan_next_block_index(block_index);
+    }
+  }
+#endif
+
+
 // Returns the availability status of the block ring buffer. True, if full.
 uint8_t plan_check_full_buffer()
 {
   if (block_buffer_tail == next_buffer_head) { return(true); }
+  #ifdef PACKED_PLANNER_BLOCKS
+    // Full, if a new block may need a run header and none are free.
+    if ((block_buffer_tail != block_buffer_head) && (plan_next_run_index(run_buffer_head) == run_buffer_tail)) { return(true); }
+  #endif
   return(false);
 }
 
 
+#ifdef ARC_PLANNER_BLOCKS
+  // Returns the availability status of the arc ring buffer. True, if full.
+  uint8_t plan_check_full_arc_buffer()
+  {
+    if (plan_next_arc_index(arc_buffer_head) == arc_buffer_tail) { return(true); }
+    return(false);
+  }
+
+
+  plan_arc_t *plan_get_block_arc(plan_block_t *block)
+  {
+    if (block->arc_index == PLAN_NO_ARC) { return(NULL); }
+    return(&arc_buffer[block->arc_index]);
+  }
+
+
+  // Replaces the plane components of the line delta vector by the arc length in the plane and
+  // returns the length of the arc path. Leaves the vector of the axis travel per millimeter of
+  // path, used to limit the block rate and acceleration by the axis maximums.
+  // NOTE: The plane travel is counted once, however many axes are cloned from the plane axes. The
+  // stepper splits the arc by this path length, so both follow the same arc length.
+  static float plan_arc_limit_vector(plan_arc_t *arc, float *vector)
+  {
+    uint8_t idx;
+    uint8_t plane_mask = arc->axis_0_mask | arc->axis_1_mask;
+    float plane_mm = fabs(arc->angular_travel)*sqrt(arc->r_axis0*arc->r_axis0 + arc->r_axis1*arc->r_axis1);
+    for (idx=0; idx<N_AXIS; idx++) {
+      if (bit_istrue(plane_mask,bit(idx))) {
+        vector[idx] = plane_mm;
+        plane_mm = 0.0; // Counted once, with the first plane axis.
+      }
+    }
+    float millimeters = convert_delta_vector_to_unit_vector(vector);
+    for (idx=0; idx<N_AXIS; idx++) {
+      if (bit_istrue(plane_mask,bit(idx))) {
+        if (vector[idx] != 0.0) { plane_mm = vector[idx]; }
+        vector[idx] = plane_mm;
+      }
+    }
+    return(millimeters);
+  }
+
+
+  // Sets the plane components of a unit vector to the arc direction at radius vector r.
+  static void plan_arc_tangent(plan_arc_t *arc, float *unit_vec, float r_axis0, float r_axis1)
+  {
+    uint8_t idx;
+    float scale = arc->angular_travel/arc->millimeters; // Plane fraction of the path over radius. Signed.
+    for (idx=0; idx<N_AXIS; idx++) {
+      if (bit_istrue(arc->axis_0_mask,bit(idx))) { unit_vec[idx] = -r_axis1*scale; }
+      if (bit_istrue(arc->axis_1_mask,bit(idx))) { unit_vec[idx] = r_axis0*scale; }
+    }
+  }
+#endif
+
+
+#ifdef PACKED_PLANNER_BLOCKS
+  float plan_get_block_programmed_rate(plan_block_t *block)
+  {
+    if (block->condition & PL_COND_FLAG_RAPID_MOTION) { return(unpack_float(block->rapid_rate)); }
+    return(run_buffer[block->run_index].programmed_rate);
+  }
+
+
+  float plan_get_block_spindle_speed(plan_block_t *block)
+  {
+    return(run_buffer[block->run_index].spindle_speed);
+  }
+#endif
+
+
 // Computes and returns block nominal speed based on running condition and override values.
 // NOTE: All system motion commands, such as homing/parking, are not subject to overrides.
 float plan_compute_profile_nominal_speed(plan_block_t *block)
 {
-  float nominal_speed = block->programmed_rate;
+  float nominal_speed = plan_block_programmed_rate(block);
   if (block->condition & PL_COND_FLAG_RAPID_MOTION) { nominal_speed *= (0.01*sys.r_override); }
   else {
     if (!(block->condition & PL_COND_FLAG_NO_FEED_OVERRIDE)) { nominal_speed *= (0.01*sys.f_override); }
-    if (nominal_speed > block->rapid_rate) { nominal_speed = block->rapid_rate; }
+    #ifdef PACKED_PLANNER_BLOCKS
+      float rapid_rate = unpack_float(block->rapid_rate);
+      if (nominal_speed > rapid_rate) { nominal_speed = rapid_rate; }
+    #else
+      if (nominal_speed > block->rapid_rate) { nominal_speed = block->rapid_rate; }
+    #endif
   }
   if (nominal_speed > MINIMUM_FEED_RATE) { return(nominal_speed); }
   return(MINIMUM_FEED_RATE);
@@ -275,9 +608,16 @@ float plan_compute_profile_nominal_speed(plan_block_t *block)
 static void plan_compute_profile_parameters(plan_block_t *block, float nominal_speed, float prev_nominal_speed)
 {
   // Compute the junction maximum entry based on the minimum of the junction speed and neighboring nominal speeds.
-  if (nominal_speed > prev_nominal_speed) { block->max_entry_speed_sqr = prev_nominal_speed*prev_nominal_speed; }
-  else { block->max_entry_speed_sqr = nominal_speed*nominal_speed; }
-  if (block->max_entry_speed_sqr > block->max_junction_speed_sqr) { block->max_entry_speed_sqr = block->max_junction_speed_sqr; }
+  #ifdef PACKED_PLANNER_BLOCKS
+    float max_entry_speed_sqr;
+    if (nominal_speed > prev_nominal_speed) { max_entry_speed_sqr = prev_nominal_speed*prev_nominal_speed; }
+    else { max_entry_speed_sqr = nominal_speed*nominal_speed; }
+    block->max_entry_speed_sqr = min(pack_float(max_entry_speed_sqr), block->max_junction_speed_sqr); // Packed values order like floats.
+  #else
+    if (nominal_speed > prev_nominal_speed) { block->max_entry_speed_sqr = prev_nominal_speed*prev_nominal_speed; }
+    else { block->max_entry_speed_sqr = nominal_speed*nominal_speed; }
+    if (block->max_entry_speed_sqr > block->max_junction_speed_sqr) { block->max_entry_speed_sqr = block->max_junction_speed_sqr; }
+  #endif
 }
 
 
@@ -312,15 +652,29 @@ void plan_update_velocity_profile_parameters()
    The system motion condition tells the planner to plan a motion in the always unused block buffer
    head. It avoids changing the planner state and preserves the buffer to ensure subsequent gcode
    motions are still planned correctly, while the stepper module only points to the block buffer head
-   to execute the special system motion. */
+   to execute the special system motion.
+   With ARC_PLANNER_BLOCKS, arc blocks are planned here too. They pass their geometry in arc. */
+#ifdef ARC_PLANNER_BLOCKS
+static uint8_t plan_buffer_motion(float *target, plan_line_data_t *pl_data, plan_arc_t *arc)
+#else
 uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
+#endif
 {
   // Prepare and initialize new block. Copy relevant pl_data for block execution.
   plan_block_t *block = &block_buffer[block_buffer_head];
   memset(block,0,sizeof(plan_block_t)); // Zero all block values.
   block->condition = pl_data->condition;
-  block->spindle_speed = pl_data->spindle_speed;
-  block->line_number = pl_data->line_number;
+  #ifdef ARC_PLANNER_BLOCKS
+    block->arc_index = PLAN_NO_ARC;
+  #endif
+  #ifdef PACKED_PLANNER_BLOCKS
+    #ifdef REPORT_FIELD_LINE_NUMBERS
+      block->line_number = pl_data->line_number;
+    #endif
+  #else
+    block->spindle_speed = pl_data->spindle_speed;
+    block->line_number = pl_data->line_number;
+  #endif
 
   // Compute and store initial move distance data.
   int32_t target_steps[N_AXIS], position_steps[N_AXIS];
@@ -365,53 +719,146 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
       }
       block->step_event_count = max(block->step_event_count, block->steps[idx]);
       if (idx == A_MOTOR) {
-        delta_mm = (target_steps[AXIS_1]-position_steps[AXIS_1] + target_steps[AXIS_2]-position_steps[AXIS_2])/settings.steps_per_mm[idx];
+        delta_mm = (target_steps[AXIS_1]-position_steps[AXIS_1] + target_steps[AXIS_2]-position_steps[AXIS_2])*settings_inverse.mm_per_step[idx];
       } else if (idx == B_MOTOR) {
-        delta_mm = (target_steps[AXIS_1]-position_steps[AXIS_1] - target_steps[AXIS_2]+position_steps[AXIS_2])/settings.steps_per_mm[idx];
+        delta_mm = (target_steps[AXIS_1]-position_steps[AXIS_1] - target_steps[AXIS_2]+position_steps[AXIS_2])*settings_inverse.mm_per_step[idx];
       } else {
-        delta_mm = (target_steps[idx] - position_steps[idx])/settings.steps_per_mm[idx];
+        delta_mm = (target_steps[idx] - position_steps[idx])*settings_inverse.mm_per_step[idx];
       }
     #else
       target_steps[idx] = lround(target[idx]*settings.steps_per_mm[idx]);
       block->steps[idx] = labs(target_steps[idx]-position_steps[idx]);
       block->step_event_count = max(block->step_event_count, block->steps[idx]);
-      delta_mm = (target_steps[idx] - position_steps[idx])/settings.steps_per_mm[idx];
+      delta_mm = (target_steps[idx] - position_steps[idx])*settings_inverse.mm_per_step[idx];
     #endif
     unit_vec[idx] = delta_mm; // Store unit vector numerator
 
     // Set direction bits. Bit enabled always means direction is negative.
-    #ifdef DEFAULTS_RAMPS_BOARD
+    #if defined(DEFAULTS_RAMPS_BOARD) && defined(PACKED_PLANNER_BLOCKS)
+      if (delta_mm < 0.0 ) { block->direction_bits |= bit(idx); } // Expanded to port bits by the stepper.
+    #elif defined(DEFAULTS_RAMPS_BOARD)
       if (delta_mm < 0.0 ) { block->direction_bits[idx] |= get_direction_pin_mask(idx); }
     #else
       if (delta_mm < 0.0 ) { block->direction_bits |= get_direction_pin_mask(idx); }
     #endif // DEFAULTS_RAMPS_BOARD
   }
 
+  #ifdef ARC_PLANNER_BLOCKS
+    if (arc != NULL) {
+      // The stepper follows the arc, not the line steps. Full circles end where they start, so
+      // size the block by its path length at the finest axis resolution instead.
+      block->millimeters = plan_arc_limit_vector(arc, unit_vec);
+      float max_steps_per_mm = 0.0;
+      for (idx=0; idx<N_AXIS; idx++) {
+        if (unit_vec[idx] != 0.0) { max_steps_per_mm = max(max_steps_per_mm, settings.steps_per_mm[idx]); }
+      }
+      uint32_t step_event_count = ceil(block->millimeters*max_steps_per_mm);
+      #ifdef PACKED_PLANNER_BLOCKS
+        if (step_event_count > PLAN_BLOCK_MAX_STEPS) { return(PLAN_EMPTY_BLOCK); }
+      #endif
+      block->step_event_count = step_event_count;
+      block->arc_index = arc_buffer_head;
+      memcpy(arc->start_steps, position_steps, sizeof(position_steps));
+      memcpy(arc->end_steps, target_steps, sizeof(target_steps));
+      arc->millimeters = block->millimeters;
+    }
+  #endif
+
   // Bail if this is a zero-length block. Highly unlikely to occur.
   if (block->step_event_count == 0) { return(PLAN_EMPTY_BLOCK); }
 
+  #ifdef PACKED_PLANNER_BLOCKS
+    // Also bail, if the step counts overflowed. mc_line() splits lines before they get this long.
+    // NOTE: CoreXY motor steps may add up the steps of both axes.
+    for (idx=0; idx<N_AXIS; idx++) {
+      #ifdef COREXY
+        if (labs(target_steps[idx]-position_steps[idx]) > PLAN_BLOCK_MAX_STEPS/2) { return(PLAN_EMPTY_BLOCK); }
+      #else
+        if (labs(target_steps[idx]-position_steps[idx]) > PLAN_BLOCK_MAX_STEPS) { return(PLAN_EMPTY_BLOCK); }
+      #endif
+    }
+  #endif
+
   // Calculate the unit vector of the line move and the block maximum feed rate and acceleration scaled
   // down such that no individual axes maximum values are exceeded with respect to the line direction.
   // NOTE: This calculation assumes all axes are orthogonal (Cartesian) and works with ABC-axes,
   // if they are also orthogonal/independent. Operates on the absolute value of the unit vector.
-  block->millimeters = convert_delta_vector_to_unit_vector(unit_vec);
-  block->acceleration = limit_value_by_axis_maximum(settings.acceleration, unit_vec);
-  block->rapid_rate = limit_value_by_axis_maximum(settings.max_rate, unit_vec);
-
-  // Store programmed rate.
-  if (block->condition & PL_COND_FLAG_RAPID_MOTION) { block->programmed_rate = block->rapid_rate; }
-  else {
-    block->programmed_rate = pl_data->feed_rate;
-    if (block->condition & PL_COND_FLAG_INVERSE_TIME) { block->programmed_rate *= block->millimeters; }
-  }
+  #ifdef ARC_PLANNER_BLOCKS
+    if (arc == NULL) { block->millimeters = convert_delta_vector_to_unit_vector(unit_vec); }
+  #else
+    block->millimeters = convert_delta_vector_to_unit_vector(unit_vec);
+  #endif
+  float acceleration = limit_value_by_axis_maximum_inv(settings_inverse.acceleration_inv, unit_vec);
+  float rapid_rate = limit_value_by_axis_maximum_inv(settings_inverse.max_rate_inv, unit_vec);
+  #ifdef ARC_PLANNER_BLOCKS
+    if (arc != NULL) {
+      // Limit the nominal speed by the centripetal acceleration of the plane axes about the arc
+      // center, where the plane speed is the plane fraction of the path speed. Then point the unit
+      // vector along the start of the arc, for the junction with the previous block.
+      float plane_acceleration_inv = 0.0;
+      float plane_fraction = 0.0;
+      for (idx=0; idx<N_AXIS; idx++) {
+        if (bit_istrue((arc->axis_0_mask|arc->axis_1_mask),bit(idx))) {
+          plane_acceleration_inv = max(plane_acceleration_inv, settings_inverse.acceleration_inv[idx]);
+          plane_fraction = unit_vec[idx];
+        }
+      }
+      float radius = sqrt(arc->r_axis0*arc->r_axis0 + arc->r_axis1*arc->r_axis1);
+      float max_arc_rate = sqrt(ARC_CENTRIPETAL_ACCELERATION*radius/plane_acceleration_inv)/plane_fraction;
+      if (rapid_rate > max_arc_rate) { rapid_rate = max_arc_rate; }
+      acceleration *= ARC_TANGENTIAL_ACCELERATION;
+      plan_arc_tangent(arc, unit_vec, arc->r_axis0, arc->r_axis1);
+    }
+  #endif
+  #ifdef PACKED_PLANNER_BLOCKS
+    block->acceleration = pack_float(acceleration);
+    block->rapid_rate = pack_float(rapid_rate);
+
+    // Store programmed rate and spindle speed in the run header of the previous block, if they
+    // are the same. Rapids only need the same spindle speed. Their rate is the rapid rate.
+    float programmed_rate = pl_data->feed_rate;
+    if (block->condition & PL_COND_FLAG_INVERSE_TIME) { programmed_rate *= block->millimeters; }
+    plan_run_t *run = &run_buffer[run_buffer_head];
+    if (block->condition & PL_COND_FLAG_SYSTEM_MOTION) {
+      block->run_index = PLAN_RUN_SYSTEM_MOTION;
+      run = &run_buffer[PLAN_RUN_SYSTEM_MOTION];
+    } else {
+      if (block_buffer_head == block_buffer_tail) {
+        run_buffer_tail = run_buffer_head; // Empty buffer. Reuse the last run header.
+      } else if ((run->spindle_speed != pl_data->spindle_speed) ||
+                 (!(block->condition & PL_COND_FLAG_RAPID_MOTION) && (run->programmed_rate != programmed_rate))) {
+        // New run. Free header checked by plan_check_full_buffer().
+        run_buffer_head = plan_next_run_index(run_buffer_head);
+        run = &run_buffer[run_buffer_head];
+      } else {
+        run = NULL; // Shares the previous run.
+      }
+      block->run_index = run_buffer_head;
+    }
+    if (run != NULL) {
+      run->programmed_rate = programmed_rate;
+      run->spindle_speed = pl_data->spindle_speed;
+    }
+  #else
+    block->acceleration = acceleration;
+    block->rapid_rate = rapid_rate;
+
+    // Store programmed rate.
+    if (block->condition & PL_COND_FLAG_RAPID_MOTION) { block->programmed_rate = block->rapid_rate; }
+    else {
+      block->programmed_rate = pl_data->feed_rate;
+      if (block->condition & PL_COND_FLAG_INVERSE_TIME) { block->programmed_rate *= block->millimeters; }
+    }
+  #endif
 
   // TODO: Need to check this method handling zero junction speeds when starting from rest.
+  float max_junction_speed_sqr;
   if ((block_buffer_head == block_buffer_tail) || (block->condition & PL_COND_FLAG_SYSTEM_MOTION)) {
 
     // Initialize block entry speed as zero. Assume it will be starting from rest. Planner will correct this later.
     // If system motion, the system motion block always is assumed to start from rest and end at a complete stop.
     block->entry_speed_sqr = 0.0;
-    block->max_junction_speed_sqr = 0.0; // Starting from rest. Enforce start from zero velocity.
+    max_junction_speed_sqr = 0.0; // Starting from rest. Enforce start from zero velocity.
 
   } else {
     // Compute maximum allowable entry speed at junction by centripetal acceleration approximation.
@@ -446,20 +893,25 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
     // NOTE: Computed without any expensive trig, sin() or acos(), by trig half angle identity of cos(theta).
     if (junction_cos_theta > 0.999999) {
       //  For a 0 degree acute junction, just set minimum junction speed.
-      block->max_junction_speed_sqr = MINIMUM_JUNCTION_SPEED*MINIMUM_JUNCTION_SPEED;
+      max_junction_speed_sqr = MINIMUM_JUNCTION_SPEED*MINIMUM_JUNCTION_SPEED;
     } else {
       if (junction_cos_theta < -0.999999) {
         // Junction is a straight line or 180 degrees. Junction speed is infinite.
-        block->max_junction_speed_sqr = SOME_LARGE_VALUE;
+        max_junction_speed_sqr = SOME_LARGE_VALUE;
       } else {
         convert_delta_vector_to_unit_vector(junction_unit_vec);
-        float junction_acceleration = limit_value_by_axis_maximum(settings.acceleration, junction_unit_vec);
+        float junction_acceleration = limit_value_by_axis_maximum_inv(settings_inverse.acceleration_inv, junction_unit_vec);
         float sin_theta_d2 = sqrt(0.5*(1.0-junction_cos_theta)); // Trig half angle identity. Always positive.
-        block->max_junction_speed_sqr = max( MINIMUM_JUNCTION_SPEED*MINIMUM_JUNCTION_SPEED,
+        max_junction_speed_sqr = max( MINIMUM_JUNCTION_SPEED*MINIMUM_JUNCTION_SPEED,
                        (junction_acceleration * settings.junction_deviation * sin_theta_d2)/(1.0-sin_theta_d2) );
       }
     }
   }
+  #ifdef PACKED_PLANNER_BLOCKS
+    block->max_junction_speed_sqr = pack_float(max_junction_speed_sqr);
+  #else
+    block->max_junction_speed_sqr = max_junction_speed_sqr;
+  #endif
 
   // Block system motion from updating this data to ensure next g-code motion is computed correctly.
   if (!(block->condition & PL_COND_FLAG_SYSTEM_MOTION)) {
@@ -467,6 +919,17 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
     plan_compute_profile_parameters(block, nominal_speed, pl.previous_nominal_speed);
     pl.previous_nominal_speed = nominal_speed;
 
+    #ifdef ARC_PLANNER_BLOCKS
+      if (arc != NULL) {
+        // The next junction is with the direction at the end of the arc.
+        float cos_T = cos(arc->angular_travel);
+        float sin_T = sin(arc->angular_travel);
+        plan_arc_tangent(arc, unit_vec, arc->r_axis0*cos_T - arc->r_axis1*sin_T,
+                                        arc->r_axis0*sin_T + arc->r_axis1*cos_T);
+        arc_buffer_head = plan_next_arc_index(arc_buffer_head);
+      }
+    #endif
+
     // Update previous path unit_vector and planner position.
     memcpy(pl.previous_unit_vec, unit_vec, sizeof(unit_vec)); // pl.previous_unit_vec[] = unit_vec[]
     memcpy(pl.position, target_steps, sizeof(target_steps)); // pl.position[] = target_steps[]
@@ -482,6 +945,29 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
 }
 
 
+#ifdef ARC_PLANNER_BLOCKS
+uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
+{
+  return(plan_buffer_motion(target, pl_data, NULL));
+}
+
+
+uint8_t plan_buffer_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset,
+  float angular_travel, uint8_t axis_0, uint8_t axis_1, uint8_t axis_0_mask, uint8_t axis_1_mask)
+{
+  plan_arc_t *arc = &arc_buffer[arc_buffer_head];
+  arc->center_axis0 = position[axis_0] + offset[axis_0];
+  arc->center_axis1 = position[axis_1] + offset[axis_1];
+  arc->r_axis0 = -offset[axis_0];
+  arc->r_axis1 = -offset[axis_1];
+  arc->angular_travel = angular_travel;
+  arc->axis_0_mask = axis_0_mask;
+  arc->axis_1_mask = axis_1_mask;
+  return(plan_buffer_motion(target, pl_data, arc));
+}
+#endif
+
+
 // Reset the planner position vectors. Called by the system abort/initialization routine.
 void plan_sync_position()
 {
@@ -521,6 +1007,14 @@ uint8_t plan_get_block_buffer_count()
 }
 
 
+// Returns the planner position in millimeters. Used to split lines ahead of planning.
+void plan_get_planner_mpos(float *target)
+{
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) { target[idx] = pl.position[idx]*settings_inverse.mm_per_step[idx]; }
+}
+
+
 // Re-initialize buffer plan with a partially completed block, assumed to exist at the buffer tail.
 // Called after a steppers have come to a complete stop for a feed hold and the cycle is stopped.
 void plan_cycle_reinitialize()
@@ -23,9 +23,38 @@
 #define planner_h
 
 
-// The number of linear motions that can be in the plan at any give time
-#ifndef BLOCK_BUFFER_SIZE
-  #define BLOCK_BUFFER_SIZE 36
+#ifdef PACKED_PLANNER_BLOCKS
+  // The RAM used by planner blocks and run headers. The number of blocks follows from it.
+  #ifndef PLANNER_BLOCK_RAM
+    #define PLANNER_BLOCK_RAM 2340
+  #endif
+  // The number of run headers. More are needed when consecutive blocks often change feed rate or
+  // spindle speed, or use inverse time, which takes one run per block.
+  #ifndef PLAN_RUN_BUFFER_SIZE
+    #define PLAN_RUN_BUFFER_SIZE 16
+  #endif
+  #ifdef BLOCK_BUFFER_SIZE
+    #error "BLOCK_BUFFER_SIZE is set by PLANNER_BLOCK_RAM, when PACKED_PLANNER_BLOCKS is enabled."
+  #endif
+  // Plus one run header for system motions. Must not exceed 255 blocks.
+  #define BLOCK_BUFFER_SIZE ((PLANNER_BLOCK_RAM-(PLAN_RUN_BUFFER_SIZE+1)*sizeof(plan_run_t))/sizeof(plan_block_t))
+  #define PLAN_BLOCK_MAX_STEPS 0xffffffUL // Largest 24-bit step count.
+#else
+  // The number of linear motions that can be in the plan at any give time
+  #ifndef BLOCK_BUFFER_SIZE
+    #define BLOCK_BUFFER_SIZE 36
+  #endif
+#endif
+
+#ifdef ARC_PLANNER_BLOCKS
+  // The number of arcs that can be in the plan at any given time. Each takes an arc geometry slot.
+  #ifndef PLAN_ARC_BUFFER_SIZE
+    #define PLAN_ARC_BUFFER_SIZE 8
+  #endif
+  #define PLAN_NO_ARC 0xff // Arc index of line blocks.
+  #ifdef COREXY
+    #error "ARC_PLANNER_BLOCKS does not support COREXY."
+  #endif
 #endif
 
 // Returned status message from planner.
@@ -45,6 +74,49 @@
 #define PL_COND_ACCESSORY_MASK (PL_COND_FLAG_SPINDLE_CW|PL_COND_FLAG_SPINDLE_CCW|PL_COND_FLAG_COOLANT_FLOOD|PL_COND_FLAG_COOLANT_MIST)
 
 
+#ifdef PACKED_PLANNER_BLOCKS
+
+// Stores the programmed rate and spindle speed shared by a run of consecutive planner blocks.
+typedef struct {
+  float programmed_rate;  // Programmed rate of the blocks (mm/min). Per block, if inverse time.
+  float spindle_speed;    // Block spindle speed. Copied from pl_line_data.
+} plan_run_t;
+
+// Packed version of the planner block below. Limits that never change once planned are stored
+// as the upper 16 bits of their float value, rounded down. Read them with the accessors below.
+typedef struct {
+  __uint24 steps[N_AXIS];    // Step count along each axis
+  __uint24 step_event_count; // The maximum step axis count and number of steps required to complete this block.
+  uint8_t direction_bits;    // Bit per axis, set for negative direction. Not a port mask.
+  uint8_t condition;         // Block bitflag variable defining block run conditions. Copied from pl_line_data.
+  uint8_t run_index;         // Run header holding the programmed rate and spindle speed.
+  #ifdef ARC_PLANNER_BLOCKS
+    uint8_t arc_index;       // Arc geometry slot, or PLAN_NO_ARC for lines.
+  #endif
+  #ifdef REPORT_FIELD_LINE_NUMBERS
+    int32_t line_number;     // Block line number for real-time reporting. Full width, as N may reach 9999999.
+  #endif
+
+  float entry_speed_sqr;     // The current planned entry speed at block junction in (mm/min)^2
+  float millimeters;         // The remaining distance for this block to be executed in (mm).
+                             // NOTE: This value may be altered by stepper algorithm during execution.
+  #ifdef S_CURVE_ACCELERATION
+    float brake_speed;       // Strictest braking limit past the block entry: reach this speed (mm/min),
+    float brake_mm;          //   with the acceleration back at zero, this far past it (mm). See planner.c.
+  #endif
+  uint16_t max_entry_speed_sqr;    // Packed. Maximum allowable entry speed in (mm/min)^2
+  uint16_t acceleration;           // Packed. Axis-limit adjusted line acceleration in (mm/min^2).
+  uint16_t max_junction_speed_sqr; // Packed. Junction entry speed limit in (mm/min)^2
+  uint16_t rapid_rate;             // Packed. Axis-limit adjusted maximum rate in (mm/min)
+} plan_block_t;
+
+#define plan_block_acceleration(block) unpack_float((block)->acceleration)
+#define plan_block_max_entry_speed_sqr(block) unpack_float((block)->max_entry_speed_sqr)
+#define plan_block_programmed_rate(block) plan_get_block_programmed_rate(block)
+#define plan_block_spindle_speed(block) plan_get_block_spindle_speed(block)
+
+#else
+
 // This struct stores a linear movement of a g-code block motion with its critical "nominal" values
 // are as specified in the source g-code.
 typedef struct {
@@ -60,6 +132,9 @@ typedef struct {
   // Block condition data to ensure correct execution depending on states and overrides.
   uint8_t condition;      // Block bitflag variable defining block run conditions. Copied from pl_line_data.
   int32_t line_number;  // Block line number for real-time reporting. Copied from pl_line_data.
+  #ifdef ARC_PLANNER_BLOCKS
+    uint8_t arc_index;    // Arc geometry slot, or PLAN_NO_ARC for lines.
+  #endif
 
   // Fields used by the motion planner to manage acceleration. Some of these values may be updated
   // by the stepper module during execution of special motion cases for replanning purposes.
@@ -69,6 +144,10 @@ typedef struct {
   float acceleration;        // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
   float millimeters;         // The remaining distance for this block to be executed in (mm).
                              // NOTE: This value may be altered by stepper algorithm during execution.
+  #ifdef S_CURVE_ACCELERATION
+    float brake_speed;       // Strictest braking limit past the block entry: reach this speed (mm/min),
+    float brake_mm;          //   with the acceleration back at zero, this far past it (mm). See planner.c.
+  #endif
 
   // Stored rate limiting data used by planner when changes occur.
   float max_junction_speed_sqr; // Junction entry speed limit based on direction vectors in (mm/min)^2
@@ -79,6 +158,31 @@ typedef struct {
   float spindle_speed;    // Block spindle speed. Copied from pl_line_data.
 } plan_block_t;
 
+#define plan_block_acceleration(block) ((block)->acceleration)
+#define plan_block_max_entry_speed_sqr(block) ((block)->max_entry_speed_sqr)
+#define plan_block_programmed_rate(block) ((block)->programmed_rate)
+#define plan_block_spindle_speed(block) ((block)->spindle_speed)
+
+#endif
+
+
+#ifdef ARC_PLANNER_BLOCKS
+// Geometry of an arc block, which the stepper segment generator follows instead of a straight line.
+// Other axes, like the helical axis, move linearly along the arc.
+typedef struct {
+  int32_t start_steps[N_AXIS]; // Planner position at the start of the arc (steps)
+  int32_t end_steps[N_AXIS];   // Target position of the arc (steps)
+  float center_axis0;          // Arc center in the plane (mm)
+  float center_axis1;
+  float r_axis0;               // Radius vector from the center to the start position (mm)
+  float r_axis1;
+  float angular_travel;        // Angle traveled about the center. Positive for CCW arcs. (rad)
+  float millimeters;           // Full length of the arc path, including linear axes (mm)
+  uint8_t axis_0_mask;         // Plane axes, including cloned axes
+  uint8_t axis_1_mask;
+} plan_arc_t;
+#endif
+
 
 // Planner data prototype. Must be used when passing new motions to the planner.
 typedef struct {
@@ -114,6 +218,13 @@ uint8_t plan_next_block_index(uint8_t block_index);
 // Called by step segment buffer when computing executing block velocity profile.
 float plan_get_exec_block_exit_speed_sqr();
 
+#ifdef S_CURVE_ACCELERATION
+  // Called by step segment buffer for the jerk-limited ramps. See planner.c.
+  float plan_get_exec_block_exit_max_speed_sqr();
+  void plan_get_exec_block_exit_brake(float *brake_speed, float *brake_mm, float *stop_mm);
+  float plan_s_curve_stop_speed_sqr(plan_block_t *block);
+#endif
+
 // Called by main program during planner calculations and step segment buffer during initialization.
 float plan_compute_profile_nominal_speed(plan_block_t *block);
 
@@ -138,5 +249,26 @@ uint8_t plan_check_full_buffer();
 
 void plan_get_planner_mpos(float *target);
 
+#ifdef ARC_PLANNER_BLOCKS
+  // Add a new arc block to the buffer. position[N_AXIS] is the start of the arc in millimeters,
+  // offset[] the vector from position to the arc center. Other axes move linearly to target[].
+  // Returns PLAN_EMPTY_BLOCK, if the arc cannot be planned as a single block.
+  // NOTE: Assumes the block and arc buffers both have room. See plan_check_full_arc_buffer().
+  uint8_t plan_buffer_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset,
+    float angular_travel, uint8_t axis_0, uint8_t axis_1, uint8_t axis_0_mask, uint8_t axis_1_mask);
+
+  // Returns the status of the arc geometry ring buffer. True, if full.
+  uint8_t plan_check_full_arc_buffer();
+
+  // Returns the arc geometry of a planner block, or NULL for line blocks.
+  plan_arc_t *plan_get_block_arc(plan_block_t *block);
+#endif
+
+#ifdef PACKED_PLANNER_BLOCKS
+  // Returns the programmed rate and spindle speed of a packed block from its run header.
+  float plan_get_block_programmed_rate(plan_block_t *block);
+  float plan_get_block_spindle_speed(plan_block_t *block);
+#endif
+
 
 #endif
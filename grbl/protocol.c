@@ -21,15 +21,29 @@
 
 #include "grbl.h"
 
-// Define line flags. Includes comment type tracking and line overflow detection.
-#define LINE_FLAG_OVERFLOW bit(0)
-#define LINE_FLAG_COMMENT_PARENTHESES bit(1)
-#define LINE_FLAG_COMMENT_SEMICOLON bit(2)
+#ifndef PARSE_LINES_IN_RX_BUFFER
+  static char line[LINE_BUFFER_SIZE]; // Line to be executed. Zero-terminated.
+#endif
 
+static void protocol_exec_rt_suspend();
 
-static char line[LINE_BUFFER_SIZE]; // Line to be executed. Zero-terminated.
 
-static void protocol_exec_rt_suspend();
+#ifdef ENABLE_BINARY_GCODE
+  // Checks the length and CRC of the binary g-code frame received into the line buffer and
+  // terminates its payload for the g-code parser. The CRC covers the length byte and payload. A
+  // frame cut short fails like a corrupt one.
+  static uint8_t protocol_check_frame(uint8_t frame_size)
+  {
+    uint8_t length = line[1];
+    if (frame_size != length+SERIAL_FRAME_OVERHEAD) { return(STATUS_FRAME_CRC_ERROR); }
+    uint16_t crc = 0xffff;
+    uint8_t idx;
+    for (idx=1; idx<length+2; idx++) { crc = _crc_xmodem_update(crc, line[idx]); }
+    if (crc != (((uint8_t)line[idx] << 8) | (uint8_t)line[idx+1])) { return(STATUS_FRAME_CRC_ERROR); }
+    line[idx] = 0; // Terminate payload.
+    return(STATUS_OK);
+  }
+#endif
 
 
 /*
@@ -60,7 +74,11 @@ void protocol_main_loop()
       protocol_execute_realtime(); // Enter safety door mode. Should return as IDLE state.
     }
     // All systems go!
-    system_execute_startup(line); // Execute startup script.
+    #ifdef PARSE_LINES_IN_RX_BUFFER
+      system_execute_startup(NULL); // Execute startup script in place in EEPROM.
+    #else
+      system_execute_startup(line); // Execute startup script.
+    #endif
   }
 
   // ---------------------------------------------------------------------------------
@@ -71,25 +89,105 @@ void protocol_main_loop()
   uint8_t line_flags = 0;
   uint8_t char_counter = 0;
   uint8_t c;
+  #ifdef ENABLE_BINARY_GCODE
+    uint16_t frame_remaining = 0; // Binary frame bytes still to be read.
+  #endif
   for (;;) {
 
     // Process one line of incoming serial data, as the data becomes available. Performs an
     // initial filtering by removing spaces and comments and capitalizing all letters.
+    #ifdef ENABLE_BINARY_GCODE
+    // Binary frame bytes may equal SERIAL_NO_DATA. Check the buffer count instead.
+    while (serial_get_rx_buffer_count()) {
+      c = serial_read();
+      if (line_flags & LINE_FLAG_BINARY_FRAME) {
+        if ((c == SERIAL_FRAME_START) || (c == '\n') || (c == '\r')) {
+          // Never sent unescaped within a frame. Cut it short, so a truncated frame can't swallow
+          // the lines after it. A frame start begins the next frame.
+          if (c == SERIAL_FRAME_START) { line_flags |= LINE_FLAG_FRAME_RESYNC; }
+          c = '\n';
+        } else if (c == SERIAL_FRAME_ESCAPE) {
+          line_flags |= LINE_FLAG_FRAME_ESCAPE;
+          continue;
+        } else {
+          if (line_flags & LINE_FLAG_FRAME_ESCAPE) {
+            c ^= SERIAL_FRAME_ESCAPE_XOR;
+            line_flags &= ~(LINE_FLAG_FRAME_ESCAPE);
+          }
+          // Copy the frame length, payload and CRC. Oversized frames are read and discarded.
+          if (char_counter == 1) { frame_remaining = c+3; }
+          if (char_counter < (LINE_BUFFER_SIZE-1)) { line[char_counter++] = c; }
+          else { line_flags |= LINE_FLAG_OVERFLOW; }
+          if (--frame_remaining) { continue; }
+          c = '\n'; // Frame complete. Execute it like a line.
+        }
+      } else if ((c == SERIAL_FRAME_START) && (char_counter == 0) && (line_flags == 0)) {
+        line[char_counter++] = c;
+        line_flags = LINE_FLAG_BINARY_FRAME;
+        continue;
+      }
+    #elif defined(PARSE_LINES_IN_RX_BUFFER)
+    while((c = serial_read_line_byte()) != SERIAL_NO_DATA) {
+    #elif defined(ASSEMBLE_LINES_IN_RX_ISR)
+    // The RX interrupt has filtered each line already. Execute the complete lines.
+    while((c = serial_read_line(line)) != SERIAL_NO_DATA) {
+      if (c == STATUS_OVERFLOW) { line_flags |= LINE_FLAG_OVERFLOW; }
+      c = '\n';
+    #else
     while((c = serial_read()) != SERIAL_NO_DATA) {
+    #endif
       if ((c == '\n') || (c == '\r')) { // End of line reached
 
         protocol_execute_realtime(); // Runtime command check point.
         if (sys.abort) { return; } // Bail to calling function upon system abort
 
-        line[char_counter] = 0; // Set string termination character.
+        #ifdef PARSE_LINES_IN_RX_BUFFER
+          serial_write_line_byte(0); // Set string termination character.
+          uint8_t line_start = serial_get_line_start();
+          char *line = (char *)serial_rx_buffer;
+        #elif !defined(ASSEMBLE_LINES_IN_RX_ISR)
+          line[char_counter] = 0; // Set string termination character.
+        #endif
         #ifdef REPORT_ECHO_LINE_RECEIVED
-          report_echo_line_received(line);
+          if (!(line_flags & LINE_FLAG_BINARY_FRAME)) { report_echo_line_received(line); }
         #endif
 
         // Direct and execute one line of formatted input, and report status of execution.
+        #ifdef PARSE_LINES_IN_RX_BUFFER
+          // Free the line's space in the serial RX buffer before reporting the status. A sender
+          // may refill the buffer as soon as it receives the response.
+          uint8_t status_code;
+          if (line_flags & LINE_FLAG_OVERFLOW) {
+            status_code = STATUS_OVERFLOW;
+          } else if (line[line_start] == 0) {
+            // Empty or comment line. For syncing purposes.
+            status_code = STATUS_OK;
+          } else if (line[line_start] == '$') {
+            // Grbl '$' system command
+            status_code = system_execute_line_at(line, line_start);
+          } else if (sys.state & (STATE_ALARM | STATE_JOG)) {
+            // Everything else is gcode. Block if in alarm or jog mode.
+            status_code = STATUS_SYSTEM_GC_LOCK;
+          } else {
+            // Parse and execute g-code block in place.
+            status_code = gc_execute_line_at(line, line_start);
+          }
+          serial_release_line();
+          report_status_message(status_code);
+        #else
         if (line_flags & LINE_FLAG_OVERFLOW) {
           // Report line overflow error.
           report_status_message(STATUS_OVERFLOW);
+        #ifdef ENABLE_BINARY_GCODE
+          } else if (line_flags & LINE_FLAG_BINARY_FRAME) {
+            // Binary g-code frame. Executed like a g-code line, once intact.
+            uint8_t status_code = protocol_check_frame(char_counter);
+            if (status_code == STATUS_OK) {
+              if (sys.state & (STATE_ALARM | STATE_JOG)) { status_code = STATUS_SYSTEM_GC_LOCK; }
+              else { status_code = gc_execute_line(line); }
+            }
+            report_status_message(status_code);
+        #endif
         } else if (line[0] == 0) {
           // Empty or comment line. For syncing purposes.
           report_status_message(STATUS_OK);
@@ -103,8 +201,17 @@ void protocol_main_loop()
           // Parse and execute g-code block.
           report_status_message(gc_execute_line(line));
         }
+        #endif
 
         // Reset tracking data for next line.
+        #ifdef ENABLE_BINARY_GCODE
+          if (line_flags & LINE_FLAG_FRAME_RESYNC) {
+            line[0] = SERIAL_FRAME_START;
+            line_flags = LINE_FLAG_BINARY_FRAME;
+            char_counter = 1;
+            continue;
+          }
+        #endif
         line_flags = 0;
         char_counter = 0;
 
@@ -141,16 +248,31 @@ void protocol_main_loop()
           } else if (char_counter >= (LINE_BUFFER_SIZE-1)) {
             // Detect line buffer overflow and set flag.
             line_flags |= LINE_FLAG_OVERFLOW;
-          } else if (c >= 'a' && c <= 'z') { // Upcase lowercase
-            line[char_counter++] = c-'a'+'A';
           } else {
-            line[char_counter++] = c;
+            if (c >= 'a' && c <= 'z') { c = c-'a'+'A'; } // Upcase lowercase
+            #ifdef PARSE_LINES_IN_RX_BUFFER
+              serial_write_line_byte(c); // Filter in place, behind the characters still to be read.
+              char_counter++;
+            #else
+              line[char_counter++] = c;
+            #endif
           }
         }
 
       }
     }
 
+    #ifdef PARSE_LINES_IN_RX_BUFFER
+      // A line filling the whole serial RX buffer can not complete in place. Discard it as an
+      // overflow, and keep discarding its characters as they are read, until its end.
+      if (!serial_get_rx_buffer_available()) { line_flags |= LINE_FLAG_OVERFLOW; }
+      if (line_flags & LINE_FLAG_OVERFLOW) { serial_release_line(); }
+    #endif
+
+    #ifdef LAZY_ARC_GENERATION
+      mc_arc_execute(); // Queue more segments of a pending arc, if the planner has room.
+    #endif
+
     // If there are no more characters in the serial read buffer to be processed and executed,
     // this indicates that g-code streaming has either filled the planner buffer or has
     // completed. In either case, auto-cycle start, if enabled, any queued moves.
@@ -173,12 +295,19 @@ void protocol_main_loop()
 // during a synchronize call, if it should happen. Also, waits for clean cycle end.
 void protocol_buffer_synchronize()
 {
+  #ifdef LAZY_ARC_GENERATION
+    mc_arc_synchronize(); // Queue the rest of a pending arc first.
+  #endif
   // If system is queued, ensure cycle resumes if the auto start flag is present.
   protocol_auto_cycle_start();
   do {
     protocol_execute_realtime();   // Check and execute run-time commands
     if (sys.abort) { return; } // Check for system abort
   } while (plan_get_current_block() || (sys.state == STATE_CYCLE));
+  #ifdef QUEUE_ACCESSORY_CHANGES
+    spindle_apply_queued();
+    coolant_apply_queued();
+  #endif
 }
 
 
@@ -401,6 +530,13 @@ void protocol_exec_rt_system()
         } else {
           sys.suspend = SUSPEND_DISABLE;
           sys.state = STATE_IDLE;
+          #ifdef QUEUE_ACCESSORY_CHANGES
+            // Set spindle and coolant changes queued after the last motion, as a sync would have.
+            if (plan_get_current_block() == NULL) {
+              spindle_apply_queued();
+              coolant_apply_queued();
+            }
+          #endif
         }
       }
       system_clear_exec_state_flag(EXEC_CYCLE_STOP);
@@ -483,6 +619,17 @@ void protocol_exec_rt_system()
     }
   }
 
+  #ifdef ENABLE_POSITION_PUSH
+    push_execute();
+  #endif
+
+  #ifdef ENABLE_BINARY_STATUS_REPORT
+    if (sys_rt_exec_status_frame) {
+      sys_rt_exec_status_frame = false;
+      if (bit_istrue(settings.status_report_mask,BITFLAG_RT_STATUS_BINARY_FRAME)) { report_status_frame(); }
+    }
+  #endif
+
   #ifdef DEBUG
     if (sys_rt_exec_debug) {
       report_realtime_debug();
@@ -495,6 +642,9 @@ void protocol_exec_rt_system()
     st_prep_buffer();
   }
 
+  #ifdef CACHE_COORD_DATA
+    settings_write_behind(); // Persist changed coordinate data in the background.
+  #endif
 }
 
 
@@ -517,15 +667,22 @@ static void protocol_exec_rt_suspend()
     pl_data->line_number = PARKING_MOTION_LINE_NUMBER;
   #endif
 
+  // Accessory state of the running block. With QUEUE_ACCESSORY_CHANGES, the parser state is ahead
+  // of it, if spindle and coolant changes are queued with later blocks.
   plan_block_t *block = plan_get_current_block();
   uint8_t restore_condition;
   float restore_spindle_speed;
   if (block == NULL) {
+    #ifdef QUEUE_ACCESSORY_CHANGES
+      // Set changes queued after the last motion, as a sync would have. The parser state is current.
+      spindle_apply_queued();
+      coolant_apply_queued();
+    #endif
     restore_condition = (gc_state.modal.spindle | gc_state.modal.coolant);
     restore_spindle_speed = gc_state.spindle_speed;
   } else {
     restore_condition = block->condition;
-    restore_spindle_speed = block->spindle_speed;
+    restore_spindle_speed = plan_block_spindle_speed(block);
   }
   #ifdef DISABLE_LASER_DURING_HOLD
     if (bit_istrue(settings.flags,BITFLAG_LASER_MODE)) {
@@ -657,7 +814,11 @@ static void protocol_exec_rt_suspend()
             #endif
 
             // Delayed Tasks: Restart spindle and coolant, delay to power-up, then resume cycle.
-            if (gc_state.modal.spindle != SPINDLE_DISABLE) {
+            #ifdef QUEUE_ACCESSORY_CHANGES
+              if (restore_condition & (PL_COND_FLAG_SPINDLE_CW | PL_COND_FLAG_SPINDLE_CCW)) {
+            #else
+              if (gc_state.modal.spindle != SPINDLE_DISABLE) {
+            #endif
               // Block if safety door re-opened during prior restore actions.
               if (bit_isfalse(sys.suspend,SUSPEND_RESTART_RETRACT)) {
                 if (bit_istrue(settings.flags,BITFLAG_LASER_MODE)) {
@@ -669,11 +830,15 @@ static void protocol_exec_rt_suspend()
                 }
               }
             }
-            if (gc_state.modal.coolant != COOLANT_DISABLE) {
+            #ifdef QUEUE_ACCESSORY_CHANGES
+              if (restore_condition & (PL_COND_FLAG_COOLANT_FLOOD | PL_COND_FLAG_COOLANT_MIST)) {
+            #else
+              if (gc_state.modal.coolant != COOLANT_DISABLE) {
+            #endif
               // Block if safety door re-opened during prior restore actions.
               if (bit_isfalse(sys.suspend,SUSPEND_RESTART_RETRACT)) {
                 // NOTE: Laser mode will honor this delay. An exhaust system is often controlled by this pin.
-                coolant_set_state((restore_condition & (PL_COND_FLAG_COOLANT_FLOOD | PL_COND_FLAG_COOLANT_FLOOD)));
+                coolant_set_state((restore_condition & (PL_COND_FLAG_COOLANT_FLOOD | PL_COND_FLAG_COOLANT_MIST)));
                 delay_sec(SAFETY_DOOR_COOLANT_DELAY, DELAY_MODE_SYS_SUSPEND);
               }
             }
@@ -715,7 +880,11 @@ static void protocol_exec_rt_suspend()
         if (sys.spindle_stop_ovr) {
           // Handles beginning of spindle stop
           if (sys.spindle_stop_ovr & SPINDLE_STOP_OVR_INITIATE) {
-            if (gc_state.modal.spindle != SPINDLE_DISABLE) {
+            #ifdef QUEUE_ACCESSORY_CHANGES
+              if (restore_condition & (PL_COND_FLAG_SPINDLE_CW | PL_COND_FLAG_SPINDLE_CCW)) {
+            #else
+              if (gc_state.modal.spindle != SPINDLE_DISABLE) {
+            #endif
               spindle_set_state(SPINDLE_DISABLE,0.0); // De-energize
               sys.spindle_stop_ovr = SPINDLE_STOP_OVR_ENABLED; // Set stop override state to enabled, if de-energized.
             } else {
@@ -723,7 +892,11 @@ static void protocol_exec_rt_suspend()
             }
           // Handles restoring of spindle state
           } else if (sys.spindle_stop_ovr & (SPINDLE_STOP_OVR_RESTORE | SPINDLE_STOP_OVR_RESTORE_CYCLE)) {
-            if (gc_state.modal.spindle != SPINDLE_DISABLE) {
+            #ifdef QUEUE_ACCESSORY_CHANGES
+              if (restore_condition & (PL_COND_FLAG_SPINDLE_CW | PL_COND_FLAG_SPINDLE_CCW)) {
+            #else
+              if (gc_state.modal.spindle != SPINDLE_DISABLE) {
+            #endif
               report_feedback_message(MESSAGE_SPINDLE_RESTORE);
               if (bit_istrue(settings.flags,BITFLAG_LASER_MODE)) {
                 // When in laser mode, ignore spindle spin-up delay. Set to turn on laser when cycle starts.
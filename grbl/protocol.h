@@ -27,6 +27,14 @@
   #define LINE_BUFFER_SIZE 256
 #endif
 
+// Define line flags. Includes comment type tracking and line overflow detection.
+#define LINE_FLAG_OVERFLOW bit(0)
+#define LINE_FLAG_COMMENT_PARENTHESES bit(1)
+#define LINE_FLAG_COMMENT_SEMICOLON bit(2)
+#define LINE_FLAG_BINARY_FRAME bit(3)
+#define LINE_FLAG_FRAME_ESCAPE bit(4) // Next frame byte is escaped.
+#define LINE_FLAG_FRAME_RESYNC bit(5) // Frame cut short by the start of the next one.
+
 // Starts Grbl main loop. It handles all incoming characters from the serial port and executes
 // them as they complete. It is also responsible for finishing the initialization procedures.
 void protocol_main_loop();
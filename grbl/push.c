@@ -0,0 +1,126 @@
+/*
+  push.c - Pushes periodic position updates to the host
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.h"
+
+#ifdef ENABLE_POSITION_PUSH
+
+static uint8_t push_period; // Push period in timer ticks. Zero while disabled.
+static uint8_t push_ticks; // Ticks since the last push. Used by Timer2 ISR only.
+static volatile uint8_t push_due; // Set by Timer2 ISR when a push is due.
+static int32_t push_position[N_AXIS]; // Machine position in steps sent with the last push.
+static uint8_t push_keyframe_periods; // Push periods from one keyframe to the next
+static uint8_t push_keyframe_count; // Push periods left until the next keyframe. Zero sends one.
+
+
+// Initialization routine for the push timer.
+void push_init()
+{
+  // Configure Timer 2: Position push tick. CTC mode at PUSH_TICKS_PER_SECOND, with the
+  // compare interrupt enabled only while pushing.
+  TIMSK2 &= ~(1<<OCIE2A);
+  TCCR2A = (1<<WGM21);
+  TCCR2B = (1<<CS22)|(1<<CS20); // 1/128 prescaler
+  OCR2A = (F_CPU/128/PUSH_TICKS_PER_SECOND)-1;
+  push_period = 0;
+  push_due = false;
+}
+
+
+void push_set_period(uint8_t period)
+{
+  TIMSK2 &= ~(1<<OCIE2A);
+  push_period = period;
+  push_ticks = 0;
+  push_due = false;
+  push_keyframe_count = 0; // First push carries the whole position.
+  if (period) {
+    push_keyframe_periods = max(1, min(255, PUSH_KEYFRAME_TICKS/period));
+    TCNT2 = 0;
+    TIMSK2 |= (1<<OCIE2A);
+  }
+}
+
+
+// Counts push timer ticks and flags a push at the end of each period.
+ISR(TIMER2_COMPA_vect)
+{
+  if (++push_ticks >= push_period) {
+    push_ticks = 0;
+    push_due = true;
+  }
+}
+
+
+// Sends the motion since the last push as one delta per axis, in steps. Each delta is zigzag
+// encoded and sent as a base-128 varint, like the values of binary g-code frames, so a machine
+// at rest or creeping along takes a byte per axis. No frame is sent while the machine is still.
+// Every PUSH_KEYFRAME_TICKS, a keyframe sends the whole position instead, so a host that lost a
+// frame recovers the position.
+void push_execute()
+{
+  if (!push_due) { return; }
+  push_due = false;
+  uint8_t keyframe = (push_keyframe_count == 0);
+  if (!keyframe) { push_keyframe_count--; }
+
+  int32_t position[N_AXIS];
+  memcpy(position, sys_position, sizeof(sys_position));
+  uint8_t frame[4+5*N_AXIS];
+  uint8_t length = 2; // Frame index. Payload starts behind the start and length bytes.
+  uint8_t moved = false;
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    int32_t delta = position[idx];
+    if (!keyframe) { delta -= push_position[idx]; }
+    uint32_t value = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+    if (value) { moved = true; }
+    while (value > 0x7f) {
+      frame[length++] = (value & 0x7f) | 0x80;
+      value >>= 7;
+    }
+    frame[length++] = value;
+  }
+  if (!(moved || keyframe)) { return; }
+
+  // Skip this push rather than wait for a full TX buffer. The next push carries its motion.
+  if ((TX_BUFFER_SIZE - serial_get_tx_buffer_count()) < (length+2)) { return; }
+  memcpy(push_position, position, sizeof(position));
+
+  if (keyframe) {
+    push_keyframe_count = push_keyframe_periods-1;
+    frame[0] = PUSH_KEYFRAME_START;
+  } else {
+    frame[0] = PUSH_FRAME_START;
+  }
+  frame[1] = length-2;
+  uint16_t crc = 0xffff;
+  for (idx=1; idx<length; idx++) { crc = _crc_xmodem_update(crc, frame[idx]); }
+  frame[length++] = crc >> 8;
+  frame[length++] = crc & 0xff;
+
+  #ifdef BATCH_REPORT_TX
+    serial_begin_batch();
+  #endif
+  for (idx=0; idx<length; idx++) { serial_write(frame[idx]); }
+  #ifdef BATCH_REPORT_TX
+    serial_end_batch();
+  #endif
+}
+
+#endif
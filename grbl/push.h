@@ -0,0 +1,43 @@
+/*
+  push.h - Pushes periodic position updates to the host
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef push_h
+#define push_h
+
+#include "grbl.h"
+
+// Position push frame: start byte, payload length, payload and CRC-16, high byte first. Framed
+// like the binary status frame.
+#define PUSH_FRAME_START 0x03
+#define PUSH_KEYFRAME_START 0x04 // Same layout, carrying the whole position instead of the motion.
+#define PUSH_TICKS_PER_SECOND 1000 // Timer2 tick rate. The push period is set in ticks.
+#ifndef PUSH_KEYFRAME_TICKS
+  #define PUSH_KEYFRAME_TICKS 1000 // Time between keyframes, sent even while the machine is still.
+#endif
+
+
+// Initialize the push timer. Pushing is disabled until enabled by push_set_period().
+void push_init();
+
+// Sets the push period in milliseconds and starts with a keyframe. Zero disables.
+void push_set_period(uint8_t period);
+
+// Sends a position push frame, if one is due. Called by the realtime executor.
+void push_execute();
+
+#endif
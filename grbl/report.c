@@ -37,6 +37,17 @@ static void report_util_feedback_line_feed() { serial_write(']'); report_util_li
 static void report_util_gcode_modes_G() { printPgmString(PSTR(" G")); }
 static void report_util_gcode_modes_M() { printPgmString(PSTR(" M")); }
 // static void report_util_comment_line_feed() { serial_write(')'); report_util_line_feed(); }
+#ifdef PARSE_LINES_IN_RX_BUFFER
+  // Prints a line, or the stored line read in place for a NULL line. See line_get_char().
+  static void report_util_line(char *line)
+  {
+    uint8_t idx = 0;
+    char c;
+    while ((c = line_get_char(line, idx++)) != 0) { serial_write(c); }
+  }
+#else
+  #define report_util_line(line) printString(line)
+#endif
 
 static void report_util_axis_values(float *axis_value) {
 
@@ -141,6 +152,7 @@ static void report_util_setting_string(uint8_t n) {
     case 25: printPgmString(PSTR("hm seek")); break;
     case 26: printPgmString(PSTR("hm delay")); break;
     case 27: printPgmString(PSTR("hm pulloff")); break;
+    case 28: printPgmString(PSTR("jerk")); break;
     case 30: printPgmString(PSTR("rpm max")); break;
     case 31: printPgmString(PSTR("rpm min")); break;
     case 32: printPgmString(PSTR("laser")); break;
@@ -174,6 +186,21 @@ static void report_util_float_setting(uint8_t n, float val, uint8_t n_decimal) {
   printFloat(val,n_decimal);
   report_util_line_feed(); // report_util_setting_string(n);
 }
+#ifdef SEGMENT_BUFFER_STATS
+  // Prints the segment buffer counter values, as in the status report field.
+  static void report_util_segment_buffer_stats()
+  {
+    st_buffer_stats_t stats;
+    st_get_buffer_stats(&stats);
+    print_uint32_base10(stats.underruns);
+    serial_write(',');
+    print_uint32_base10(stats.near_underruns);
+    serial_write(',');
+    print_uint8_base10(stats.low_water);
+    serial_write(',');
+    print_uint32_base10(stats.planner_starved);
+  }
+#endif
 
 
 // Handles the primary confirmation protocol response for streaming interfaces and human-feedback.
@@ -184,6 +211,9 @@ static void report_util_float_setting(uint8_t n, float val, uint8_t n_decimal) {
 // responses.
 void report_status_message(uint8_t status_code)
 {
+  #ifdef BATCH_REPORT_TX
+    serial_begin_batch();
+  #endif
   switch(status_code) {
     case STATUS_OK: // STATUS_OK
       printPgmString(PSTR("ok\r\n")); break;
@@ -192,6 +222,9 @@ void report_status_message(uint8_t status_code)
       print_uint8_base10(status_code);
       report_util_line_feed();
   }
+  #ifdef BATCH_REPORT_TX
+    serial_end_batch();
+  #endif
 }
 
 // Prints alarm messages.
@@ -274,6 +307,9 @@ void report_grbl_settings() {
   report_util_float_setting(25,settings.homing_seek_rate,N_DECIMAL_SETTINGVALUE);
   report_util_uint8_setting(26,settings.homing_debounce_delay);
   report_util_float_setting(27,settings.homing_pulloff,N_DECIMAL_SETTINGVALUE);
+  #ifdef S_CURVE_ACCELERATION
+    report_util_float_setting(28,settings.jerk/(60*60*60),N_DECIMAL_SETTINGVALUE);
+  #endif
   report_util_float_setting(30,settings.rpm_max,N_DECIMAL_RPMVALUE);
   report_util_float_setting(31,settings.rpm_min,N_DECIMAL_RPMVALUE);
   report_util_uint8_setting(32,bit_istrue(settings.flags,BITFLAG_LASER_MODE));
@@ -336,6 +372,19 @@ void report_ngc_parameters()
   printPgmString(PSTR("[TLO:")); // Print tool length offset value
   printFloat_CoordValue(gc_state.tool_length_offset);
   report_util_feedback_line_feed();
+  #ifdef TOOL_TABLE
+    tool_data_t tool_data;
+    for (coord_select = 1; coord_select <= N_TOOL_TABLE; coord_select++) {
+      settings_read_tool_data(coord_select,&tool_data);
+      printPgmString(PSTR("[T")); // Print tool table entry length and diameter
+      print_uint8_base10(coord_select);
+      serial_write(':');
+      printFloat_CoordValue(tool_data.length);
+      serial_write(',');
+      printFloat_CoordValue(tool_data.diameter);
+      report_util_feedback_line_feed();
+    }
+  #endif
   report_probe_parameters(); // Print probe parameters. Not persistent in memory.
 }
 
@@ -416,14 +465,14 @@ void report_startup_line(uint8_t n, char *line)
   printPgmString(PSTR("$N"));
   print_uint8_base10(n);
   serial_write('=');
-  printString(line);
+  report_util_line(line);
   report_util_line_feed();
 }
 
 void report_execute_startup_message(char *line, uint8_t status_code)
 {
   serial_write('>');
-  printString(line);
+  report_util_line(line);
   serial_write(':');
   report_status_message(status_code);
 }
@@ -436,7 +485,7 @@ void report_build_info(char *line)
   #endif
 
   printPgmString(PSTR("[VER:" GRBL_VERSION "." GRBL_VERSION_BUILD ":"));
-  printString(line);
+  report_util_line(line);
   report_util_feedback_line_feed();
   printPgmString(PSTR("[AXS:"));
   print_uint8_base10(N_AXIS);
@@ -590,6 +639,9 @@ void report_echo_line_received(char *line)
  // especially during g-code programs with fast, short line segments and high frequency reports (5-20Hz).
 void report_realtime_status()
 {
+  #ifdef BATCH_REPORT_TX
+    serial_begin_batch(); // Render the report in RAM. Sent in one block at its end.
+  #endif
   uint8_t idx;
   int32_t current_position[N_AXIS]; // Copy current state of the system position variable
   memcpy(current_position,sys_position,sizeof(sys_position));
@@ -662,6 +714,11 @@ void report_realtime_status()
     }
   #endif
 
+  #ifdef REPORT_FIELD_SEGMENT_BUFFER_STATS
+    printPgmString(PSTR("|Sb:"));
+    report_util_segment_buffer_stats();
+  #endif
+
   #ifdef REPORT_FIELD_LINE_NUMBERS
     // Report current line number
     plan_block_t * cur_block = plan_get_current_block();
@@ -759,9 +816,134 @@ void report_realtime_status()
 
   serial_write('>');
   report_util_line_feed();
+  #ifdef BATCH_REPORT_TX
+    serial_end_batch();
+  #endif
 }
 
 
+#ifdef ENABLE_BINARY_STATUS_REPORT
+  void report_status_frame()
+  {
+    uint8_t frame[STATUS_FRAME_PAYLOAD_SIZE+4];
+    frame[0] = STATUS_FRAME_START;
+    frame[1] = STATUS_FRAME_PAYLOAD_SIZE;
+    frame[2] = sys.state;
+    frame[3] = sys.suspend;
+    memcpy(&frame[4], sys_position, sizeof(sys_position)); // Steps per axis. Little-endian int32.
+    uint8_t idx = 4+sizeof(sys_position);
+    frame[idx++] = plan_get_block_buffer_available();
+    frame[idx++] = serial_get_rx_buffer_available();
+    frame[idx++] = sys.f_override;
+    frame[idx++] = sys.r_override;
+    frame[idx++] = sys.spindle_speed_ovr;
+    frame[idx++] = spindle_get_state() | (coolant_get_state() << 2);
+    frame[idx++] = limits_get_state();
+    frame[idx] = system_control_get_state();
+    if (probe_get_state()) { frame[idx] |= bit(7); }
+
+    // CRC-16 of the length byte and payload, as for binary g-code frames.
+    uint16_t crc = 0xffff;
+    for (idx=1; idx<STATUS_FRAME_PAYLOAD_SIZE+2; idx++) { crc = _crc_xmodem_update(crc, frame[idx]); }
+    frame[idx++] = crc >> 8;
+    frame[idx] = crc & 0xff;
+
+    #ifdef BATCH_REPORT_TX
+      serial_begin_batch();
+    #endif
+    for (idx=0; idx<STATUS_FRAME_PAYLOAD_SIZE+4; idx++) { serial_write(frame[idx]); }
+    #ifdef BATCH_REPORT_TX
+      serial_end_batch();
+    #endif
+  }
+#endif
+
+
+#ifdef STEPPER_ISR_PROFILE
+  // Prints the stepper interrupt cost profile in CPU cycles. One line per bucket with recorded
+  // calls: [ISR:<bucket>:<count>,<min>,<avg>,<max>:<histogram bins>]
+  void report_stepper_isr_profile()
+  {
+    st_profile_t profile;
+    uint8_t bucket, idx;
+    for (bucket = 0; bucket < ST_PROFILE_BUCKETS; bucket++) {
+      st_profile_get(bucket, &profile);
+      if (profile.count == 0) { continue; }
+      printPgmString(PSTR("[ISR:"));
+      if (bucket == ST_PROFILE_IDLE) { printPgmString(PSTR("IDLE")); }
+      else if (bucket == ST_PROFILE_PORT_RESET) { printPgmString(PSTR("PRST")); }
+      else {
+        switch (bucket/ST_PROFILE_LEVELS) {
+          case ST_PROFILE_LOAD_NONE: printPgmString(PSTR("STEP")); break;
+          case ST_PROFILE_LOAD_SEGMENT: printPgmString(PSTR("SEG")); break;
+          default: printPgmString(PSTR("BLK")); break;
+        }
+        print_uint8_base10(bucket % ST_PROFILE_LEVELS); // AMASS level
+      }
+      serial_write(':');
+      print_uint32_base10(profile.count);
+      serial_write(',');
+      print_uint32_base10(profile.min);
+      serial_write(',');
+      print_uint32_base10((((uint64_t)profile.cycles_high << 32) | profile.cycles)/profile.count);
+      serial_write(',');
+      print_uint32_base10(profile.max);
+      serial_write(':');
+      for (idx = 0; idx < ST_PROFILE_BINS; idx++) {
+        if (idx) { serial_write(','); }
+        print_uint32_base10(profile.histogram[idx]);
+      }
+      report_util_feedback_line_feed();
+    }
+    printPgmString(PSTR("[ISR:BUSY:"));
+    print_uint32_base10(st_profile_get_overruns());
+    report_util_feedback_line_feed();
+  }
+#endif
+
+
+#ifdef STEPPER_TRACE
+  // Prints the step event trace, oldest record first. One line per record:
+  // [TRC:<time>:<event>:<level>,<cycles per tick>,<queued>]
+  void report_stepper_trace()
+  {
+    st_trace_t record;
+    uint8_t idx = 0;
+    while (st_trace_get(idx++, &record)) {
+      printPgmString(PSTR("[TRC:"));
+      print_uint32_base10(record.time);
+      serial_write(':');
+      switch (record.event) {
+        case ST_TRACE_SEGMENT: printPgmString(PSTR("SEG")); break;
+        case ST_TRACE_AMASS: printPgmString(PSTR("AMS")); break;
+        case ST_TRACE_BLOCK: printPgmString(PSTR("BLK")); break;
+        case ST_TRACE_IDLE: printPgmString(PSTR("IDLE")); break;
+        default: printPgmString(PSTR("UNDR")); break;
+      }
+      serial_write(':');
+      print_uint8_base10(record.level);
+      serial_write(',');
+      print_uint32_base10(record.cycles_per_tick);
+      serial_write(',');
+      print_uint8_base10(record.queued);
+      report_util_feedback_line_feed();
+    }
+  }
+#endif
+
+
+#ifdef SEGMENT_BUFFER_STATS
+  // Prints the segment buffer counters:
+  // [SBUF:<underruns>,<near underruns>,<low-water mark>,<planner starved>]
+  void report_segment_buffer_stats()
+  {
+    printPgmString(PSTR("[SBUF:"));
+    report_util_segment_buffer_stats();
+    report_util_feedback_line_feed();
+  }
+#endif
+
+
 #ifdef DEBUG
   void report_realtime_debug()
   {
@@ -39,6 +39,8 @@
 #define STATUS_TRAVEL_EXCEEDED 15
 #define STATUS_INVALID_JOG_COMMAND 16
 #define STATUS_SETTING_DISABLED_LASER 17
+#define STATUS_FRAME_CRC_ERROR 18
+#define STATUS_SETTING_WRITE_FAIL 19
 
 #define STATUS_GCODE_UNSUPPORTED_COMMAND 20
 #define STATUS_GCODE_MODAL_GROUP_VIOLATION 21
@@ -108,6 +110,16 @@ void report_echo_line_received(char *line);
 // Prints realtime status report
 void report_realtime_status();
 
+#ifdef ENABLE_BINARY_STATUS_REPORT
+  // Binary status frame: start byte, payload length, payload and CRC-16, high byte first. Framed
+  // like the binary g-code frames Grbl receives.
+  #define STATUS_FRAME_START 0x02
+  #define STATUS_FRAME_PAYLOAD_SIZE (10+4*N_AXIS)
+
+  // Prints the realtime status as a binary frame.
+  void report_status_frame();
+#endif
+
 // Prints recorded probe position
 void report_probe_parameters();
 
@@ -124,6 +136,21 @@ void report_execute_startup_message(char *line, uint8_t status_code);
 // Prints build info and user info
 void report_build_info(char *line);
 
+#ifdef STEPPER_ISR_PROFILE
+  // Prints the stepper interrupt cost profile
+  void report_stepper_isr_profile();
+#endif
+
+#ifdef STEPPER_TRACE
+  // Prints the step event trace
+  void report_stepper_trace();
+#endif
+
+#ifdef SEGMENT_BUFFER_STATS
+  // Prints the segment buffer counters
+  void report_segment_buffer_stats();
+#endif
+
 #ifdef DEBUG
   void report_realtime_debug();
 #endif
@@ -33,13 +33,49 @@ uint8_t serial_tx_buffer[TX_RING_BUFFER];
 uint8_t serial_tx_buffer_head = 0;
 volatile uint8_t serial_tx_buffer_tail = 0;
 
+#ifdef BATCH_REPORT_TX
+  static uint8_t serial_tx_batch[TX_BATCH_SIZE];
+  static uint8_t serial_tx_batch_count = 0;
+  static uint8_t serial_tx_batch_open = false;
+#endif
+
+#ifdef PARSE_LINES_IN_RX_BUFFER
+  // The line being received is filtered in place. Bytes from the tail up to serial_rx_line_end
+  // are the filtered line, and bytes from serial_rx_line_read up to the head are still to be read.
+  // A ring buffer of 256 bytes lets the uint8_t indices wrap around on their own.
+  uint8_t serial_rx_line_read = 0;
+  uint8_t serial_rx_line_end = 0;
+#endif
+
+#ifdef ASSEMBLE_LINES_IN_RX_ISR
+  // The RX interrupt filters each line into the read buffer behind the head, after a byte reserved
+  // for its length. The line is published by writing its length and advancing the head past it.
+  // Lines longer than the read buffer or the line buffer are published with SERIAL_LINE_OVERFLOW.
+  #define SERIAL_LINE_OVERFLOW 0xff
+  uint8_t serial_rx_line_write = 1; // Next byte of the line being filtered. Used by RX ISR only.
+  uint8_t serial_rx_line_length = 0;
+  uint8_t serial_rx_line_flags = 0;
+#endif
+
+#ifdef ENABLE_BINARY_GCODE
+  volatile uint8_t serial_rx_frames_enabled = false;
+#endif
+
 
 // Returns the number of bytes available in the RX serial buffer.
 uint8_t serial_get_rx_buffer_available()
 {
   uint8_t rtail = serial_rx_buffer_tail; // Copy to limit multiple calls to volatile
-  if (serial_rx_buffer_head >= rtail) { return(RX_BUFFER_SIZE - (serial_rx_buffer_head-rtail)); }
-  return((rtail-serial_rx_buffer_head-1));
+  #ifdef ASSEMBLE_LINES_IN_RX_ISR
+    // Count the line being filtered past the head too. Its reserved length byte is not counted,
+    // since the line's end takes its place.
+    uint8_t rhead = serial_rx_line_write;
+    rhead = (rhead ? rhead : RX_RING_BUFFER) - 1;
+  #else
+    uint8_t rhead = serial_rx_buffer_head;
+  #endif
+  if (rhead >= rtail) { return(RX_BUFFER_SIZE - (rhead-rtail)); }
+  return((rtail-rhead-1));
 }
 
 
@@ -49,7 +85,7 @@ uint8_t serial_get_rx_buffer_count()
 {
   uint8_t rtail = serial_rx_buffer_tail; // Copy to limit multiple calls to volatile
   if (serial_rx_buffer_head >= rtail) { return(serial_rx_buffer_head-rtail); }
-  return (RX_BUFFER_SIZE - (rtail-serial_rx_buffer_head));
+  return (RX_RING_BUFFER - (rtail-serial_rx_buffer_head));
 }
 
 
@@ -83,8 +119,57 @@ void serial_init()
 }
 
 
+#ifdef BATCH_REPORT_TX
+  // Copies the scratch buffer into the TX serial buffer, waiting for room for all of it, then
+  // publishes it with a single head update.
+  static void serial_commit_batch()
+  {
+    uint8_t count = serial_tx_batch_count;
+    serial_tx_batch_count = 0;
+    if (count == 0) { return; }
+
+    // Wait until there is space in the buffer
+    while ((TX_BUFFER_SIZE - serial_get_tx_buffer_count()) < count) {
+      if (sys_rt_exec_state & EXEC_RESET) { return; } // Only check for abort to avoid an endless loop.
+    }
+
+    // Copy in at most two pieces, when the block wraps around the end of the buffer. In 16 bits,
+    // since the ring may be 256 bytes long.
+    uint16_t head = serial_tx_buffer_head;
+    uint16_t first = TX_RING_BUFFER-head;
+    if (first > count) { first = count; }
+    memcpy(&serial_tx_buffer[head], serial_tx_batch, first);
+    memcpy(serial_tx_buffer, &serial_tx_batch[first], count-first);
+    head += count;
+    if (head >= TX_RING_BUFFER) { head -= TX_RING_BUFFER; }
+    serial_tx_buffer_head = head;
+
+    // Enable Data Register Empty Interrupt to make sure tx-streaming is running
+    UCSR0B |=  (1 << UDRIE0);
+  }
+
+
+  void serial_begin_batch() { serial_tx_batch_open = true; }
+
+
+  void serial_end_batch()
+  {
+    serial_tx_batch_open = false;
+    serial_commit_batch();
+  }
+#endif
+
+
 // Writes one byte to the TX serial buffer. Called by main program.
 void serial_write(uint8_t data) {
+  #ifdef BATCH_REPORT_TX
+    if (serial_tx_batch_open) {
+      if (serial_tx_batch_count == TX_BATCH_SIZE) { serial_commit_batch(); }
+      serial_tx_batch[serial_tx_batch_count++] = data;
+      return;
+    }
+  #endif
+
   // Calculate next head
   uint8_t next_head = serial_tx_buffer_head + 1;
   if (next_head == TX_RING_BUFFER) { next_head = 0; }
@@ -141,10 +226,126 @@ uint8_t serial_read()
 }
 
 
+#ifdef PARSE_LINES_IN_RX_BUFFER
+  uint8_t serial_read_line_byte()
+  {
+    uint8_t read = serial_rx_line_read;
+    if (serial_rx_buffer_head == read) { return SERIAL_NO_DATA; }
+    serial_rx_line_read = read+1;
+    return serial_rx_buffer[read];
+  }
+
+
+  void serial_write_line_byte(uint8_t data) { serial_rx_buffer[serial_rx_line_end++] = data; }
+
+
+  uint8_t serial_get_line_start() { return serial_rx_buffer_tail; }
+
+
+  void serial_release_line()
+  {
+    serial_rx_line_end = serial_rx_line_read;
+    serial_rx_buffer_tail = serial_rx_line_read;
+  }
+#endif
+
+
+#ifdef ASSEMBLE_LINES_IN_RX_ISR
+  uint8_t serial_read_line(char *line)
+  {
+    uint8_t tail = serial_rx_buffer_tail; // Temporary serial_rx_buffer_tail (to optimize for volatile)
+    if (serial_rx_buffer_head == tail) { return SERIAL_NO_DATA; }
+    uint8_t length = serial_rx_buffer[tail];
+    uint8_t status = STATUS_OK;
+    if (length == SERIAL_LINE_OVERFLOW) {
+      length = 0;
+      status = STATUS_OVERFLOW;
+    }
+    if (++tail == RX_RING_BUFFER) { tail = 0; }
+
+    // Copy the line in at most two pieces, when it wraps around the end of the buffer.
+    uint8_t count = RX_RING_BUFFER-tail;
+    if (count > length) { count = length; }
+    memcpy(line, &serial_rx_buffer[tail], count);
+    memcpy(&line[count], serial_rx_buffer, length-count);
+    line[length] = 0;
+
+    tail += length;
+    if (tail >= RX_RING_BUFFER) { tail -= RX_RING_BUFFER; }
+    serial_rx_buffer_tail = tail;
+    return status;
+  }
+
+
+  // Filters a received character into the line being assembled, the same way protocol_main_loop()
+  // does, and publishes the line at its end. Called by RX ISR only.
+  static void serial_filter_line_byte(uint8_t data)
+  {
+    uint8_t next;
+    if ((data == '\n') || (data == '\r')) { // End of line reached
+      uint8_t head = serial_rx_buffer_head;
+      if (serial_rx_line_flags & LINE_FLAG_OVERFLOW) {
+        serial_rx_line_length = SERIAL_LINE_OVERFLOW; // Publish the length byte only.
+        next = head+1;
+        if (next == RX_RING_BUFFER) { next = 0; }
+      } else {
+        next = serial_rx_line_write;
+      }
+      // Only a sender ignoring the free buffer space can leave no room for the length byte. The
+      // line is then lost, like its characters would be otherwise.
+      if (next != serial_rx_buffer_tail) {
+        serial_rx_buffer[head] = serial_rx_line_length;
+        serial_rx_buffer_head = next;
+        head = next;
+      }
+      next = head+1;
+      if (next == RX_RING_BUFFER) { next = 0; }
+      serial_rx_line_write = next;
+      serial_rx_line_length = 0;
+      serial_rx_line_flags = 0;
+    } else if (serial_rx_line_flags) {
+      // Throw away all (except EOL) comment characters and overflow characters.
+      if ((data == ')') && (serial_rx_line_flags & LINE_FLAG_COMMENT_PARENTHESES)) {
+        serial_rx_line_flags &= ~(LINE_FLAG_COMMENT_PARENTHESES); // End of '()' comment.
+      }
+    } else if ((data <= ' ') || (data == '/')) {
+      // Throw away whitepace and control characters. Block delete is not supported.
+    } else if (data == '(') {
+      serial_rx_line_flags |= LINE_FLAG_COMMENT_PARENTHESES;
+    } else if (data == ';') {
+      serial_rx_line_flags |= LINE_FLAG_COMMENT_SEMICOLON;
+    } else {
+      next = serial_rx_line_write + 1;
+      if (next == RX_RING_BUFFER) { next = 0; }
+      // Overflow the line unless the character and the line's end fit in both buffers.
+      if ((serial_rx_line_length >= (LINE_BUFFER_SIZE-1)) || (serial_rx_line_write == serial_rx_buffer_tail) ||
+          (next == serial_rx_buffer_tail)) {
+        serial_rx_line_flags |= LINE_FLAG_OVERFLOW;
+      } else {
+        if (data >= 'a' && data <= 'z') { data = data-'a'+'A'; } // Upcase lowercase
+        serial_rx_buffer[serial_rx_line_write] = data;
+        serial_rx_line_write = next;
+        serial_rx_line_length++;
+      }
+    }
+  }
+#endif
+
+
+#ifdef ENABLE_BINARY_GCODE
+  void serial_enable_binary_frames(uint8_t enable) { serial_rx_frames_enabled = enable; }
+
+  // Binary frames escape all of their bytes that could be realtime commands. Their bytes from
+  // SERIAL_FRAME_ESCAPED_MIN up are kept, once frames are enabled.
+  #define serial_rx_is_command(data) ((data > 0x7F) && ((data < SERIAL_FRAME_ESCAPED_MIN) || !serial_rx_frames_enabled))
+#else
+  #define serial_rx_is_command(data) (data > 0x7F)
+#endif
+
+
 ISR(SERIAL_RX)
 {
   uint8_t data = UDR0;
-  uint8_t next_head;
 
   // Pick off realtime command characters directly from the serial stream. These characters are
   // not passed into the main buffer, but these set system state flag bits for realtime execution.
@@ -154,7 +355,7 @@ ISR(SERIAL_RX)
     case CMD_CYCLE_START:   system_set_exec_state_flag(EXEC_CYCLE_START); break; // Set as true
     case CMD_FEED_HOLD:     system_set_exec_state_flag(EXEC_FEED_HOLD); break; // Set as true
     default :
-      if (data > 0x7F) { // Real-time control characters are extended ACSII only.
+      if (serial_rx_is_command(data)) { // Real-time control characters are extended ACSII only.
         switch(data) {
           case CMD_SAFETY_DOOR:   system_set_exec_state_flag(EXEC_SAFETY_DOOR); break; // Set as true
           case CMD_JOG_CANCEL:
@@ -163,6 +364,9 @@ ISR(SERIAL_RX)
               serial_reset_read_buffer(); // Vide un reste éventuel de données dans le buffer
             }
             break;
+          #ifdef ENABLE_BINARY_STATUS_REPORT
+            case CMD_BINARY_STATUS_REPORT: sys_rt_exec_status_frame = true; break;
+          #endif
           #ifdef DEBUG
             case CMD_DEBUG_REPORT: {uint8_t sreg = SREG; cli(); bit_true(sys_rt_exec_debug,EXEC_DEBUG_REPORT); SREG = sreg;} break;
           #endif
@@ -185,7 +389,10 @@ ISR(SERIAL_RX)
         }
         // Throw away any unfound extended-ASCII character by not passing it to the serial buffer.
       } else { // Write character to buffer
-        next_head = serial_rx_buffer_head + 1;
+        #ifdef ASSEMBLE_LINES_IN_RX_ISR
+          serial_filter_line_byte(data);
+        #else
+        uint8_t next_head = serial_rx_buffer_head + 1;
         if (next_head == RX_RING_BUFFER) { next_head = 0; }
 
         // Write data to buffer unless it is full.
@@ -193,6 +400,7 @@ ISR(SERIAL_RX)
           serial_rx_buffer[serial_rx_buffer_head] = data;
           serial_rx_buffer_head = next_head;
         }
+        #endif
       }
   }
 }
@@ -200,7 +408,23 @@ ISR(SERIAL_RX)
 
 void serial_reset_read_buffer()
 {
+  // Atomic, so the RX ISR does not fill in a line between resetting the pointers it works from.
+  uint8_t sreg = SREG;
+  cli();
   serial_rx_buffer_tail = serial_rx_buffer_head;
+  #ifdef PARSE_LINES_IN_RX_BUFFER
+    serial_rx_line_read = serial_rx_buffer_head;
+    serial_rx_line_end = serial_rx_buffer_head;
+  #endif
+  #ifdef ASSEMBLE_LINES_IN_RX_ISR
+    // Discard the line being filtered too. Its remaining characters start a new line.
+    uint8_t next = serial_rx_buffer_head + 1;
+    if (next == RX_RING_BUFFER) { next = 0; }
+    serial_rx_line_write = next;
+    serial_rx_line_length = 0;
+    serial_rx_line_flags = 0;
+  #endif
+  SREG = sreg;
 }
 
 
@@ -30,14 +30,38 @@
   #define TX_BUFFER_SIZE 255
 #endif
 
+#ifdef BATCH_REPORT_TX
+  #ifndef TX_BATCH_SIZE
+    #define TX_BATCH_SIZE 128 // Scratch buffer a batch is rendered into. Fits a full status report.
+  #endif
+#endif
+
 #define SERIAL_NO_DATA 0xff
 
+#ifdef ENABLE_BINARY_GCODE
+  // Binary g-code frame: start byte, payload length, payload and CRC-16, high byte first. After the
+  // start byte, the frame start, line ends, escape byte, realtime commands and all of 0x80-0xBF are
+  // sent as the escape byte followed by the byte XOR SERIAL_FRAME_ESCAPE_XOR.
+  #define SERIAL_FRAME_START 0x02
+  #define SERIAL_FRAME_OVERHEAD 4 // Bytes besides the payload.
+  #define SERIAL_FRAME_ESCAPE 0x1b
+  #define SERIAL_FRAME_ESCAPE_XOR 0x40
+  #define SERIAL_FRAME_ESCAPED_MIN 0xc0 // Extended-ASCII bytes from here up are never realtime commands.
+#endif
+
 
 void serial_init();
 
 // Writes one byte to the TX serial buffer. Called by main program.
 void serial_write(uint8_t data);
 
+#ifdef BATCH_REPORT_TX
+  // Collects the bytes written by serial_write() in a scratch buffer, until serial_end_batch()
+  // commits them to the TX serial buffer in one block. A full scratch buffer is committed early.
+  void serial_begin_batch();
+  void serial_end_batch();
+#endif
+
 // Write à string to the TX serial buffer. (for debugging)
 void serial_putstring(char* StringPtr);
 
@@ -47,6 +71,38 @@ uint8_t serial_read();
 // Reset and empty data in read buffer. Used by e-stop and reset.
 void serial_reset_read_buffer();
 
+#ifdef PARSE_LINES_IN_RX_BUFFER
+  // The read buffer. A line parsed in place is read from it, starting at serial_get_line_start().
+  extern uint8_t serial_rx_buffer[];
+
+  // Fetches the next byte of the line being received, without releasing its space in the read
+  // buffer. Called by main program.
+  uint8_t serial_read_line_byte();
+
+  // Writes a filtered byte of the line back into the read buffer, behind the bytes still to be
+  // read. Called by main program.
+  void serial_write_line_byte(uint8_t data);
+
+  // Returns the read buffer index of the first byte of the line. Its index wraps at the end.
+  uint8_t serial_get_line_start();
+
+  // Releases the read buffer space of the line, once executed or discarded.
+  void serial_release_line();
+#endif
+
+#ifdef ASSEMBLE_LINES_IN_RX_ISR
+  // Fetches the next line filtered by the RX interrupt into line, zero-terminated. Returns
+  // SERIAL_NO_DATA if no line is complete, STATUS_OVERFLOW if the line was too long to buffer, or
+  // STATUS_OK. Called by main program.
+  uint8_t serial_read_line(char *line);
+#endif
+
+#ifdef ENABLE_BINARY_GCODE
+  // Enables or disables keeping the extended-ASCII bytes of binary g-code frames, from
+  // SERIAL_FRAME_ESCAPED_MIN up, in the RX buffer. Otherwise they are thrown away.
+  void serial_enable_binary_frames(uint8_t enable);
+#endif
+
 // Returns the number of bytes available in the RX serial buffer.
 uint8_t serial_get_rx_buffer_available();
 
@@ -23,45 +23,334 @@
 #include "grbl.h"
 
 settings_t settings;
+settings_inverse_t settings_inverse;
+
+#ifdef CACHE_COORD_DATA
+  // Work coordinate systems and the G28 and G30 positions. Loaded from EEPROM once by
+  // settings_init() and written back a byte at a time by settings_write_behind().
+  static float coord_cache[SETTING_INDEX_NCOORD+1][N_AXIS];
+  static uint8_t coord_read_fail; // Vectors with a bad EEPROM checksum, failed by their next read.
+  static uint8_t coord_dirty;     // Vectors not yet written to EEPROM since they last changed.
+  static uint8_t coord_write_select;   // Vector being written
+  static uint8_t coord_write_index;    // Next byte of it to write. Zero when none is in progress.
+  static uint8_t coord_write_checksum;
+#endif
+
+#ifdef TOOL_TABLE
+  static tool_data_t tool_table[N_TOOL_TABLE]; // Loaded from EEPROM once by settings_init().
+#endif
+
+#ifdef PARSE_LINES_IN_RX_BUFFER
+  // Stored line opened by reading it into a NULL line, and read in place by settings_line_char().
+  #ifdef JOURNALED_SETTINGS
+    #define SETTINGS_LINE_CHUNK_SIZE 16 // Bytes of the record copied at a time. Power of two.
+    #define SETTINGS_LINE_NO_CHUNK 0xff  // Never a chunk offset.
+    static uint8_t settings_line_id;
+    static uint8_t settings_line_offset; // Offset of the copied chunk
+    static char settings_line_chunk[SETTINGS_LINE_CHUNK_SIZE];
+  #else
+    static uint16_t settings_line_addr;
+  #endif
+#endif
+
+
+#ifdef JOURNALED_SETTINGS
+  // Stores a line from line[line_start] as a record without its terminator.
+  static uint8_t settings_write_line(uint8_t id, char *line, uint8_t line_start)
+  {
+    uint8_t length = 0;
+    while (line[(uint8_t)(line_start+length)] != 0) { length++; }
+    return(journal_write_at(id, line, line_start, length));
+  }
+#else
+  // Stores a line from line[line_start] like memcpy_to_eeprom_with_checksum(), zero-filled after
+  // its terminator to LINE_BUFFER_SIZE bytes.
+  static uint8_t settings_write_line(uint16_t addr, char *line, uint8_t line_start)
+  {
+    unsigned char checksum = 0;
+    char c = 1;
+    uint16_t idx;
+    for (idx=0; idx < LINE_BUFFER_SIZE; idx++) {
+      if (c) { c = line[(uint8_t)(line_start+idx)]; }
+      checksum = (checksum != 0); // As (checksum << 1) || (checksum >> 7) evaluates in eeprom.c
+      checksum += c;
+      eeprom_put_char(addr++, c);
+    }
+    eeprom_put_char(addr, checksum);
+    return(STATUS_OK);
+  }
+#endif
+
+
+// Copies a stored line, a journal record id or an EEPROM address, into line. With
+// PARSE_LINES_IN_RX_BUFFER, a NULL line opens it for settings_line_char() instead. Returns false
+// if the line is missing or corrupt.
+static uint8_t settings_read_line(uint16_t source, char *line)
+{
+  #ifdef PARSE_LINES_IN_RX_BUFFER
+    if (line == NULL) {
+      #ifdef JOURNALED_SETTINGS
+        settings_line_id = source;
+        settings_line_offset = SETTINGS_LINE_NO_CHUNK;
+        if (journal_read_at(source, 0, settings_line_chunk, SETTINGS_LINE_CHUNK_SIZE) < 0) { return(false); }
+        settings_line_offset = 0;
+        return(true);
+      #else
+        settings_line_addr = source;
+        return(memcpy_from_eeprom_with_checksum(NULL, source, LINE_BUFFER_SIZE));
+      #endif
+    }
+  #endif
+  #ifdef JOURNALED_SETTINGS
+    return(journal_read(source, line, LINE_BUFFER_SIZE) >= 0);
+  #else
+    return(memcpy_from_eeprom_with_checksum(line, source, LINE_BUFFER_SIZE));
+  #endif
+}
+
+
+#ifdef PARSE_LINES_IN_RX_BUFFER
+  char settings_line_char(uint8_t idx)
+  {
+    #ifdef JOURNALED_SETTINGS
+      uint8_t offset = idx & ~(SETTINGS_LINE_CHUNK_SIZE-1);
+      if (offset != settings_line_offset) {
+        journal_read_at(settings_line_id, offset, settings_line_chunk, SETTINGS_LINE_CHUNK_SIZE);
+        settings_line_offset = offset;
+      }
+      return(settings_line_chunk[idx-offset]);
+    #else
+      if (idx >= LINE_BUFFER_SIZE) { return(0); }
+      return(eeprom_get_char(settings_line_addr+idx));
+    #endif
+  }
+#endif
 
 
 // Method to store startup lines into EEPROM
-void settings_store_startup_line(uint8_t n, char *line)
+uint8_t settings_store_startup_line(uint8_t n, char *line, uint8_t line_start)
 {
   #ifdef FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE
     protocol_buffer_synchronize(); // A startup line may contain a motion and be executing.
   #endif
-  uint32_t addr = n*(LINE_BUFFER_SIZE+1)+EEPROM_ADDR_STARTUP_BLOCK;
-  memcpy_to_eeprom_with_checksum(addr,(char*)line, LINE_BUFFER_SIZE);
+  #ifdef JOURNALED_SETTINGS
+    return(settings_write_line(JOURNAL_ID_STARTUP_BLOCK+n, line, line_start));
+  #else
+    return(settings_write_line(n*(LINE_BUFFER_SIZE+1)+EEPROM_ADDR_STARTUP_BLOCK, line, line_start));
+  #endif
 }
 
 
 // Method to store build info into EEPROM
 // NOTE: This function can only be called in IDLE state.
-void settings_store_build_info(char *line)
+uint8_t settings_store_build_info(char *line, uint8_t line_start)
 {
   // Build info can only be stored when state is IDLE.
-  memcpy_to_eeprom_with_checksum(EEPROM_ADDR_BUILD_INFO,(char*)line, LINE_BUFFER_SIZE);
+  #ifdef JOURNALED_SETTINGS
+    return(settings_write_line(JOURNAL_ID_BUILD_INFO, line, line_start));
+  #else
+    return(settings_write_line(EEPROM_ADDR_BUILD_INFO, line, line_start));
+  #endif
 }
 
 
-// Method to store coord data parameters into EEPROM
-void settings_write_coord_data(uint8_t coord_select, float *coord_data)
+#if !defined(CACHE_COORD_DATA) || defined(TOOL_TABLE)
+// Syncs the planner buffer before writing g-code parameter data of the given size to EEPROM.
+static void settings_write_sync(uint8_t size)
 {
   #ifdef FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE
-    protocol_buffer_synchronize();
+    #if defined(EEPROM_WRITE_QUEUE) && defined(JOURNALED_SETTINGS)
+      // Only if the queue is too full to take it, or the journal must be compacted first.
+      if (!journal_write_fits(size)) { protocol_buffer_synchronize(); }
+    #elif defined(EEPROM_WRITE_QUEUE)
+      // Only if the queue is too full to take it. Waiting on it would starve the stepper.
+      if (eeprom_queue_available() <= size) { protocol_buffer_synchronize(); }
+    #else
+      protocol_buffer_synchronize();
+    #endif
+  #endif
+}
+#endif
+
+
+// Method to store coord data parameters into EEPROM
+uint8_t settings_write_coord_data(uint8_t coord_select, float *coord_data)
+{
+  #ifdef CACHE_COORD_DATA
+    // Interrupts are never held off waiting for the EEPROM, so motion need not stop.
+    memcpy(coord_cache[coord_select], coord_data, sizeof(float)*N_AXIS);
+    coord_read_fail &= ~bit(coord_select);
+    coord_dirty |= bit(coord_select);
+    if (coord_write_select == coord_select) { coord_write_index = 0; } // Restart a write in progress.
+  #else
+    settings_write_sync(sizeof(float)*N_AXIS);
+    #ifdef JOURNALED_SETTINGS
+      return(journal_write(JOURNAL_ID_PARAMETERS+coord_select, (char*)coord_data, sizeof(float)*N_AXIS));
+    #else
+      uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
+      memcpy_to_eeprom_with_checksum(addr,(char*)coord_data, sizeof(float)*N_AXIS);
+    #endif
   #endif
-  uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
-  memcpy_to_eeprom_with_checksum(addr,(char*)coord_data, sizeof(float)*N_AXIS);
+  return(STATUS_OK);
 }
 
 
+uint8_t settings_check_coord_write()
+{
+  #ifdef JOURNALED_SETTINGS
+    return(journal_write_check(sizeof(float)*N_AXIS));
+  #else
+    return(STATUS_OK);
+  #endif
+}
+
+
+#ifdef CACHE_COORD_DATA
+  // Writes the next byte of changed coordinate data to EEPROM, only once the last byte written
+  // has finished programming. Called from the main program on every realtime check.
+  void settings_write_behind()
+  {
+    if (!coord_dirty) { return; }
+    #ifdef EEPROM_WRITE_QUEUE
+      // Queue whole vectors, while they fit without waiting. The EEPROM ready interrupt writes them.
+      while (coord_dirty && (eeprom_queue_available() > sizeof(float)*N_AXIS)) {
+        coord_write_select = 0;
+        while (!(coord_dirty & bit(coord_write_select))) { coord_write_select++; }
+        uint32_t addr = coord_write_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
+        memcpy_to_eeprom_with_checksum(addr,(char*)coord_cache[coord_write_select], sizeof(float)*N_AXIS);
+        coord_dirty &= ~bit(coord_write_select);
+      }
+      return;
+    #endif
+    if (EECR & (1<<EEPE)) { return; } // Busy. eeprom_put_char() would wait with interrupts off.
+    if (coord_write_index == 0) {
+      coord_write_select = 0;
+      while (!(coord_dirty & bit(coord_write_select))) { coord_write_select++; }
+      coord_write_checksum = 0;
+    }
+    uint32_t addr = coord_write_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS + coord_write_index;
+    if (coord_write_index < sizeof(float)*N_AXIS) {
+      uint8_t data = ((uint8_t*)coord_cache[coord_write_select])[coord_write_index++];
+      // Same checksum as memcpy_to_eeprom_with_checksum(), which folds the running sum to 0 or 1
+      // before adding each byte.
+      coord_write_checksum = (coord_write_checksum != 0) + data;
+      eeprom_put_char(addr, data);
+    } else {
+      eeprom_put_char(addr, coord_write_checksum);
+      coord_write_index = 0;
+      coord_dirty &= ~bit(coord_write_select);
+    }
+  }
+
+
+  // Loads all coordinate data into RAM. Vectors with a bad checksum are cleared, rewritten, and
+  // fail their next read, like settings_read_coord_data() does without the cache.
+  static void settings_load_coord_data()
+  {
+    uint8_t idx;
+    for (idx=0; idx <= SETTING_INDEX_NCOORD; idx++) {
+      uint32_t addr = idx*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
+      if (!(memcpy_from_eeprom_with_checksum((char*)coord_cache[idx], addr, sizeof(float)*N_AXIS))) {
+        clear_vector_float(coord_cache[idx]);
+        coord_read_fail |= bit(idx);
+        coord_dirty |= bit(idx);
+      }
+    }
+  }
+#endif
+
+
+#ifdef TOOL_TABLE
+  uint8_t settings_write_tool_data(uint8_t tool, tool_data_t *tool_data)
+  {
+    #ifdef JOURNALED_SETTINGS
+      // One record holds the whole table. Only the changed bytes are appended.
+      tool_data_t old_data = tool_table[tool-1];
+      memcpy(&tool_table[tool-1], tool_data, sizeof(tool_data_t));
+      settings_write_sync(sizeof(tool_table));
+      uint8_t status = journal_write(JOURNAL_ID_TOOL_TABLE, (char*)tool_table, sizeof(tool_table));
+      if (status != STATUS_OK) { tool_table[tool-1] = old_data; } // Keep RAM in step with the EEPROM.
+      return(status);
+    #else
+      memcpy(&tool_table[tool-1], tool_data, sizeof(tool_data_t));
+      settings_write_sync(sizeof(tool_data_t));
+      uint32_t addr = (tool-1)*(sizeof(tool_data_t)+1) + EEPROM_ADDR_TOOL_TABLE;
+      memcpy_to_eeprom_with_checksum(addr, (char*)tool_data, sizeof(tool_data_t));
+      return(STATUS_OK);
+    #endif
+  }
+
+
+  void settings_read_tool_data(uint8_t tool, tool_data_t *tool_data)
+  {
+    memcpy(tool_data, &tool_table[tool-1], sizeof(tool_data_t));
+  }
+
+
+  uint8_t settings_check_tool_write()
+  {
+    #ifdef JOURNALED_SETTINGS
+      return(journal_write_check(sizeof(tool_table)));
+    #else
+      return(STATUS_OK);
+    #endif
+  }
+
+
+  // Loads the tool table into RAM. Entries that fail to read are cleared and rewritten. Returns
+  // false if any did.
+  static uint8_t settings_load_tool_table()
+  {
+    uint8_t status = true;
+    #ifdef JOURNALED_SETTINGS
+      if (journal_read(JOURNAL_ID_TOOL_TABLE, (char*)tool_table, sizeof(tool_table)) != sizeof(tool_table)) {
+        memset(tool_table, 0, sizeof(tool_table));
+        journal_write(JOURNAL_ID_TOOL_TABLE, (char*)tool_table, sizeof(tool_table));
+        status = false;
+      }
+    #else
+      uint8_t idx;
+      for (idx=0; idx < N_TOOL_TABLE; idx++) {
+        uint32_t addr = idx*(sizeof(tool_data_t)+1) + EEPROM_ADDR_TOOL_TABLE;
+        if (!(memcpy_from_eeprom_with_checksum((char*)&tool_table[idx], addr, sizeof(tool_data_t)))) {
+          memset(&tool_table[idx], 0, sizeof(tool_data_t));
+          memcpy_to_eeprom_with_checksum(addr, (char*)&tool_table[idx], sizeof(tool_data_t));
+          status = false;
+        }
+      }
+    #endif
+    return(status);
+  }
+#endif
+
+
 // Method to store Grbl global settings struct and version number into EEPROM
 // NOTE: This function can only be called in IDLE state.
-void write_global_settings()
+uint8_t write_global_settings()
+{
+  #ifdef JOURNALED_SETTINGS
+    return(journal_write(JOURNAL_ID_GLOBAL, (char*)&settings, sizeof(settings_t))); // Version is in the bank header.
+  #else
+    eeprom_put_char(0, SETTINGS_VERSION);
+    memcpy_to_eeprom_with_checksum(EEPROM_ADDR_GLOBAL, (char*)&settings, sizeof(settings_t));
+    return(STATUS_OK);
+  #endif
+}
+
+
+// Rebuilds the reciprocal axis settings. Called whenever the global settings change.
+void settings_update_inverse()
 {
-  eeprom_put_char(0, SETTINGS_VERSION);
-  memcpy_to_eeprom_with_checksum(EEPROM_ADDR_GLOBAL, (char*)&settings, sizeof(settings_t));
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    settings_inverse.mm_per_step[idx] = 1.0/settings.steps_per_mm[idx];
+    settings_inverse.max_rate_inv[idx] = 1.0/settings.max_rate[idx];
+    settings_inverse.acceleration_inv[idx] = 1.0/settings.acceleration[idx];
+  }
+  #ifdef S_CURVE_ACCELERATION
+    settings_inverse.jerk_inv = 0.0;
+    if (settings.jerk > 0.0) { settings_inverse.jerk_inv = 1.0/settings.jerk; }
+  #endif
 }
 
 
@@ -84,6 +373,9 @@ void settings_restore(uint8_t restore_flag) {
     settings.homing_seek_rate = DEFAULT_HOMING_SEEK_RATE;
     settings.homing_debounce_delay = DEFAULT_HOMING_DEBOUNCE_DELAY;
     settings.homing_pulloff = DEFAULT_HOMING_PULLOFF;
+    #ifdef S_CURVE_ACCELERATION
+      settings.jerk = DEFAULT_JERK;
+    #endif
 
     settings.flags = 0;
     if (DEFAULT_REPORT_INCHES) { settings.flags |= BITFLAG_REPORT_INCHES; }
@@ -126,6 +418,7 @@ void settings_restore(uint8_t restore_flag) {
       settings.max_travel[AXIS_6] = (-DEFAULT_AXIS6_MAX_TRAVEL);
     #endif
 
+    settings_update_inverse();
     write_global_settings();
   }
 
@@ -134,8 +427,22 @@ void settings_restore(uint8_t restore_flag) {
     float coord_data[N_AXIS];
     memset(&coord_data, 0, sizeof(coord_data));
     for (idx=0; idx <= SETTING_INDEX_NCOORD; idx++) { settings_write_coord_data(idx, coord_data); }
+    #ifdef TOOL_TABLE
+      tool_data_t tool_data;
+      memset(&tool_data, 0, sizeof(tool_data));
+      for (idx=1; idx <= N_TOOL_TABLE; idx++) { settings_write_tool_data(idx, &tool_data); }
+    #endif
   }
 
+  #ifdef JOURNALED_SETTINGS
+    if (restore_flag & SETTINGS_RESTORE_STARTUP_LINES) {
+      uint8_t idx;
+      for (idx=0; idx < N_STARTUP_LINE; idx++) { journal_write(JOURNAL_ID_STARTUP_BLOCK+idx, NULL, 0); }
+    }
+    if (restore_flag & SETTINGS_RESTORE_BUILD_INFO) { journal_write(JOURNAL_ID_BUILD_INFO, NULL, 0); }
+    return;
+  #endif
+
   if (restore_flag & SETTINGS_RESTORE_STARTUP_LINES) {
     #if N_STARTUP_LINE > 0
       eeprom_put_char(EEPROM_ADDR_STARTUP_BLOCK, 0);
@@ -157,11 +464,14 @@ void settings_restore(uint8_t restore_flag) {
 // Reads startup line from EEPROM. Updated pointed line string data.
 uint8_t settings_read_startup_line(uint8_t n, char *line)
 {
-  uint32_t addr = n*(LINE_BUFFER_SIZE+1)+EEPROM_ADDR_STARTUP_BLOCK;
-  if (!(memcpy_from_eeprom_with_checksum((char*)line, addr, LINE_BUFFER_SIZE))) {
+  #ifdef JOURNALED_SETTINGS
+    if (!(settings_read_line(JOURNAL_ID_STARTUP_BLOCK+n, line))) {
+  #else
+    if (!(settings_read_line(n*(LINE_BUFFER_SIZE+1)+EEPROM_ADDR_STARTUP_BLOCK, line))) {
+  #endif
     // Reset line with default value
-    line[0] = 0; // Empty line
-    settings_store_startup_line(n, line);
+    if (line) { line[0] = 0; } // Empty line
+    settings_store_startup_line(n, "", 0);
     return(false);
   }
   return(true);
@@ -171,10 +481,14 @@ uint8_t settings_read_startup_line(uint8_t n, char *line)
 // Reads startup line from EEPROM. Updated pointed line string data.
 uint8_t settings_read_build_info(char *line)
 {
-  if (!(memcpy_from_eeprom_with_checksum((char*)line, EEPROM_ADDR_BUILD_INFO, LINE_BUFFER_SIZE))) {
+  #ifdef JOURNALED_SETTINGS
+    if (!(settings_read_line(JOURNAL_ID_BUILD_INFO, line))) {
+  #else
+    if (!(settings_read_line(EEPROM_ADDR_BUILD_INFO, line))) {
+  #endif
     // Reset line with default value
-    line[0] = 0; // Empty line
-    settings_store_build_info(line);
+    if (line) { line[0] = 0; } // Empty line
+    settings_store_build_info("", 0);
     return(false);
   }
   return(true);
@@ -184,19 +498,35 @@ uint8_t settings_read_build_info(char *line)
 // Read selected coordinate data from EEPROM. Updates pointed coord_data value.
 uint8_t settings_read_coord_data(uint8_t coord_select, float *coord_data)
 {
-  uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
-  if (!(memcpy_from_eeprom_with_checksum((char*)coord_data, addr, sizeof(float)*N_AXIS))) {
-    // Reset with default zero vector
-    clear_vector_float(coord_data);
-    settings_write_coord_data(coord_select,coord_data);
-    return(false);
-  }
+  #ifdef CACHE_COORD_DATA
+    memcpy(coord_data, coord_cache[coord_select], sizeof(float)*N_AXIS);
+    if (coord_read_fail & bit(coord_select)) {
+      coord_read_fail &= ~bit(coord_select);
+      return(false);
+    }
+  #else
+    #ifdef JOURNALED_SETTINGS
+      if (journal_read(JOURNAL_ID_PARAMETERS+coord_select, (char*)coord_data, sizeof(float)*N_AXIS) != sizeof(float)*N_AXIS) {
+    #else
+      uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
+      if (!(memcpy_from_eeprom_with_checksum((char*)coord_data, addr, sizeof(float)*N_AXIS))) {
+    #endif
+      // Reset with default zero vector
+      clear_vector_float(coord_data);
+      settings_write_coord_data(coord_select,coord_data);
+      return(false);
+    }
+  #endif
   return(true);
 }
 
 
 // Reads Grbl global settings struct from EEPROM.
 uint8_t read_global_settings() {
+  #ifdef JOURNALED_SETTINGS
+    // The settings version was checked against the bank header by journal_init().
+    return(journal_read(JOURNAL_ID_GLOBAL, (char*)&settings, sizeof(settings_t)) == sizeof(settings_t));
+  #endif
   // Check version-byte of eeprom
   uint8_t version = eeprom_get_char(0);
   if (version == SETTINGS_VERSION) {
@@ -238,6 +568,7 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
           case 2: settings.acceleration[parameter] = value*60*60; break; // Convert to mm/min^2 for grbl internal use.
           case 3: settings.max_travel[parameter] = -value; break;  // Store as negative for grbl internal use.
         }
+        settings_update_inverse();
         break; // Exit while-loop after setting has been configured and proceed to the EEPROM write call.
       } else {
         set_idx++;
@@ -306,6 +637,12 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
       case 25: settings.homing_seek_rate = value; break;
       case 26: settings.homing_debounce_delay = int_value; break;
       case 27: settings.homing_pulloff = value; break;
+      #ifdef S_CURVE_ACCELERATION
+        case 28:
+          settings.jerk = value*60*60*60; // Convert to mm/min^3 for grbl internal use.
+          settings_update_inverse();
+          break;
+      #endif
       case 30: settings.rpm_max = value; spindle_init(); break; // Re-initialize spindle rpm calibration
       case 31: settings.rpm_min = value; spindle_init(); break; // Re-initialize spindle rpm calibration
       case 32:
@@ -316,18 +653,30 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
         return(STATUS_INVALID_STATEMENT);
     }
   }
-  write_global_settings();
-  return(STATUS_OK);
+  return(write_global_settings());
 }
 
 
 // Initialize the config subsystem
 void settings_init() {
+  #ifdef JOURNALED_SETTINGS
+    journal_init();
+  #endif
+  #ifdef CACHE_COORD_DATA
+    settings_load_coord_data(); // First, so a restore below replaces any bad vectors.
+  #endif
+  #ifdef TOOL_TABLE
+    uint8_t tool_table_valid = settings_load_tool_table();
+  #endif
   if(!read_global_settings()) {
     report_status_message(STATUS_SETTING_READ_FAIL);
     settings_restore(SETTINGS_RESTORE_ALL); // Force restore all EEPROM data.
     report_grbl_settings();
   }
+  #ifdef TOOL_TABLE
+    else if (!tool_table_valid) { report_status_message(STATUS_SETTING_READ_FAIL); }
+  #endif
+  settings_update_inverse();
 }
 
 
@@ -379,6 +728,44 @@ uint8_t get_direction_pin_mask(uint8_t axis_idx)
 }
 
 
+#ifdef DEFAULTS_RAMPS_BOARD
+  // Returns the step port group of an axis, as mapped in cpu_map.h.
+  uint8_t get_step_port_group(uint8_t axis_idx)
+  {
+    if ( axis_idx == AXIS_1 ) { return(STEP_GROUP(AXIS_1)); }
+    if ( axis_idx == AXIS_2 ) { return(STEP_GROUP(AXIS_2)); }
+    #if N_AXIS > 3
+      if ( axis_idx == AXIS_4 ) { return(STEP_GROUP(AXIS_4)); }
+    #endif
+    #if N_AXIS > 4
+      if ( axis_idx == AXIS_5 ) { return(STEP_GROUP(AXIS_5)); }
+    #endif
+    #if N_AXIS > 5
+      if ( axis_idx == AXIS_6 ) { return(STEP_GROUP(AXIS_6)); }
+    #endif
+    return(STEP_GROUP(AXIS_3));
+  }
+
+
+  // Returns the direction port group of an axis, as mapped in cpu_map.h.
+  uint8_t get_direction_port_group(uint8_t axis_idx)
+  {
+    if ( axis_idx == AXIS_1 ) { return(DIRECTION_GROUP(AXIS_1)); }
+    if ( axis_idx == AXIS_2 ) { return(DIRECTION_GROUP(AXIS_2)); }
+    #if N_AXIS > 3
+      if ( axis_idx == AXIS_4 ) { return(DIRECTION_GROUP(AXIS_4)); }
+    #endif
+    #if N_AXIS > 4
+      if ( axis_idx == AXIS_5 ) { return(DIRECTION_GROUP(AXIS_5)); }
+    #endif
+    #if N_AXIS > 5
+      if ( axis_idx == AXIS_6 ) { return(DIRECTION_GROUP(AXIS_6)); }
+    #endif
+    return(DIRECTION_GROUP(AXIS_3));
+  }
+#endif // DEFAULTS_RAMPS_BOARD
+
+
 // Returns limit pin mask according to Grbl internal axis indexing.
 
 #ifdef DEFAULTS_RAMPS_BOARD
@@ -46,6 +46,7 @@
 // Define status reporting boolean enable bit flags in settings.status_report_mask
 #define BITFLAG_RT_STATUS_POSITION_TYPE     bit(0)
 #define BITFLAG_RT_STATUS_BUFFER_STATE      bit(1)
+#define BITFLAG_RT_STATUS_BINARY_FRAME      bit(2)
 
 // Define settings restore bitflags.
 #define SETTINGS_RESTORE_DEFAULTS bit(0)
@@ -61,6 +62,7 @@
 #define EEPROM_ADDR_PARAMETERS     512U
 #define EEPROM_ADDR_STARTUP_BLOCK  768U
 #define EEPROM_ADDR_BUILD_INFO     942U
+#define EEPROM_ADDR_TOOL_TABLE     1536U
 
 // Define EEPROM address indexing for coordinate parameters
 #define N_COORDINATE_SYSTEM 6  // Number of supported work coordinate systems (from index 1)
@@ -70,6 +72,14 @@
 #define SETTING_INDEX_G30    N_COORDINATE_SYSTEM+1  // Home position 2
 // #define SETTING_INDEX_G92    N_COORDINATE_SYSTEM+2  // Coordinate offset (G92.2,G92.3 not supported)
 
+// Define record ids of the JOURNALED_SETTINGS store, used instead of the EEPROM addresses above
+#define JOURNAL_ID_GLOBAL        0
+#define JOURNAL_ID_PARAMETERS    1 // One per coordinate vector, from index 0
+#define JOURNAL_ID_STARTUP_BLOCK (JOURNAL_ID_PARAMETERS+SETTING_INDEX_NCOORD+1)
+#define JOURNAL_ID_BUILD_INFO    (JOURNAL_ID_STARTUP_BLOCK+N_STARTUP_LINE)
+#define JOURNAL_ID_TOOL_TABLE    (JOURNAL_ID_BUILD_INFO+1) // Whole table in one record
+#define JOURNAL_N_RECORDS        (JOURNAL_ID_TOOL_TABLE+1)
+
 // Define Grbl axis settings numbering scheme. Starts at START_VAL, every INCREMENT, over N_SETTINGS.
 #define AXIS_N_SETTINGS          4
 #define AXIS_SETTINGS_START_VAL  100 // NOTE: Reserving settings values >= 100 for axis settings. Up to 255.
@@ -102,42 +112,102 @@ typedef struct {
   float homing_seek_rate;
   uint16_t homing_debounce_delay;
   float homing_pulloff;
+
+  #ifdef S_CURVE_ACCELERATION
+    float jerk; // Path jerk limit (mm/min^3). 0 keeps constant acceleration ramps.
+  #endif
 } settings_t;
 extern settings_t settings;
 
+// Reciprocals of the axis settings, rebuilt whenever the global settings are loaded or changed.
+// Lets the planner multiply instead of divide per axis. Not stored in EEPROM.
+typedef struct {
+  float mm_per_step[N_AXIS];
+  float max_rate_inv[N_AXIS];     // (min/mm)
+  float acceleration_inv[N_AXIS]; // (min^2/mm)
+  #ifdef S_CURVE_ACCELERATION
+    float jerk_inv; // (min^3/mm). 0 with the jerk limit disabled.
+  #endif
+} settings_inverse_t;
+extern settings_inverse_t settings_inverse;
+
+#ifdef TOOL_TABLE
+  // Tool table entry. Tools are numbered from 1. Tool 0 is no tool.
+  typedef struct {
+    float length;   // Tool length offset (mm)
+    float diameter; // (mm)
+  } tool_data_t;
+#endif
+
 // Initialize the configuration subsystem (load settings from EEPROM)
 void settings_init();
 
+// Rebuilds the reciprocal axis settings from the global settings
+void settings_update_inverse();
+
 // Helper function to clear and restore EEPROM defaults
 void settings_restore(uint8_t restore_flag);
 
 // A helper method to set new settings from command line
 uint8_t settings_store_global_setting(uint8_t parameter, float value);
 
-// Stores the protocol line variable as a startup line in EEPROM
-void settings_store_startup_line(uint8_t n, char *line);
+// Stores the protocol line variable as a startup line in EEPROM, from line[line_start]. Its index
+// wraps around at 256, like a line parsed in place in the serial RX buffer. Returns a status code.
+uint8_t settings_store_startup_line(uint8_t n, char *line, uint8_t line_start);
 
-// Reads an EEPROM startup line to the protocol line variable
+// Reads an EEPROM startup line to the protocol line variable. With PARSE_LINES_IN_RX_BUFFER, a
+// NULL line opens it to be read in place by settings_line_char() instead.
 uint8_t settings_read_startup_line(uint8_t n, char *line);
 
-// Stores build info user-defined string
-void settings_store_build_info(char *line);
+// Stores build info user-defined string, from line[line_start]. Returns a status code.
+uint8_t settings_store_build_info(char *line, uint8_t line_start);
 
-// Reads build info user-defined string
+// Reads build info user-defined string, or opens it like settings_read_startup_line().
 uint8_t settings_read_build_info(char *line);
 
-// Writes selected coordinate data to EEPROM
-void settings_write_coord_data(uint8_t coord_select, float *coord_data);
+#ifdef PARSE_LINES_IN_RX_BUFFER
+  // Returns character idx of the stored line opened last, read in place from EEPROM.
+  char settings_line_char(uint8_t idx);
+#endif
+
+// Writes selected coordinate data to EEPROM. Returns a status code.
+uint8_t settings_write_coord_data(uint8_t coord_select, float *coord_data);
 
 // Reads selected coordinate data from EEPROM
 uint8_t settings_read_coord_data(uint8_t coord_select, float *coord_data);
 
+// Returns STATUS_SETTING_WRITE_FAIL if a coordinate data write could fail. Called by the g-code
+// parser before it executes a block that writes one.
+uint8_t settings_check_coord_write();
+
+#ifdef CACHE_COORD_DATA
+  // Writes one byte of changed coordinate data to EEPROM, if it is ready
+  void settings_write_behind();
+#endif
+
+#ifdef TOOL_TABLE
+  // Writes a tool table entry to RAM and EEPROM. Returns a status code.
+  uint8_t settings_write_tool_data(uint8_t tool, tool_data_t *tool_data);
+
+  // Reads a tool table entry from RAM
+  void settings_read_tool_data(uint8_t tool, tool_data_t *tool_data);
+
+  // Returns STATUS_SETTING_WRITE_FAIL if a tool table write could fail.
+  uint8_t settings_check_tool_write();
+#endif
+
 // Returns the step pin mask according to Grbl's internal axis numbering
 uint8_t get_step_pin_mask(uint8_t i);
 
 // Returns the direction pin mask according to Grbl's internal axis numbering
 uint8_t get_direction_pin_mask(uint8_t i);
 
+#ifdef DEFAULTS_RAMPS_BOARD
+  // Returns the step and direction port groups according to Grbl's internal axis numbering
+  uint8_t get_step_port_group(uint8_t i);
+  uint8_t get_direction_port_group(uint8_t i);
+#endif
+
 // Returns the limit pin mask according to Grbl's internal axis numbering
 uint8_t get_limit_pin_mask(uint8_t i);
 
@@ -215,3 +215,38 @@ void spindle_sync(uint8_t state, float rpm)
   protocol_buffer_synchronize(); // Empty planner buffer to ensure spindle is set when programmed.
   spindle_set_state(state,rpm);
 }
+
+
+#ifdef QUEUE_ACCESSORY_CHANGES
+  static uint8_t spindle_queued; // Flags a queued spindle change not yet set by spindle_apply_queued().
+  static uint8_t spindle_queued_state;
+  static float spindle_queued_rpm;
+
+  // G-code parser entry-point for spindle speed changes and spindle stop, which do not sync the
+  // planner buffer. With nothing queued, the spindle is set immediately. Otherwise, the next
+  // motion block carries the new state: the stepper updates the PWM and stops the spindle as the
+  // block starts. The state is also kept until the planner buffer drains, for the case that no
+  // motion follows.
+  void spindle_queue(uint8_t state, float rpm)
+  {
+    if (sys.state == STATE_CHECK_MODE) { return; }
+    if ((sys.state == STATE_IDLE) && (plan_get_current_block() == NULL)) {
+      spindle_queued = false;
+      spindle_set_state(state,rpm);
+    } else {
+      spindle_queued = true;
+      spindle_queued_state = state;
+      spindle_queued_rpm = rpm;
+    }
+  }
+
+
+  // Sets a queued spindle state, if any. Called once the planner buffer has drained.
+  void spindle_apply_queued()
+  {
+    if (spindle_queued) {
+      spindle_queued = false;
+      spindle_set_state(spindle_queued_state,spindle_queued_rpm);
+    }
+  }
+#endif
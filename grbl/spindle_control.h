@@ -43,6 +43,14 @@ uint8_t spindle_get_state();
 // Called by g-code parser when setting spindle state and requires a buffer sync.
 void spindle_sync(uint8_t state, float rpm);
 
+#ifdef QUEUE_ACCESSORY_CHANGES
+  // Called by g-code parser for spindle changes that do not require a buffer sync.
+  void spindle_queue(uint8_t state, float rpm);
+
+  // Sets the spindle state last queued by spindle_queue(). Called when the planner buffer drains.
+  void spindle_apply_queued();
+#endif
+
 // Sets spindle running state with direction, enable, and spindle PWM.
 void spindle_set_state(uint8_t state, float rpm); 
 
@@ -30,12 +30,27 @@
 #define RAMP_CRUISE 1
 #define RAMP_DECEL 2
 #define RAMP_DECEL_OVERRIDE 3
+#define RAMP_S_CURVE 4 // Jerk-limited ramps. See st_s_curve_advance().
 
 #define PREP_FLAG_RECALCULATE bit(0)
 #define PREP_FLAG_HOLD_PARTIAL_BLOCK bit(1)
 #define PREP_FLAG_PARKING bit(2)
 #define PREP_FLAG_DECEL_OVERRIDE bit(3)
 
+#ifdef STEPPER_FIXED_POINT
+  // Fixed-point segment generator units, all along the step_event_count axis of the block.
+  // Times are in 1/FP_ONE segments (DT_SEGMENT). Distances are in 1/2^fp_shift steps, speeds in
+  // 1/2^fp_shift steps per segment and acceleration in 1/2^fp_shift steps per segment squared.
+  // The fp_shift of each block is FP_SHIFT, less the bits its step count needs above 16, so all
+  // of them fit in 32 bits.
+  #define FP_SHIFT 16
+  #define FP_ONE (1UL<<FP_SHIFT)
+  #define FP_SEGMENT_CYCLES ((uint32_t)(F_CPU/ACCELERATION_TICKS_PER_SECOND)) // CPU cycles/segment
+  #define FP_REQ_INCREMENT ((uint32_t)(REQ_MM_INCREMENT_SCALAR*FP_ONE))
+  #define FP_MAX_RAMP_TIME (FP_ONE << 8) // Limits the time of a near-zero speed ramp junction
+  #define FP_MAX_CYCLES (1UL << 22) // Step period at or above the slowest timer setting
+#endif
+
 // Define Adaptive Multi-Axis Step-Smoothing(AMASS) levels and cutoff frequencies. The highest level
 // frequency bin starts at 0Hz and ends at its cutoff frequency. The next lower level frequency bin
 // starts at the next higher cutoff frequency, and so on. The cutoff frequencies for each level must
@@ -62,8 +77,11 @@
   typedef struct {
     uint32_t steps[N_AXIS];
     uint32_t step_event_count;
-    uint8_t direction_bits[N_AXIS];
+    uint8_t direction_bits[DIRECTION_PORT_GROUPS]; // Direction pins per direction port group
     uint8_t is_pwm_rate_adjusted; // Tracks motions that require constant laser power/rate
+    #ifdef QUEUE_ACCESSORY_CHANGES
+      uint8_t accessory; // Planner block spindle and coolant condition, and system motion flag
+    #endif
   } st_block_t;
 #else
   typedef struct {
@@ -71,6 +89,9 @@
     uint32_t step_event_count;
     uint8_t direction_bits;
     uint8_t is_pwm_rate_adjusted; // Tracks motions that require constant laser power/rate
+    #ifdef QUEUE_ACCESSORY_CHANGES
+      uint8_t accessory; // Planner block spindle and coolant condition, and system motion flag
+    #endif
   } st_block_t;
 #endif // Ramps Board
 
@@ -90,6 +111,9 @@ typedef struct {
     uint8_t prescaler;      // Without AMASS, a prescaler is required to adjust for slow timing.
   #endif
   uint16_t spindle_pwm;
+  #ifdef ADAPTIVE_SEGMENT_TIME
+    uint8_t ticks;          // Planned segment time in acceleration ticks
+  #endif
 } segment_t;
 static segment_t segment_buffer[SEGMENT_BUFFER_SIZE];
 
@@ -115,7 +139,7 @@ typedef struct {
   #endif
   #ifdef STEP_PULSE_DELAY
     #ifdef DEFAULTS_RAMPS_BOARD
-      uint8_t step_bits[N_AXIS];  // Stores out_bits output to complete the step pulse delay
+      uint8_t step_bits[STEP_PORT_GROUPS];  // Stores out_bits output to complete the step pulse delay
     #else
       uint8_t step_bits;  // Stores out_bits output to complete the step pulse delay
     #endif // Ramps Board
@@ -124,8 +148,8 @@ typedef struct {
   uint8_t execute_step;     // Flags step execution for each interrupt.
   uint8_t step_pulse_time;  // Step pulse reset time after step rise
   #ifdef DEFAULTS_RAMPS_BOARD
-    uint8_t step_outbits[N_AXIS];         // The next stepping-bits to be output
-    uint8_t dir_outbits[N_AXIS];
+    uint8_t step_outbits[STEP_PORT_GROUPS];       // The next stepping-bits to be output, per port group
+    uint8_t dir_outbits[DIRECTION_PORT_GROUPS];
   #else
     uint8_t step_outbits;         // The next stepping-bits to be output
     uint8_t dir_outbits;
@@ -138,6 +162,9 @@ typedef struct {
   uint8_t exec_block_index; // Tracks the current st_block index. Change indicates new block.
   st_block_t *exec_block;   // Pointer to the block data for the segment being executed
   segment_t *exec_segment;  // Pointer to the segment being executed
+  #ifdef QUEUE_ACCESSORY_CHANGES
+    uint8_t accessory;      // Spindle and coolant condition of the last block started
+  #endif
 } stepper_t;
 static stepper_t st;
 
@@ -148,8 +175,8 @@ static uint8_t segment_next_head;
 
 // Step and direction port invert masks.
 #ifdef DEFAULTS_RAMPS_BOARD
-  static uint8_t step_port_invert_mask[N_AXIS];
-  static uint8_t dir_port_invert_mask[N_AXIS];
+  static uint8_t step_port_invert_mask[STEP_PORT_GROUPS];
+  static uint8_t dir_port_invert_mask[DIRECTION_PORT_GROUPS];
 #else
   static uint8_t step_port_invert_mask;
   static uint8_t dir_port_invert_mask;
@@ -158,6 +185,117 @@ static uint8_t segment_next_head;
 // Used to avoid ISR nesting of the "Stepper Driver Interrupt". Should never occur though.
 static volatile uint8_t busy;
 
+#ifdef DEFAULTS_RAMPS_BOARD
+  // Write the step or direction pins of all axes in a port group. See cpu_map.h.
+  #define STEP_GROUP_WRITE(g,bits) STEP_GROUP_PORT(g) = (STEP_GROUP_PORT(g) & ~STEP_GROUP_MASK(g)) | (bits)
+  #define DIRECTION_GROUP_WRITE(g,bits) DIRECTION_GROUP_PORT(g) = (DIRECTION_GROUP_PORT(g) & ~DIRECTION_GROUP_MASK(g)) | (bits)
+#endif
+
+#ifdef STEPPER_ISR_PROFILE
+  // Interrupt cost profile. Timer5 free-runs at the CPU clock, so the difference of two TCNT5
+  // reads is the number of CPU cycles in between, up to 65535 (4.1msec).
+  static st_profile_t st_profile[ST_PROFILE_BUCKETS];
+  static volatile uint16_t st_profile_overruns;
+
+  static void st_profile_record(uint8_t bucket, uint16_t start)
+  {
+    uint16_t cycles = TCNT5 - start;
+    st_profile_t *profile = &st_profile[bucket];
+    if (profile->count == 0 || cycles < profile->min) { profile->min = cycles; }
+    if (cycles > profile->max) { profile->max = cycles; }
+    profile->count++;
+    profile->cycles += cycles;
+    if (profile->cycles < cycles) { profile->cycles_high++; } // 40 bits last 19 hours at 100% load.
+    uint16_t bin = cycles/ST_PROFILE_BIN_CYCLES;
+    if (bin >= ST_PROFILE_BINS) { bin = ST_PROFILE_BINS-1; }
+    if (profile->histogram[bin] != 0xFFFF) { profile->histogram[bin]++; }
+  }
+#endif
+
+#ifdef STEPPER_TRACE
+  // Step event trace ring. Written only by the stepper interrupt while recording, and read once
+  // recording has stopped. After the first underrun, half a ring of records is kept and recording
+  // stops, so the underrun ends up in the middle of the trace.
+  static st_trace_t st_trace[ST_TRACE_SIZE];
+  static uint8_t st_trace_head;      // Index of the next record to write
+  static uint8_t st_trace_count;     // Number of valid records, up to ST_TRACE_SIZE
+  static uint8_t st_trace_remaining; // Records left to write after an underrun. Zero before one.
+  static volatile uint8_t st_trace_running;
+  #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+    static uint8_t st_trace_level;   // AMASS level of the last loaded segment
+  #endif
+
+  static void st_trace_record(uint8_t event, uint16_t cycles_per_tick, uint8_t level, uint8_t queued)
+  {
+    if (!st_trace_running) { return; }
+    st_trace_t *record = &st_trace[st_trace_head];
+    record->time = TCNT5;
+    record->cycles_per_tick = cycles_per_tick;
+    record->event = event;
+    record->level = level;
+    record->queued = queued;
+    st_trace_head = (st_trace_head+1) & (ST_TRACE_SIZE-1);
+    if (st_trace_count < ST_TRACE_SIZE) { st_trace_count++; }
+    if (st_trace_remaining) {
+      if (--st_trace_remaining == 0) { st_trace_running = false; }
+    } else if (event == ST_TRACE_UNDERRUN) {
+      st_trace_remaining = ST_TRACE_SIZE/2;
+    }
+  }
+#endif
+
+#ifdef SEGMENT_BUFFER_STATS
+  // Segment buffer counters. Updated only by the stepper interrupt.
+  static st_buffer_stats_t st_stats;
+  static uint8_t st_stats_starving; // Planner ran empty while the steppers were still moving.
+
+  // Called by the stepper interrupt after loading a segment.
+  static void st_stats_segment_loaded()
+  {
+    if (sys.step_control & STEP_CONTROL_END_MOTION) { return; } // Planned stop. Buffer drains by design.
+    if (plan_get_block_buffer_count() == 0) {
+      st_stats_starving = true;
+      return;
+    }
+    if (st_stats_starving) {
+      st_stats_starving = false;
+      if (st_stats.planner_starved != 0xFFFF) { st_stats.planner_starved++; }
+    }
+    // Segments left in the buffer, counting the one just loaded.
+    uint8_t queued = segment_buffer_head - segment_buffer_tail;
+    if (segment_buffer_head < segment_buffer_tail) { queued += SEGMENT_BUFFER_SIZE; }
+    if (queued < st_stats.low_water) { st_stats.low_water = queued; }
+    if ((queued == 1) && (st_stats.near_underruns != 0xFFFF)) { st_stats.near_underruns++; }
+  }
+
+  // Called by the stepper interrupt when the segment buffer is empty and the steppers go idle.
+  // A planner that ran empty before the steppers stopped can't be told from the end of a job.
+  static void st_stats_buffer_empty()
+  {
+    st_stats_starving = false;
+    if (sys.step_control & STEP_CONTROL_END_MOTION) { return; }
+    if (plan_get_block_buffer_count() == 0) { return; }
+    st_stats.low_water = 0;
+    if (st_stats.underruns != 0xFFFF) { st_stats.underruns++; }
+  }
+#endif
+
+#ifdef QUEUE_ACCESSORY_CHANGES
+  // Called by the stepper interrupt as a block starts. Applies the spindle stop and coolant changes
+  // the g-code parser queued with it. Only changes from the last block are set, so overrides hold.
+  // Spindle starts and reversals are synced by the parser and are already running. The segment
+  // PWM sets any new spindle speed.
+  static void st_update_accessory(uint8_t accessory)
+  {
+    uint8_t changed = accessory ^ st.accessory;
+    if (!changed) { return; }
+    st.accessory = accessory;
+    if ((changed & (PL_COND_FLAG_SPINDLE_CW|PL_COND_FLAG_SPINDLE_CCW)) &&
+        !(accessory & (PL_COND_FLAG_SPINDLE_CW|PL_COND_FLAG_SPINDLE_CCW))) { spindle_stop(); }
+    if (changed & (PL_COND_FLAG_COOLANT_FLOOD|PL_COND_FLAG_COOLANT_MIST)) { coolant_apply_change(accessory,changed); }
+  }
+#endif
+
 // Pointers for the step segment being prepped from the planner buffer. Accessed only by the
 // main program. Pointers may be planning segments or planner blocks ahead of what being executed.
 static plan_block_t *pl_block;     // Pointer to the planner block being prepped
@@ -169,16 +307,28 @@ typedef struct {
   uint8_t st_block_index;  // Index of stepper common data block being prepped
   uint8_t recalculate_flag;
 
-  float dt_remainder;
-  float steps_remaining;
+  #ifdef STEPPER_FIXED_POINT
+    uint32_t dt_remainder;    // Partial step time carried over to the next segment (CPU cycles)
+    uint32_t steps_remaining; // Exact distance to end of block (1/2^fp_shift steps)
+    uint8_t fp_shift;         // Fraction bits of the distances and speeds of the prepped block
+  #else
+    float dt_remainder;
+    float steps_remaining;
+  #endif
   float step_per_mm;
   float req_mm_increment;
 
   #ifdef PARKING_ENABLE
     uint8_t last_st_block_index;
-    float last_steps_remaining;
+    #ifdef STEPPER_FIXED_POINT
+      uint32_t last_steps_remaining;
+      uint32_t last_dt_remainder;
+      uint8_t last_fp_shift;
+    #else
+      float last_steps_remaining;
+      float last_dt_remainder;
+    #endif
     float last_step_per_mm;
-    float last_dt_remainder;
   #endif
 
   uint8_t ramp_type;      // Current segment ramp state
@@ -192,6 +342,38 @@ typedef struct {
 
   float inv_rate;    // Used by PWM laser mode to speed up segment calculations.
   uint16_t current_spindle_pwm;
+
+  #ifdef S_CURVE_ACCELERATION
+    // Jerk-limited ramps. Like the current speed, the acceleration carries over blocks and replans.
+    float current_accel;   // Current acceleration at the end of the segment buffer (mm/min^2)
+    float s_curve_exit_mm;     // Distance past the end of the profile to reach the exit speed at (mm)
+    float s_curve_limit_speed; // Braking limit kept by the next block. See planner.c. (mm/min)
+    float s_curve_limit_mm;    // Distance past the end of the profile to reach its speed at (mm)
+    float s_curve_stop_mm;     // Distance past the end of the profile to the next planned stop (mm)
+    uint8_t s_curve_brake;     // Braking limits the ramp brakes for. See st_s_curve_advance().
+  #endif
+
+  #ifdef ARC_PLANNER_BLOCKS
+    plan_arc_t *arc;               // Arc geometry of the prepped planner block. NULL for lines.
+    int32_t arc_position[N_AXIS];  // End point of the last prepped arc segment (steps)
+    float arc_cycles;              // Step time of arc segments without steps, carried over (CPU cycles)
+    float arc_segment_cycles;      // Step time of the last queued arc segment (CPU cycles)
+    uint8_t arc_block_unused;      // Set, while no segment uses the stepper block of the arc block.
+  #endif
+
+  #ifdef STEPPER_FIXED_POINT
+    // Fixed-point copies of the velocity profile above, in fp_shift units. The segment generator
+    // updates only these. The float current_speed and planner block millimeters are refreshed
+    // from them when the planner or the realtime report needs them.
+    float fp_speed_scale;   // Converts mm/min into fixed-point speed for the prepped block.
+    uint32_t fp_current_speed;
+    uint32_t fp_maximum_speed;
+    uint32_t fp_exit_speed;
+    uint32_t fp_acceleration;
+    uint32_t fp_accelerate_until;
+    uint32_t fp_decelerate_after;
+    uint32_t fp_complete;
+  #endif
 } st_prep_t;
 static st_prep_t prep;
 
@@ -235,6 +417,331 @@ static st_prep_t prep;
 */
 
 
+#ifdef STEPPER_FIXED_POINT
+  // Returns a*b/FP_ONE. Skips the multiply for full segment times. Multiplies the 16-bit halves
+  // separately, as four 16x16 bit multiplies are much faster on the AVR than a 64-bit one.
+  // NOTE: Exact, as long as the result fits in 32 bits. Requires an FP_SHIFT of 16.
+  static uint32_t st_fp_mul(uint32_t a, uint32_t b)
+  {
+    if (b == FP_ONE) { return(a); }
+    uint16_t a_high = a >> 16, a_low = a;
+    uint16_t b_high = b >> 16, b_low = b;
+    return((((uint32_t)a_high*b_high) << 16) + (uint32_t)a_high*b_low + (uint32_t)a_low*b_high +
+           (((uint32_t)a_low*b_low) >> 16));
+  }
+
+
+  // Returns a*FP_ONE/b with 32-bit division only. The dividend is shifted up as far as it fits
+  // and the divisor is shifted down by the rest, which keeps the full precision of the dividend.
+  static uint32_t st_fp_div(uint32_t a, uint32_t b)
+  {
+    uint8_t shift = FP_SHIFT;
+    while (shift && !(a & 0x80000000)) { a <<= 1; shift--; }
+    b >>= shift;
+    if (b == 0) { return(0xffffffff); }
+    return(a/b);
+  }
+
+
+  // Returns the time to move from dist down to target at the average of two speeds, where
+  // speed_sum is their sum. Only called at ramp junctions within a segment.
+  static uint32_t st_fp_ramp_time(uint32_t dist, uint32_t target, uint32_t speed_sum)
+  {
+    if (dist <= target) { return(0); }
+    uint32_t time = st_fp_div(2*(dist-target), speed_sum);
+    if (time > FP_MAX_RAMP_TIME) { return(FP_MAX_RAMP_TIME); }
+    return(time);
+  }
+
+
+  // Converts a profile distance from the end of block in mm to fixed-point steps. Clamped to the
+  // exact distance remaining, so float round-off can never move the end of the block.
+  static uint32_t st_fp_distance(float mm)
+  {
+    if (mm <= 0.0) { return(0); }
+    float dist = mm*prep.step_per_mm*((uint32_t)1 << prep.fp_shift);
+    if (dist >= prep.steps_remaining) { return(prep.steps_remaining); }
+    return(dist);
+  }
+
+
+  static float st_fp_get_current_speed()
+  {
+    if (prep.fp_speed_scale == 0.0) { return(0.0); }
+    return(prep.fp_current_speed/prep.fp_speed_scale);
+  }
+
+
+  // Writes the current speed and the remaining block distance back in planner units. Required
+  // before the planner recomputes the prepped block or it is held for a parking motion.
+  static void st_fp_update_plan_block()
+  {
+    prep.current_speed = st_fp_get_current_speed();
+    pl_block->millimeters = prep.steps_remaining/(prep.step_per_mm*((uint32_t)1 << prep.fp_shift));
+  }
+#endif
+
+
+#ifdef S_CURVE_ACCELERATION
+  #define S_CURVE_BRAKE_EXIT bit(0)  // Braking to the exit speed
+  #define S_CURVE_BRAKE_LIMIT bit(1) // Braking to the limit of the next block
+  #define S_CURVE_BRAKE_STOP bit(2)  // Braking to the next planned stop
+  #define S_CURVE_SPEED_TOLERANCE 0.1 // Speed error of a finished ramp (mm/min)
+  #define S_CURVE_MAX_PHASES 8 // Ramp phases computed per call of st_s_curve_advance()
+
+  // Advances speed and accel over the time at a constant jerk. Returns the distance traveled.
+  static float st_s_curve_ramp(float *speed, float *accel, float jerk, float time)
+  {
+    float mm = time*(*speed+time*(0.5*(*accel)+time*jerk*(1.0/6.0)));
+    *speed += time*(*accel+0.5*jerk*time);
+    *accel += jerk*time;
+    return(mm);
+  }
+
+
+  // Returns the distance of the quickest jerk-limited ramp from speed and accel down to the target
+  // speed with zero acceleration. The acceleration ramps down to a peak and back up to zero, holding
+  // at the block deceleration in between when the peak would exceed it. When ramping the
+  // acceleration up to zero alone passes the target, returns the distance of that ramp down to it.
+  static float st_s_curve_brake_mm(float speed, float accel, float target)
+  {
+    float max_accel = plan_block_acceleration(pl_block);
+    float jerk_inv = settings_inverse.jerk_inv;
+    float time;
+    if ((accel <= 0.0) && (speed-0.5*accel*accel*jerk_inv <= target)) {
+      time = -accel*jerk_inv;
+      float speed_sqr = accel*accel-2.0*settings.jerk*(speed-target);
+      if (speed_sqr > 0.0) { time -= sqrt(speed_sqr)*jerk_inv; } // Passes the target first.
+      if (time < 0.0) { time = 0.0; } // At or below the target already.
+      return(time*(speed+time*(0.5*accel+time*settings.jerk*(1.0/6.0))));
+    }
+    float peak = max_accel;
+    float peak_sqr = 0.5*accel*accel+settings.jerk*(speed-target);
+    if (peak_sqr < max_accel*max_accel) { peak = sqrt(peak_sqr); }
+    time = (accel+peak)*jerk_inv;
+    float mm = st_s_curve_ramp(&speed, &accel, -settings.jerk, time);
+    if (peak == max_accel) {
+      float hold_speed = target+0.5*max_accel*max_accel*jerk_inv;
+      mm += (speed*speed-hold_speed*hold_speed)/(2.0*max_accel);
+    }
+    return(mm+peak*jerk_inv*(target+peak*peak*jerk_inv*(1.0/6.0)));
+  }
+
+
+  // Returns true, where braking to the target speed has to begin at the speed and acceleration, mm
+  // before the point to reach it at: the quickest ramp down to it reaches no closer.
+  static uint8_t st_s_curve_brake_needed(float speed, float accel, float target, float mm)
+  {
+    if ((accel >= 0.0) && (speed+0.5*accel*accel*settings_inverse.jerk_inv <= target)) { return(false); }
+    return(st_s_curve_brake_mm(speed, accel, target) > mm);
+  }
+
+
+  // Returns the braking limits to brake for at the speed and acceleration, mm before the end of the
+  // profile. Margin moves the braking points.
+  static uint8_t st_s_curve_brake_limits(float speed, float accel, float mm, float margin)
+  {
+    uint8_t brake = 0;
+    if (st_s_curve_brake_needed(speed, accel, prep.exit_speed, mm+prep.s_curve_exit_mm+margin)) {
+      brake |= S_CURVE_BRAKE_EXIT;
+    }
+    if (st_s_curve_brake_needed(speed, accel, prep.s_curve_limit_speed, mm+prep.s_curve_limit_mm+margin)) {
+      brake |= S_CURVE_BRAKE_LIMIT;
+    }
+    if (st_s_curve_brake_needed(speed, accel, 0.0, mm+prep.s_curve_stop_mm+margin)) { brake |= S_CURVE_BRAKE_STOP; }
+    return(brake);
+  }
+
+
+  // Computes the jerk-limited profile of the prepped block. The ramps are computed as they run by
+  // st_s_curve_advance(), from the current speed and acceleration. The profile only sets the speed
+  // to cruise at and its braking limits: the exit speed at the next junction, and the limit and the
+  // next stop kept by the next block, some distance past it. See planner.c.
+  static void st_s_curve_compute_profile()
+  {
+    float max_accel = plan_block_acceleration(pl_block);
+    if (prep.current_accel > max_accel) { prep.current_accel = max_accel; }
+    else if (prep.current_accel < -max_accel) { prep.current_accel = -max_accel; }
+    prep.ramp_type = RAMP_S_CURVE;
+    prep.maximum_speed = plan_compute_profile_nominal_speed(pl_block);
+    prep.exit_speed = 0.0;
+    prep.s_curve_exit_mm = 0.0;
+    if (sys.step_control & STEP_CONTROL_EXECUTE_HOLD) {
+      // Brake to a stop right away. The hold ends in this block, if it is long enough.
+      float stop_mm = st_s_curve_brake_mm(prep.current_speed, prep.current_accel, 0.0);
+      if (stop_mm < pl_block->millimeters) { prep.mm_complete = pl_block->millimeters-stop_mm; }
+      else { prep.s_curve_exit_mm = stop_mm-pl_block->millimeters; }
+      prep.s_curve_limit_speed = 0.0;
+      prep.s_curve_limit_mm = prep.s_curve_stop_mm = prep.s_curve_exit_mm;
+      prep.s_curve_brake = S_CURVE_BRAKE_EXIT | S_CURVE_BRAKE_LIMIT | S_CURVE_BRAKE_STOP;
+    } else {
+      prep.s_curve_limit_speed = 0.0;
+      prep.s_curve_limit_mm = prep.s_curve_stop_mm = 0.0;
+      if (!(sys.step_control & STEP_CONTROL_EXECUTE_SYS_MOTION)) { // System motions stop at the end.
+        prep.exit_speed = sqrt(plan_get_exec_block_exit_max_speed_sqr());
+        if (prep.exit_speed > prep.maximum_speed) { prep.exit_speed = prep.maximum_speed; }
+        plan_get_exec_block_exit_brake(&prep.s_curve_limit_speed, &prep.s_curve_limit_mm, &prep.s_curve_stop_mm);
+        if (prep.s_curve_limit_speed > prep.maximum_speed) { prep.s_curve_limit_speed = prep.maximum_speed; }
+      }
+      // Too late to reach a limit with the acceleration back at zero, where a new block tightened
+      // the plan. Stop at it instead. See planner.c.
+      uint8_t brake = st_s_curve_brake_limits(prep.current_speed, prep.current_accel, pl_block->millimeters,
+                                              prep.req_mm_increment);
+      if (brake & S_CURVE_BRAKE_EXIT) { prep.exit_speed = 0.0; }
+      if (brake & S_CURVE_BRAKE_LIMIT) { prep.s_curve_limit_speed = 0.0; }
+      // A replan leaves a braking ramp on its limit. Keep braking within round-off of it.
+      float margin = 0.0;
+      if (prep.s_curve_brake) { margin = -prep.req_mm_increment; }
+      prep.s_curve_brake = st_s_curve_brake_limits(prep.current_speed, prep.current_accel, pl_block->millimeters, margin);
+    }
+  }
+
+
+  // Advances the jerk-limited ramp by time_var, updating mm_remaining and the current speed and
+  // acceleration. Cuts time_var to the ramp time used, when the profile ends first. The ramp runs
+  // the quickest way to its target speed, ramping the acceleration up to a peak at the jerk limit,
+  // holding it at the block acceleration, if reached, and ramping it back to zero at the target.
+  // The target is the maximum speed, until braking begins. Braking for a limit begins where the ramp
+  // reaches it, found within the phase, and holds to the end of the profile. The target is then the
+  // lowest speed of the limits braked for.
+  static void st_s_curve_advance(float *time_var, float *mm_remaining)
+  {
+    float max_accel = plan_block_acceleration(pl_block);
+    float speed = prep.current_speed;
+    float accel = prep.current_accel;
+    float mm = *mm_remaining-prep.mm_complete; // Distance to the end of the profile
+    float time_left = *time_var;
+    uint8_t phase;
+    for (phase = 0; phase < S_CURVE_MAX_PHASES; phase++) {
+      float target = prep.maximum_speed;
+      if ((prep.s_curve_brake & S_CURVE_BRAKE_EXIT) && (target > prep.exit_speed)) { target = prep.exit_speed; }
+      if ((prep.s_curve_brake & S_CURVE_BRAKE_LIMIT) && (target > prep.s_curve_limit_speed)) {
+        target = prep.s_curve_limit_speed;
+      }
+      if (prep.s_curve_brake & S_CURVE_BRAKE_STOP) { target = 0.0; }
+
+      // Peak acceleration of the phase, from the speed error left once the acceleration is ramped
+      // to zero. Holds at the peak, once reached, until ramping down reaches the target.
+      float error = speed+0.5*accel*fabs(accel)*settings_inverse.jerk_inv-target;
+      float peak = 0.0;
+      if (error > S_CURVE_SPEED_TOLERANCE) {
+        peak = -max_accel;
+        if (0.5*accel*accel+settings.jerk*(speed-target) < max_accel*max_accel) {
+          peak = -sqrt(0.5*accel*accel+settings.jerk*(speed-target));
+        }
+      } else if (error < -S_CURVE_SPEED_TOLERANCE) {
+        peak = max_accel;
+        if (0.5*accel*accel+settings.jerk*(target-speed) < max_accel*max_accel) {
+          peak = sqrt(0.5*accel*accel+settings.jerk*(target-speed));
+        }
+      }
+      float jerk = 0.0;
+      float time;
+      if (accel != peak) {
+        jerk = settings.jerk;
+        if (peak < accel) { jerk = -jerk; }
+        time = (peak-accel)/jerk;
+      } else if (peak != 0.0) {
+        time = fabs(error)/max_accel;
+      } else { // Cruise at the target.
+        speed = target;
+        time = time_left;
+      }
+      uint8_t phase_complete = false;
+      if (time <= time_left) { phase_complete = true; }
+      else { time = time_left; }
+
+      float next_speed = speed;
+      float next_accel = accel;
+      float mm_var = st_s_curve_ramp(&next_speed, &next_accel, jerk, time);
+      uint8_t profile_end = false;
+      if (mm_var >= mm) {
+        // End of the profile. Find its time from the distance with a few Newton iterations.
+        uint8_t idx;
+        float time_var = 0.0;
+        if (mm_var > 0.0) { time_var = time*(mm/mm_var); }
+        for (idx=0; idx<3; idx++) {
+          next_speed = speed;
+          next_accel = accel;
+          mm_var = st_s_curve_ramp(&next_speed, &next_accel, jerk, time_var);
+          if (next_speed <= 0.0) { break; }
+          time_var -= (mm_var-mm)/next_speed;
+          if (time_var > time) { time_var = time; }
+          else if (time_var < 0.0) { time_var = 0.0; }
+        }
+        time = time_var;
+        next_speed = speed;
+        next_accel = accel;
+        mm_var = st_s_curve_ramp(&next_speed, &next_accel, jerk, time);
+        profile_end = true;
+      }
+      uint8_t brake = st_s_curve_brake_limits(next_speed, next_accel, mm-mm_var, 0.0) & ~prep.s_curve_brake;
+      if (brake) {
+        // Braking for a limit begins within the phase. Bisect for the last time before it.
+        float time_lo = 0.0;
+        float time_hi = time;
+        uint8_t idx;
+        for (idx=0; idx<8; idx++) {
+          float time_var = 0.5*(time_lo+time_hi);
+          next_speed = speed;
+          next_accel = accel;
+          mm_var = st_s_curve_ramp(&next_speed, &next_accel, jerk, time_var);
+          uint8_t brake_var = st_s_curve_brake_limits(next_speed, next_accel, mm-mm_var, 0.0) & ~prep.s_curve_brake;
+          if (brake_var) {
+            time_hi = time_var;
+            brake = brake_var;
+          } else {
+            time_lo = time_var;
+          }
+        }
+        time = time_lo;
+        next_speed = speed;
+        next_accel = accel;
+        mm_var = st_s_curve_ramp(&next_speed, &next_accel, jerk, time);
+        prep.s_curve_brake |= brake;
+        phase_complete = false;
+        profile_end = false;
+      }
+      if (profile_end) {
+        time_left -= time;
+        mm = 0.0;
+        speed = next_speed;
+        accel = next_accel;
+        if ((prep.exit_speed == 0.0) && (prep.s_curve_exit_mm == 0.0)) { speed = accel = 0.0; } // Planned stop.
+        break;
+      }
+      if (phase_complete) { // Remove round-off at the end of the phase.
+        next_accel = peak;
+        if ((jerk != 0.0) && (peak == 0.0)) { next_speed = target; }
+      }
+      speed = next_speed;
+      accel = next_accel;
+      if (speed <= 0.0) {
+        speed = 0.0;
+        if (accel < 0.0) { accel = 0.0; }
+      }
+      mm -= mm_var;
+      time_left -= time;
+
+      if ((speed == 0.0) && (accel == 0.0) && prep.s_curve_brake) {
+        // Stopped. Within round-off of the end of the profile, end it. Otherwise, the ramp ended
+        // short of a stop planned further on and moves on.
+        if (mm <= prep.req_mm_increment) {
+          mm = 0.0;
+          break;
+        }
+        prep.s_curve_brake = 0;
+      }
+      if (time_left <= 0.0) { break; }
+    }
+    prep.current_speed = speed;
+    prep.current_accel = accel;
+    *time_var -= time_left;
+    *mm_remaining = prep.mm_complete+mm;
+  }
+#endif
+
+
 // Stepper state initialization. Cycle should only start if the st.cycle_start flag is
 // enabled. Startup init and limits call this function but shouldn't start the cycle.
 
@@ -278,7 +785,7 @@ void st_wake_up()
       #endif
     }
     // Initialize stepper output bits to ensure first ISR call does not step.
-    for (idx = 0; idx < N_AXIS; idx++) {
+    for (idx = 0; idx < STEP_PORT_GROUPS; idx++) {
       st.step_outbits[idx] = step_port_invert_mask[idx];
     }
   #else
@@ -406,17 +913,28 @@ void st_go_idle()
 // with probing and homing cycles that require true real-time positions.
 ISR(TIMER1_COMPA_vect)
 {
+  #ifdef STEPPER_ISR_PROFILE
+    uint16_t profile_start = TCNT5;
+    uint8_t profile_load = ST_PROFILE_LOAD_NONE;
+  #endif
+  #ifdef STEPPER_TRACE
+    uint8_t trace_event;
+  #endif
   #ifdef DEFAULTS_RAMPS_BOARD
     int i;
   #endif // Ramps Board
 
-  if (busy) { return; } // The busy-flag is used to avoid reentering this interrupt
+  if (busy) { // The busy-flag is used to avoid reentering this interrupt
+    #ifdef STEPPER_ISR_PROFILE
+      st_profile_overruns++;
+    #endif
+    return;
+  }
 
   #ifdef DEFAULTS_RAMPS_BOARD
-    // Adding limit check status to implement hardware limits for RAMPS
-    // outside the changepin interrupt wich cannot be used
+    // Polls the RAMPS limit pins that cannot raise a limit interrupt. See cpu_map.h.
     #ifdef ENABLE_RAMPS_HW_LIMITS
-      if (limits_get_state()) {
+      if (limits_get_polled_state()) {
         ramps_hard_limit();
       }
     #endif
@@ -424,17 +942,16 @@ ISR(TIMER1_COMPA_vect)
 
   // Set the direction pins a couple of nanoseconds before we step the steppers
   #ifdef DEFAULTS_RAMPS_BOARD
-    DIRECTION_PORT(0) = (DIRECTION_PORT(0) & ~(1 << DIRECTION_BIT(0))) | st.dir_outbits[0];
-    DIRECTION_PORT(1) = (DIRECTION_PORT(1) & ~(1 << DIRECTION_BIT(1))) | st.dir_outbits[1];
-    DIRECTION_PORT(2) = (DIRECTION_PORT(2) & ~(1 << DIRECTION_BIT(2))) | st.dir_outbits[2];
-    #if N_AXIS > 3
-    DIRECTION_PORT(3) = (DIRECTION_PORT(3) & ~(1 << DIRECTION_BIT(3))) | st.dir_outbits[3];
+    DIRECTION_GROUP_WRITE(0, st.dir_outbits[0]);
+    DIRECTION_GROUP_WRITE(1, st.dir_outbits[1]);
+    #if DIRECTION_PORT_GROUPS > 2
+      DIRECTION_GROUP_WRITE(2, st.dir_outbits[2]);
     #endif
-    #if N_AXIS > 4
-    DIRECTION_PORT(4) = (DIRECTION_PORT(4) & ~(1 << DIRECTION_BIT(4))) | st.dir_outbits[4];
+    #if DIRECTION_PORT_GROUPS > 3
+      DIRECTION_GROUP_WRITE(3, st.dir_outbits[3]);
     #endif
-    #if N_AXIS > 5
-    DIRECTION_PORT(5) = (DIRECTION_PORT(5) & ~(1 << DIRECTION_BIT(5))) | st.dir_outbits[5];
+    #if DIRECTION_PORT_GROUPS > 4
+      DIRECTION_GROUP_WRITE(4, st.dir_outbits[4]);
     #endif
   #else
     DIRECTION_PORT = (DIRECTION_PORT & ~DIRECTION_MASK) | (st.dir_outbits & DIRECTION_MASK);
@@ -443,30 +960,22 @@ ISR(TIMER1_COMPA_vect)
   // Then pulse the stepping pins
   #ifdef DEFAULTS_RAMPS_BOARD
     #ifdef STEP_PULSE_DELAY
-      st.step_bits[0] = (STEP_PORT(0) & ~(1 << STEP_BIT(0))) | st.step_outbits[0]; // Store out_bits to prevent overwriting.
-      st.step_bits[1] = (STEP_PORT(1) & ~(1 << STEP_BIT(1))) | st.step_outbits[1]; // Store out_bits to prevent overwriting.
-      st.step_bits[2] = (STEP_PORT(2) & ~(1 << STEP_BIT(2))) | st.step_outbits[2]; // Store out_bits to prevent overwriting.
-      #if N_AXIS > 3
-        st.step_bits[3] = (STEP_PORT(3) & ~(1 << STEP_BIT(3))) | st.step_outbits[3]; // Store out_bits to prevent overwriting.
-      #endif
-      #if N_AXIS > 4
-        st.step_bits[4] = (STEP_PORT(4) & ~(1 << STEP_BIT(4))) | st.step_outbits[4]; // Store out_bits to prevent overwriting.
+      st.step_bits[0] = (STEP_GROUP_PORT(0) & ~STEP_GROUP_MASK(0)) | st.step_outbits[0]; // Store out_bits to prevent overwriting.
+      st.step_bits[1] = (STEP_GROUP_PORT(1) & ~STEP_GROUP_MASK(1)) | st.step_outbits[1];
+      #if STEP_PORT_GROUPS > 2
+        st.step_bits[2] = (STEP_GROUP_PORT(2) & ~STEP_GROUP_MASK(2)) | st.step_outbits[2];
       #endif
-      #if N_AXIS > 5
-        st.step_bits[5] = (STEP_PORT(5) & ~(1 << STEP_BIT(5))) | st.step_outbits[5]; // Store out_bits to prevent overwriting.
+      #if STEP_PORT_GROUPS > 3
+        st.step_bits[3] = (STEP_GROUP_PORT(3) & ~STEP_GROUP_MASK(3)) | st.step_outbits[3];
       #endif
     #else
-      STEP_PORT(0) = (STEP_PORT(0) & ~(1 << STEP_BIT(0))) | st.step_outbits[0];
-      STEP_PORT(1) = (STEP_PORT(1) & ~(1 << STEP_BIT(1))) | st.step_outbits[1];
-      STEP_PORT(2) = (STEP_PORT(2) & ~(1 << STEP_BIT(2))) | st.step_outbits[2];
-      #if N_AXIS > 3
-        STEP_PORT(3) = (STEP_PORT(3) & ~(1 << STEP_BIT(3))) | st.step_outbits[3];
+      STEP_GROUP_WRITE(0, st.step_outbits[0]);
+      STEP_GROUP_WRITE(1, st.step_outbits[1]);
+      #if STEP_PORT_GROUPS > 2
+        STEP_GROUP_WRITE(2, st.step_outbits[2]);
       #endif
-      #if N_AXIS > 4
-        STEP_PORT(4) = (STEP_PORT(4) & ~(1 << STEP_BIT(4))) | st.step_outbits[4];
-      #endif
-      #if N_AXIS > 5
-        STEP_PORT(5) = (STEP_PORT(5) & ~(1 << STEP_BIT(5))) | st.step_outbits[5];
+      #if STEP_PORT_GROUPS > 3
+        STEP_GROUP_WRITE(3, st.step_outbits[3]);
       #endif
     #endif
   #else
@@ -492,6 +1001,12 @@ ISR(TIMER1_COMPA_vect)
     if (segment_buffer_head != segment_buffer_tail) {
       // Initialize new step segment and load number of steps to execute
       st.exec_segment = &segment_buffer[segment_buffer_tail];
+      #ifdef STEPPER_ISR_PROFILE
+        profile_load = ST_PROFILE_LOAD_SEGMENT;
+      #endif
+      #ifdef STEPPER_TRACE
+        trace_event = ST_TRACE_SEGMENT;
+      #endif
 
       #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
         // With AMASS is disabled, set timer prescaler for segments with slow step frequencies (< 250Hz).
@@ -506,6 +1021,16 @@ ISR(TIMER1_COMPA_vect)
       if ( st.exec_block_index != st.exec_segment->st_block_index ) {
         st.exec_block_index = st.exec_segment->st_block_index;
         st.exec_block = &st_block_buffer[st.exec_block_index];
+        #ifdef STEPPER_ISR_PROFILE
+          profile_load = ST_PROFILE_LOAD_BLOCK;
+        #endif
+        #ifdef STEPPER_TRACE
+          trace_event = ST_TRACE_BLOCK;
+        #endif
+        #ifdef QUEUE_ACCESSORY_CHANGES
+          // Homing and parking motions leave the spindle and coolant to their own routines.
+          if (!(st.exec_block->accessory & PL_COND_FLAG_SYSTEM_MOTION)) { st_update_accessory(st.exec_block->accessory); }
+        #endif
 
         // Initialize Bresenham line and distance counters
         #if N_AXIS == 4
@@ -519,7 +1044,7 @@ ISR(TIMER1_COMPA_vect)
         #endif
       }
       #ifdef DEFAULTS_RAMPS_BOARD
-        for (i = 0; i < N_AXIS; i++)
+        for (i = 0; i < DIRECTION_PORT_GROUPS; i++)
           st.dir_outbits[i] = st.exec_block->direction_bits[i] ^ dir_port_invert_mask[i];
       #else
         st.dir_outbits = st.exec_block->direction_bits ^ dir_port_invert_mask;
@@ -541,6 +1066,24 @@ ISR(TIMER1_COMPA_vect)
         #endif
       #endif
 
+      #ifdef STEPPER_TRACE
+        // Segments left in the buffer, counting the one just loaded.
+        uint8_t trace_queued = segment_buffer_head - segment_buffer_tail;
+        if (segment_buffer_head < segment_buffer_tail) { trace_queued += SEGMENT_BUFFER_SIZE; }
+        #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+          if ((trace_event == ST_TRACE_SEGMENT) && (st.exec_segment->amass_level != st_trace_level)) {
+            trace_event = ST_TRACE_AMASS;
+          }
+          st_trace_level = st.exec_segment->amass_level;
+          st_trace_record(trace_event, st.exec_segment->cycles_per_tick, st_trace_level, trace_queued);
+        #else
+          st_trace_record(trace_event, st.exec_segment->cycles_per_tick, st.exec_segment->prescaler, trace_queued);
+        #endif
+      #endif
+      #ifdef SEGMENT_BUFFER_STATS
+        st_stats_segment_loaded();
+      #endif
+
       // Set real-time spindle output as segment is loaded, just prior to the first step.
       spindle_set_speed(st.exec_segment->spindle_pwm);
 
@@ -550,9 +1093,28 @@ ISR(TIMER1_COMPA_vect)
       // Ensure pwm is set properly upon completion of rate-controlled motion.
       if (st.exec_block->is_pwm_rate_adjusted) { spindle_set_speed(SPINDLE_PWM_OFF_VALUE); }
       system_set_exec_state_flag(EXEC_CYCLE_STOP); // Flag main program for cycle end
+      #ifdef STEPPER_ISR_PROFILE
+        st_profile_record(ST_PROFILE_IDLE, profile_start);
+      #endif
+      #ifdef STEPPER_TRACE
+        // The segment buffer ran dry. If the planner still holds blocks outside of a feed hold,
+        // segment preparation did not keep up.
+        uint8_t trace_blocks = plan_get_block_buffer_count();
+        if (trace_blocks && !(sys.step_control & STEP_CONTROL_END_MOTION)) { trace_event = ST_TRACE_UNDERRUN; }
+        else { trace_event = ST_TRACE_IDLE; }
+        st_trace_record(trace_event, 0, 0, trace_blocks);
+      #endif
+      #ifdef SEGMENT_BUFFER_STATS
+        st_stats_buffer_empty();
+      #endif
       return; // Nothing to do but exit.
     }
   }
+  #ifdef STEPPER_ISR_PROFILE
+    #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+      profile_load = profile_load*ST_PROFILE_LEVELS + st.exec_segment->amass_level;
+    #endif
+  #endif
 
 
   // Check probing state.
@@ -560,7 +1122,7 @@ ISR(TIMER1_COMPA_vect)
 
   // Reset step out bits.
   #ifdef DEFAULTS_RAMPS_BOARD
-    for (i = 0; i < N_AXIS; i++)
+    for (i = 0; i < STEP_PORT_GROUPS; i++)
       st.step_outbits[i] = 0;
   #else
     st.step_outbits = 0;
@@ -574,9 +1136,9 @@ ISR(TIMER1_COMPA_vect)
   #endif
   #ifdef DEFAULTS_RAMPS_BOARD
     if (st.counter_x > st.exec_block->step_event_count) {
-      st.step_outbits[AXIS_1] |= (1<<STEP_BIT(AXIS_1));
+      st.step_outbits[STEP_GROUP(AXIS_1)] |= (1<<STEP_BIT(AXIS_1));
       st.counter_x -= st.exec_block->step_event_count;
-      if (st.exec_block->direction_bits[AXIS_1] & (1<<DIRECTION_BIT(AXIS_1))) { sys_position[AXIS_1]--; }
+      if (st.exec_block->direction_bits[DIRECTION_GROUP(AXIS_1)] & (1<<DIRECTION_BIT(AXIS_1))) { sys_position[AXIS_1]--; }
       else { sys_position[AXIS_1]++; }
     }
   #else
@@ -595,9 +1157,9 @@ ISR(TIMER1_COMPA_vect)
   #endif
   #ifdef DEFAULTS_RAMPS_BOARD
     if (st.counter_y > st.exec_block->step_event_count) {
-      st.step_outbits[AXIS_2] |= (1<<STEP_BIT(AXIS_2));
+      st.step_outbits[STEP_GROUP(AXIS_2)] |= (1<<STEP_BIT(AXIS_2));
       st.counter_y -= st.exec_block->step_event_count;
-      if (st.exec_block->direction_bits[AXIS_2] & (1<<DIRECTION_BIT(AXIS_2))) { sys_position[AXIS_2]--; }
+      if (st.exec_block->direction_bits[DIRECTION_GROUP(AXIS_2)] & (1<<DIRECTION_BIT(AXIS_2))) { sys_position[AXIS_2]--; }
       else { sys_position[AXIS_2]++; }
     }
   #else
@@ -615,9 +1177,9 @@ ISR(TIMER1_COMPA_vect)
   #endif
   #ifdef DEFAULTS_RAMPS_BOARD
     if (st.counter_z > st.exec_block->step_event_count) {
-      st.step_outbits[AXIS_3] |= (1<<STEP_BIT(AXIS_3));
+      st.step_outbits[STEP_GROUP(AXIS_3)] |= (1<<STEP_BIT(AXIS_3));
       st.counter_z -= st.exec_block->step_event_count;
-      if (st.exec_block->direction_bits[AXIS_3] & (1<<DIRECTION_BIT(AXIS_3))) { sys_position[AXIS_3]--; }
+      if (st.exec_block->direction_bits[DIRECTION_GROUP(AXIS_3)] & (1<<DIRECTION_BIT(AXIS_3))) { sys_position[AXIS_3]--; }
       else { sys_position[AXIS_3]++; }
     }
   #else
@@ -636,9 +1198,9 @@ ISR(TIMER1_COMPA_vect)
     #endif
     #ifdef DEFAULTS_RAMPS_BOARD
       if (st.counter_4 > st.exec_block->step_event_count) {
-        st.step_outbits[AXIS_4] |= (1<<STEP_BIT(AXIS_4));
+        st.step_outbits[STEP_GROUP(AXIS_4)] |= (1<<STEP_BIT(AXIS_4));
         st.counter_4 -= st.exec_block->step_event_count;
-        if (st.exec_block->direction_bits[AXIS_4] & (1<<DIRECTION_BIT(AXIS_4))) { sys_position[AXIS_4]--; }
+        if (st.exec_block->direction_bits[DIRECTION_GROUP(AXIS_4)] & (1<<DIRECTION_BIT(AXIS_4))) { sys_position[AXIS_4]--; }
         else { sys_position[AXIS_4]++; }
       }
     #endif // Ramps Board
@@ -651,9 +1213,9 @@ ISR(TIMER1_COMPA_vect)
     #endif
     #ifdef DEFAULTS_RAMPS_BOARD
       if (st.counter_5 > st.exec_block->step_event_count) {
-        st.step_outbits[AXIS_5] |= (1<<STEP_BIT(AXIS_5));
+        st.step_outbits[STEP_GROUP(AXIS_5)] |= (1<<STEP_BIT(AXIS_5));
         st.counter_5 -= st.exec_block->step_event_count;
-        if (st.exec_block->direction_bits[AXIS_5] & (1<<DIRECTION_BIT(AXIS_5))) { sys_position[AXIS_5]--; }
+        if (st.exec_block->direction_bits[DIRECTION_GROUP(AXIS_5)] & (1<<DIRECTION_BIT(AXIS_5))) { sys_position[AXIS_5]--; }
         else { sys_position[AXIS_5]++; }
       }
     #endif // Ramps Board
@@ -666,9 +1228,9 @@ ISR(TIMER1_COMPA_vect)
     #endif
     #ifdef DEFAULTS_RAMPS_BOARD
       if (st.counter_6 > st.exec_block->step_event_count) {
-        st.step_outbits[AXIS_6] |= (1<<STEP_BIT(AXIS_6));
+        st.step_outbits[STEP_GROUP(AXIS_6)] |= (1<<STEP_BIT(AXIS_6));
         st.counter_6 -= st.exec_block->step_event_count;
-        if (st.exec_block->direction_bits[AXIS_6] & (1<<DIRECTION_BIT(AXIS_6))) { sys_position[AXIS_6]--; }
+        if (st.exec_block->direction_bits[DIRECTION_GROUP(AXIS_6)] & (1<<DIRECTION_BIT(AXIS_6))) { sys_position[AXIS_6]--; }
         else { sys_position[AXIS_6]++; }
       }
     #endif // Ramps Board
@@ -676,7 +1238,7 @@ ISR(TIMER1_COMPA_vect)
 
   // During a homing cycle, lock out and prevent desired axes from moving.
   #ifdef DEFAULTS_RAMPS_BOARD
-    for (i = 0; i < N_AXIS; i++)
+    for (i = 0; i < STEP_PORT_GROUPS; i++)
     if (sys.state == STATE_HOMING) { st.step_outbits[i] &= sys.homing_axis_lock[i]; }
   #else
     if (sys.state == STATE_HOMING) { st.step_outbits &= sys.homing_axis_lock; }
@@ -688,11 +1250,15 @@ ISR(TIMER1_COMPA_vect)
     if ( ++segment_buffer_tail == SEGMENT_BUFFER_SIZE) { segment_buffer_tail = 0; }
   }
   #ifdef DEFAULTS_RAMPS_BOARD
-    for (i = 0; i < N_AXIS; i++)
+    for (i = 0; i < STEP_PORT_GROUPS; i++)
       st.step_outbits[i] ^= step_port_invert_mask[i];  // Apply step port invert mask
   #else
     st.step_outbits ^= step_port_invert_mask;  // Apply step port invert mask
   #endif // Ramps Board
+  #ifdef STEPPER_ISR_PROFILE
+    // NOTE: Includes the port reset interrupt, if it fired while this one was running.
+    st_profile_record(profile_load, profile_start);
+  #endif
   busy = false;
 }
 
@@ -710,24 +1276,26 @@ ISR(TIMER1_COMPA_vect)
 // completing one step cycle.
 ISR(TIMER0_OVF_vect)
 {
+  #ifdef STEPPER_ISR_PROFILE
+    uint16_t profile_start = TCNT5;
+  #endif
   // Reset stepping pins (leave the direction pins)
   #ifdef DEFAULTS_RAMPS_BOARD
-    STEP_PORT(0) = (STEP_PORT(0) & ~(1 << STEP_BIT(0))) | step_port_invert_mask[0];
-    STEP_PORT(1) = (STEP_PORT(1) & ~(1 << STEP_BIT(1))) | step_port_invert_mask[1];
-    STEP_PORT(2) = (STEP_PORT(2) & ~(1 << STEP_BIT(2))) | step_port_invert_mask[2];
-    #if N_AXIS > 3
-      STEP_PORT(3) = (STEP_PORT(3) & ~(1 << STEP_BIT(3))) | step_port_invert_mask[3];
+    STEP_GROUP_WRITE(0, step_port_invert_mask[0]);
+    STEP_GROUP_WRITE(1, step_port_invert_mask[1]);
+    #if STEP_PORT_GROUPS > 2
+      STEP_GROUP_WRITE(2, step_port_invert_mask[2]);
     #endif
-    #if N_AXIS > 4
-      STEP_PORT(4) = (STEP_PORT(4) & ~(1 << STEP_BIT(4))) | step_port_invert_mask[4];
-    #endif
-    #if N_AXIS > 5
-      STEP_PORT(5) = (STEP_PORT(5) & ~(1 << STEP_BIT(5))) | step_port_invert_mask[5];
+    #if STEP_PORT_GROUPS > 3
+      STEP_GROUP_WRITE(3, step_port_invert_mask[3]);
     #endif
   #else
     STEP_PORT = (STEP_PORT & ~STEP_MASK) | (step_port_invert_mask & STEP_MASK);
   #endif // Ramps Board
   TCCR0B = 0; // Disable Timer0 to prevent re-entering this interrupt when it's not needed.
+  #ifdef STEPPER_ISR_PROFILE
+    st_profile_record(ST_PROFILE_PORT_RESET, profile_start);
+  #endif
 }
 #ifdef STEP_PULSE_DELAY
   // This interrupt is used only when STEP_PULSE_DELAY is enabled. Here, the step pulse is
@@ -738,17 +1306,13 @@ ISR(TIMER0_OVF_vect)
   ISR(TIMER0_COMPA_vect)
   {
     #ifdef DEFAULTS_RAMPS_BOARD
-      STEP_PORT(0) = st.step_bits[0]; // Begin step pulse.
-      STEP_PORT(1) = st.step_bits[1]; // Begin step pulse.
-      STEP_PORT(2) = st.step_bits[2]; // Begin step pulse.
-      #if N_AXIS > 3
-        STEP_PORT(3) = st.step_bits[3]; // Begin step pulse.
+      STEP_GROUP_PORT(0) = st.step_bits[0]; // Begin step pulse.
+      STEP_GROUP_PORT(1) = st.step_bits[1];
+      #if STEP_PORT_GROUPS > 2
+        STEP_GROUP_PORT(2) = st.step_bits[2];
       #endif
-      #if N_AXIS > 4
-        STEP_PORT(4) = st.step_bits[4]; // Begin step pulse.
-      #endif
-      #if N_AXIS > 5
-        STEP_PORT(5) = st.step_bits[5]; // Begin step pulse.
+      #if STEP_PORT_GROUPS > 3
+        STEP_GROUP_PORT(3) = st.step_bits[3];
       #endif
     #else
       STEP_PORT = st.step_bits; // Begin step pulse.
@@ -762,9 +1326,11 @@ void st_generate_step_dir_invert_masks()
 {
   uint8_t idx;
   #ifdef DEFAULTS_RAMPS_BOARD
+    memset(step_port_invert_mask, 0, sizeof(step_port_invert_mask));
+    memset(dir_port_invert_mask, 0, sizeof(dir_port_invert_mask));
     for (idx=0; idx<N_AXIS; idx++) {
-      if (bit_istrue(settings.step_invert_mask,bit(idx))) { step_port_invert_mask[idx] = get_step_pin_mask(idx); }
-      if (bit_istrue(settings.dir_invert_mask,bit(idx))) { dir_port_invert_mask[idx] = get_direction_pin_mask(idx); }
+      if (bit_istrue(settings.step_invert_mask,bit(idx))) { step_port_invert_mask[get_step_port_group(idx)] |= get_step_pin_mask(idx); }
+      if (bit_istrue(settings.dir_invert_mask,bit(idx))) { dir_port_invert_mask[get_direction_port_group(idx)] |= get_direction_pin_mask(idx); }
     }
   #else
     step_port_invert_mask = 0;
@@ -799,29 +1365,29 @@ void st_reset()
 
   st_generate_step_dir_invert_masks();
   #ifdef DEFAULTS_RAMPS_BOARD
-    for (idx=0; idx<N_AXIS; idx++) {
+    for (idx=0; idx<DIRECTION_PORT_GROUPS; idx++) {
       st.dir_outbits[idx] = dir_port_invert_mask[idx]; // Initialize direction bits to default.
     }
 
-    STEP_PORT(0) = (STEP_PORT(0) & ~(1 << STEP_BIT(0))) | step_port_invert_mask[0];
-    DIRECTION_PORT(0) = (DIRECTION_PORT(0) & ~(1 << DIRECTION_BIT(0))) | dir_port_invert_mask[0];
-
-    STEP_PORT(1) = (STEP_PORT(1) & ~(1 << STEP_BIT(1))) | step_port_invert_mask[1];
-    DIRECTION_PORT(1) = (DIRECTION_PORT(1) & ~(1 << DIRECTION_BIT(1))) | dir_port_invert_mask[1];
-
-    STEP_PORT(2) = (STEP_PORT(2) & ~(1 << STEP_BIT(2))) | step_port_invert_mask[2];
-    DIRECTION_PORT(2) = (DIRECTION_PORT(2) & ~(1 << DIRECTION_BIT(2))) | dir_port_invert_mask[2];
-    #if N_AXIS > 3
-      STEP_PORT(3) = (STEP_PORT(3) & ~(1 << STEP_BIT(3))) | step_port_invert_mask[3];
-      DIRECTION_PORT(3) = (DIRECTION_PORT(3) & ~(1 << DIRECTION_BIT(3))) | dir_port_invert_mask[3];
+    // Initialize step and direction port pins.
+    STEP_GROUP_WRITE(0, step_port_invert_mask[0]);
+    STEP_GROUP_WRITE(1, step_port_invert_mask[1]);
+    #if STEP_PORT_GROUPS > 2
+      STEP_GROUP_WRITE(2, step_port_invert_mask[2]);
     #endif
-    #if N_AXIS > 4
-      STEP_PORT(4) = (STEP_PORT(4) & ~(1 << STEP_BIT(4))) | step_port_invert_mask[4];
-      DIRECTION_PORT(4) = (DIRECTION_PORT(4) & ~(1 << DIRECTION_BIT(4))) | dir_port_invert_mask[4];
+    #if STEP_PORT_GROUPS > 3
+      STEP_GROUP_WRITE(3, step_port_invert_mask[3]);
     #endif
-    #if N_AXIS > 5
-      STEP_PORT(5) = (STEP_PORT(5) & ~(1 << STEP_BIT(5))) | step_port_invert_mask[5];
-      DIRECTION_PORT(5) = (DIRECTION_PORT(5) & ~(1 << DIRECTION_BIT(5))) | dir_port_invert_mask[5];
+    DIRECTION_GROUP_WRITE(0, dir_port_invert_mask[0]);
+    DIRECTION_GROUP_WRITE(1, dir_port_invert_mask[1]);
+    #if DIRECTION_PORT_GROUPS > 2
+      DIRECTION_GROUP_WRITE(2, dir_port_invert_mask[2]);
+    #endif
+    #if DIRECTION_PORT_GROUPS > 3
+      DIRECTION_GROUP_WRITE(3, dir_port_invert_mask[3]);
+    #endif
+    #if DIRECTION_PORT_GROUPS > 4
+      DIRECTION_GROUP_WRITE(4, dir_port_invert_mask[4]);
     #endif
   #else
     st.dir_outbits = dir_port_invert_mask; // Initialize direction bits to default.
@@ -898,14 +1464,124 @@ void stepper_init()
   #ifdef STEP_PULSE_DELAY
     TIMSK0 |= (1<<OCIE0A); // Enable Timer0 Compare Match A interrupt
   #endif
+
+  #ifdef STEPPER_ISR_PROFILE
+    // Configure Timer 5: Free-running cycle counter for the interrupt profiler
+    TCCR5A = 0; // Normal operation
+    TCCR5B = (1<<CS50); // Full speed, no prescaler
+  #endif
+  #ifdef STEPPER_TRACE
+    // Configure Timer 5: Free-running 4usec timestamp counter for the step event trace
+    TCCR5A = 0; // Normal operation
+    TCCR5B = (1<<CS51) | (1<<CS50); // 1/64 prescaler
+    st_trace_running = true;
+  #endif
+  #ifdef SEGMENT_BUFFER_STATS
+    st_reset_buffer_stats();
+  #endif
 }
 
 
+#ifdef STEPPER_ISR_PROFILE
+  void st_profile_get(uint8_t bucket, st_profile_t *profile)
+  {
+    uint8_t sreg = SREG;
+    cli();
+    memcpy(profile, &st_profile[bucket], sizeof(st_profile_t));
+    SREG = sreg;
+  }
+
+
+  uint16_t st_profile_get_overruns()
+  {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t overruns = st_profile_overruns;
+    SREG = sreg;
+    return(overruns);
+  }
+
+
+  void st_profile_reset()
+  {
+    uint8_t sreg = SREG;
+    cli();
+    memset(st_profile, 0, sizeof(st_profile));
+    st_profile_overruns = 0;
+    SREG = sreg;
+  }
+#endif
+
+
+#ifdef STEPPER_TRACE
+  uint8_t st_trace_get(uint8_t index, st_trace_t *record)
+  {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t valid = (index < st_trace_count);
+    if (valid) {
+      memcpy(record, &st_trace[(st_trace_head-st_trace_count+index) & (ST_TRACE_SIZE-1)], sizeof(st_trace_t));
+    }
+    SREG = sreg;
+    return(valid);
+  }
+
+
+  void st_trace_stop() { st_trace_running = false; }
+
+
+  void st_trace_reset()
+  {
+    uint8_t sreg = SREG;
+    cli();
+    st_trace_head = 0;
+    st_trace_count = 0;
+    st_trace_remaining = 0;
+    #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+      st_trace_level = 0;
+    #endif
+    st_trace_running = true;
+    SREG = sreg;
+  }
+#endif
+
+
+#ifdef SEGMENT_BUFFER_STATS
+  void st_get_buffer_stats(st_buffer_stats_t *stats)
+  {
+    uint8_t sreg = SREG;
+    cli();
+    memcpy(stats, &st_stats, sizeof(st_buffer_stats_t));
+    SREG = sreg;
+  }
+
+
+  void st_reset_buffer_stats()
+  {
+    uint8_t sreg = SREG;
+    cli();
+    memset(&st_stats, 0, sizeof(st_buffer_stats_t));
+    st_stats.low_water = SEGMENT_BUFFER_SIZE-1; // Full buffer
+    st_stats_starving = false;
+    SREG = sreg;
+  }
+#endif
+
+
 // Called by planner_recalculate() when the executing block is updated by the new plan.
 void st_update_plan_block_parameters()
 {
   if (pl_block != NULL) { // Ignore if at start of a new block.
     prep.recalculate_flag |= PREP_FLAG_RECALCULATE;
+    #ifdef STEPPER_FIXED_POINT
+      st_fp_update_plan_block();
+    #endif
+    #ifdef S_CURVE_ACCELERATION
+      if (settings.jerk > 0.0) { // Planned entries rank braking limits. Rank a stop from here. See planner.c.
+        pl_block->entry_speed_sqr = 2.0*plan_block_acceleration(pl_block)*
+          st_s_curve_brake_mm(prep.current_speed, prep.current_accel, 0.0)+plan_s_curve_stop_speed_sqr(pl_block);
+      } else
+    #endif
     pl_block->entry_speed_sqr = prep.current_speed*prep.current_speed; // Update entry speed.
     pl_block = NULL; // Flag st_prep_segment() to load and check active velocity profile.
   }
@@ -927,10 +1603,16 @@ static uint8_t st_next_block_index(uint8_t block_index)
   {
     // Store step execution data of partially completed block, if necessary.
     if (prep.recalculate_flag & PREP_FLAG_HOLD_PARTIAL_BLOCK) {
+      #ifdef STEPPER_FIXED_POINT
+        if (pl_block != NULL) { st_fp_update_plan_block(); }
+      #endif
       prep.last_st_block_index = prep.st_block_index;
       prep.last_steps_remaining = prep.steps_remaining;
       prep.last_dt_remainder = prep.dt_remainder;
       prep.last_step_per_mm = prep.step_per_mm;
+      #ifdef STEPPER_FIXED_POINT
+        prep.last_fp_shift = prep.fp_shift;
+      #endif
     }
     // Set flags to execute a parking motion
     prep.recalculate_flag |= PREP_FLAG_PARKING;
@@ -950,7 +1632,12 @@ static uint8_t st_next_block_index(uint8_t block_index)
       prep.dt_remainder = prep.last_dt_remainder;
       prep.step_per_mm = prep.last_step_per_mm;
       prep.recalculate_flag = (PREP_FLAG_HOLD_PARTIAL_BLOCK | PREP_FLAG_RECALCULATE);
-      prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR/prep.step_per_mm; // Recompute this value.
+      #ifdef STEPPER_FIXED_POINT
+        prep.fp_shift = prep.last_fp_shift;
+        prep.fp_speed_scale = prep.step_per_mm*DT_SEGMENT*((uint32_t)1 << prep.fp_shift); // Recompute this value.
+      #else
+        prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR/prep.step_per_mm; // Recompute this value.
+      #endif
     } else {
       prep.recalculate_flag = false;
     }
@@ -959,6 +1646,155 @@ static uint8_t st_next_block_index(uint8_t block_index)
 #endif
 
 
+// Sets the step timing of a segment from the CPU cycles per step. With AMASS, the number of step
+// events is scaled to the smoothing level.
+static void st_set_segment_cycles(segment_t *segment, uint32_t cycles)
+{
+  #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+    // Compute step timing and multi-axis smoothing level.
+    // NOTE: AMASS overdrives the timer with each level, so only one prescalar is required.
+    if (cycles < AMASS_LEVEL1) { segment->amass_level = 0; }
+    else {
+      if (cycles < AMASS_LEVEL2) { segment->amass_level = 1; }
+      else if (cycles < AMASS_LEVEL3) { segment->amass_level = 2; }
+      else { segment->amass_level = 3; }
+      cycles >>= segment->amass_level;
+      segment->n_step <<= segment->amass_level;
+    }
+    if (cycles < (1UL << 16)) { segment->cycles_per_tick = cycles; } // < 65536 (4.1ms @ 16MHz)
+    else { segment->cycles_per_tick = 0xffff; } // Just set the slowest speed possible.
+  #else
+    // Compute step timing and timer prescalar for normal step generation.
+    if (cycles < (1UL << 16)) { // < 65536  (4.1ms @ 16MHz)
+      segment->prescaler = 1; // prescaler: 0
+      segment->cycles_per_tick = cycles;
+    } else if (cycles < (1UL << 19)) { // < 524288 (32.8ms@16MHz)
+      segment->prescaler = 2; // prescaler: 8
+      segment->cycles_per_tick = cycles >> 3;
+    } else {
+      segment->prescaler = 3; // prescaler: 64
+      if (cycles < (1UL << 22)) { // < 4194304 (262ms@16MHz)
+        segment->cycles_per_tick =  cycles >> 6;
+      } else { // Just set the slowest speed possible. (Around 4 step/sec.)
+        segment->cycles_per_tick = 0xffff;
+      }
+    }
+  #endif
+}
+
+
+#ifdef ARC_PLANNER_BLOCKS
+  // Prepares the stepper block of the next arc segment, a line from the end point of the last arc
+  // segment to the point on the arc mm_remaining before its end. Returns the number of step events.
+  // The stepper block is only claimed for the segment, if it has any. Otherwise, nothing changes.
+  // NOTE: Every arc segment has its own stepper block, so that the Bresenham data follows the arc.
+  // There are as many stepper blocks as segments the buffer can hold, so none is still in use.
+  static uint16_t st_prep_arc_segment(segment_t *prep_segment, float mm_remaining)
+  {
+    plan_arc_t *arc = prep.arc;
+    int32_t position[N_AXIS];
+    uint8_t idx;
+    if (mm_remaining <= 0.0) {
+      memcpy(position, arc->end_steps, sizeof(position)); // Ensure the arc ends at the target.
+    } else {
+      float fraction = 1.0 - mm_remaining/arc->millimeters;
+      float cos_Ti = cos(fraction*arc->angular_travel);
+      float sin_Ti = sin(fraction*arc->angular_travel);
+      float position_axis0 = arc->center_axis0 + arc->r_axis0*cos_Ti - arc->r_axis1*sin_Ti;
+      float position_axis1 = arc->center_axis1 + arc->r_axis0*sin_Ti + arc->r_axis1*cos_Ti;
+      for (idx=0; idx<N_AXIS; idx++) {
+        if (bit_istrue(arc->axis_0_mask,bit(idx))) { position[idx] = lround(position_axis0*settings.steps_per_mm[idx]); }
+        else if (bit_istrue(arc->axis_1_mask,bit(idx))) { position[idx] = lround(position_axis1*settings.steps_per_mm[idx]); }
+        else { position[idx] = arc->start_steps[idx] + lround(fraction*(arc->end_steps[idx]-arc->start_steps[idx])); }
+      }
+    }
+
+    uint8_t block_index = prep.st_block_index;
+    if (!prep.arc_block_unused) { block_index = st_next_block_index(block_index); }
+    st_block_t *block = &st_block_buffer[block_index];
+    uint32_t step_event_count = 0;
+    #ifdef DEFAULTS_RAMPS_BOARD
+      memset(block->direction_bits, 0, sizeof(block->direction_bits));
+    #else
+      block->direction_bits = 0;
+    #endif
+    for (idx=0; idx<N_AXIS; idx++) {
+      int32_t steps = position[idx] - prep.arc_position[idx];
+      #ifdef DEFAULTS_RAMPS_BOARD
+        if (steps < 0) { block->direction_bits[get_direction_port_group(idx)] |= get_direction_pin_mask(idx); }
+      #else
+        if (steps < 0) { block->direction_bits |= get_direction_pin_mask(idx); }
+      #endif
+      block->steps[idx] = labs(steps);
+      step_event_count = max(step_event_count, block->steps[idx]);
+    }
+    if (step_event_count == 0) { return(0); }
+
+    // Scale the Bresenham data like st_prep_buffer() does for planner blocks.
+    #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+      for (idx=0; idx<N_AXIS; idx++) { block->steps[idx] <<= 1; }
+      block->step_event_count = step_event_count << 1;
+    #else
+      for (idx=0; idx<N_AXIS; idx++) { block->steps[idx] <<= MAX_AMASS_LEVEL; }
+      block->step_event_count = step_event_count << MAX_AMASS_LEVEL;
+    #endif
+    block->is_pwm_rate_adjusted = st_prep_block->is_pwm_rate_adjusted;
+    #ifdef QUEUE_ACCESSORY_CHANGES
+      block->accessory = st_prep_block->accessory;
+    #endif
+
+    // Claim the stepper block for the segment.
+    prep.st_block_index = block_index;
+    st_prep_block = block;
+    prep_segment->st_block_index = block_index;
+    prep.arc_block_unused = false;
+    memcpy(prep.arc_position, position, sizeof(position));
+    return(step_event_count);
+  }
+
+
+  // Adds the step time of a final arc segment without steps to the last queued segment of the arc,
+  // so the arc still takes its planned time. Skipped, if the stepper ISR has already loaded it.
+  static void st_prep_arc_carry_cycles()
+  {
+    if (prep.arc_block_unused) { return; } // No segment of the arc has any steps.
+    uint8_t index = segment_buffer_head;
+    if (index == 0) { index = SEGMENT_BUFFER_SIZE; }
+    segment_t *segment = &segment_buffer[--index];
+    uint16_t n_step = segment->n_step;
+    #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+      n_step >>= segment->amass_level;
+    #endif
+    uint32_t cycles = ceil((prep.arc_segment_cycles+prep.arc_cycles)/n_step);
+    prep.arc_cycles = 0.0;
+    uint8_t sreg = SREG;
+    cli();
+    if ((segment_buffer_tail != segment_buffer_head) && (segment_buffer_tail != index) &&
+        (segment->st_block_index == prep.st_block_index)) {
+      segment->n_step = n_step;
+      st_set_segment_cycles(segment, cycles);
+    }
+    SREG = sreg;
+  }
+#endif
+
+
+#ifdef ADAPTIVE_SEGMENT_TIME
+  // Returns the planned time of the queued segments in acceleration ticks, counting the segment
+  // the stepper is executing.
+  static uint16_t st_segment_buffer_ticks()
+  {
+    uint16_t ticks = 0;
+    uint8_t idx = segment_buffer_tail;
+    while (idx != segment_buffer_head) {
+      ticks += segment_buffer[idx].ticks;
+      if (++idx == SEGMENT_BUFFER_SIZE) { idx = 0; }
+    }
+    return(ticks);
+  }
+#endif
+
+
 /* Prepares step segment buffer. Continuously called from main program.
 
    The segment buffer is an intermediary buffer interface between the execution of steps
@@ -986,6 +1822,9 @@ void st_prep_buffer()
       if (sys.step_control & STEP_CONTROL_EXECUTE_SYS_MOTION) { pl_block = plan_get_system_motion_block(); }
       else { pl_block = plan_get_current_block(); }
       if (pl_block == NULL) { return; } // No planner blocks. Exit.
+      #ifdef ARC_PLANNER_BLOCKS
+        prep.arc = plan_get_block_arc(pl_block);
+      #endif
 
       // Check if we need to only recompute the velocity profile or load a new block.
       if (prep.recalculate_flag & PREP_FLAG_RECALCULATE) {
@@ -1007,31 +1846,66 @@ void st_prep_buffer()
         // segment buffer finishes the prepped block, but the stepper ISR is still executing it.
         st_prep_block = &st_block_buffer[prep.st_block_index];
         uint8_t idx;
-        #ifdef DEFAULTS_RAMPS_BOARD
+        #if defined(DEFAULTS_RAMPS_BOARD) && defined(PACKED_PLANNER_BLOCKS)
+          memset(st_prep_block->direction_bits, 0, sizeof(st_prep_block->direction_bits));
+          for (idx=0; idx<N_AXIS; idx++) {
+            if (pl_block->direction_bits & bit(idx)) {
+              st_prep_block->direction_bits[get_direction_port_group(idx)] |= get_direction_pin_mask(idx);
+            }
+          }
+        #elif defined(DEFAULTS_RAMPS_BOARD)
+          // Merge the per-axis direction pins of the planner block into their port groups.
+          memset(st_prep_block->direction_bits, 0, sizeof(st_prep_block->direction_bits));
           for (idx=0; idx<N_AXIS; idx++) {
-            st_prep_block->direction_bits[idx] = pl_block->direction_bits[idx];
+            st_prep_block->direction_bits[get_direction_port_group(idx)] |= pl_block->direction_bits[idx];
           }
         #else
           st_prep_block->direction_bits = pl_block->direction_bits;
         #endif // Ramps Board
 
         #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
-          for (idx=0; idx<N_AXIS; idx++) { st_prep_block->steps[idx] = (pl_block->steps[idx] << 1); }
-          st_prep_block->step_event_count = (pl_block->step_event_count << 1);
+          for (idx=0; idx<N_AXIS; idx++) { st_prep_block->steps[idx] = ((uint32_t)pl_block->steps[idx] << 1); }
+          st_prep_block->step_event_count = ((uint32_t)pl_block->step_event_count << 1);
         #else
           // With AMASS enabled, simply bit-shift multiply all Bresenham data by the max AMASS
           // level, such that we never divide beyond the original data anywhere in the algorithm.
           // If the original data is divided, we can lose a step from integer roundoff.
-          for (idx=0; idx<N_AXIS; idx++) { st_prep_block->steps[idx] = pl_block->steps[idx] << MAX_AMASS_LEVEL; }
-          st_prep_block->step_event_count = pl_block->step_event_count << MAX_AMASS_LEVEL;
+          for (idx=0; idx<N_AXIS; idx++) { st_prep_block->steps[idx] = (uint32_t)pl_block->steps[idx] << MAX_AMASS_LEVEL; }
+          st_prep_block->step_event_count = (uint32_t)pl_block->step_event_count << MAX_AMASS_LEVEL;
         #endif
 
         // Initialize segment buffer data for generating the segments.
-        prep.steps_remaining = (float)pl_block->step_event_count;
-        prep.step_per_mm = prep.steps_remaining/pl_block->millimeters;
-        prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR/prep.step_per_mm;
-        prep.dt_remainder = 0.0; // Reset for new segment block
+        #ifdef STEPPER_FIXED_POINT
+          // Fewer fraction bits for blocks of more than 16 bits of steps, like long homing motions.
+          prep.fp_shift = FP_SHIFT;
+          while (prep.fp_shift && (pl_block->step_event_count >> (32-prep.fp_shift))) { prep.fp_shift--; }
+          prep.steps_remaining = pl_block->step_event_count << prep.fp_shift;
+          prep.step_per_mm = pl_block->step_event_count/pl_block->millimeters;
+          prep.fp_speed_scale = prep.step_per_mm*DT_SEGMENT*((uint32_t)1 << prep.fp_shift);
+          prep.dt_remainder = 0; // Reset for new segment block
+        #else
+          prep.steps_remaining = (float)pl_block->step_event_count;
+          prep.step_per_mm = prep.steps_remaining/pl_block->millimeters;
+          prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR/prep.step_per_mm;
+          prep.dt_remainder = 0.0; // Reset for new segment block
+        #endif
 
+        #ifdef ARC_PLANNER_BLOCKS
+          if (prep.arc != NULL) {
+            // Arc segments start from the planner position at the start of the arc. The stepper
+            // block loaded above is given to the first arc segment.
+            memcpy(prep.arc_position, prep.arc->start_steps, sizeof(prep.arc_position));
+            prep.arc_cycles = 0.0;
+            prep.arc_block_unused = true;
+          }
+        #endif
+
+        #ifdef S_CURVE_ACCELERATION
+          if (settings.jerk > 0.0) {
+            // Jerk-limited ramps carry their speed and acceleration over, also mid-hold.
+            prep.recalculate_flag &= ~(PREP_FLAG_DECEL_OVERRIDE);
+          } else
+        #endif
         if ((sys.step_control & STEP_CONTROL_EXECUTE_HOLD) || (prep.recalculate_flag & PREP_FLAG_DECEL_OVERRIDE)) {
           // New block loaded mid-hold. Override planner block entry speed to enforce deceleration.
           prep.current_speed = prep.exit_speed;
@@ -1040,6 +1914,9 @@ void st_prep_buffer()
         } else {
           prep.current_speed = sqrt(pl_block->entry_speed_sqr);
         }
+        #ifdef STEPPER_FIXED_POINT
+          prep.fp_current_speed = prep.current_speed*prep.fp_speed_scale;
+        #endif
 
         // Setup laser mode variables. PWM rate adjusted motions will always complete a motion with the
         // spindle off.
@@ -1047,10 +1924,17 @@ void st_prep_buffer()
         if (settings.flags & BITFLAG_LASER_MODE) {
           if (pl_block->condition & PL_COND_FLAG_SPINDLE_CCW) {
             // Pre-compute inverse programmed rate to speed up PWM updating per step segment.
-            prep.inv_rate = 1.0/pl_block->programmed_rate;
+            #ifdef STEPPER_FIXED_POINT
+              prep.inv_rate = 1.0/(plan_block_programmed_rate(pl_block)*prep.fp_speed_scale); // Per fixed-point speed
+            #else
+              prep.inv_rate = 1.0/plan_block_programmed_rate(pl_block);
+            #endif
             st_prep_block->is_pwm_rate_adjusted = true;
           }
         }
+        #ifdef QUEUE_ACCESSORY_CHANGES
+          st_prep_block->accessory = pl_block->condition & (PL_COND_ACCESSORY_MASK|PL_COND_FLAG_SYSTEM_MOTION);
+        #endif
       }
 
       /* ---------------------------------------------------------------------------------
@@ -1060,7 +1944,12 @@ void st_prep_buffer()
        hold, override the planner velocities and decelerate to the target exit speed.
       */
       prep.mm_complete = 0.0; // Default velocity profile complete at 0.0mm from end of block.
-      float inv_2_accel = 0.5/pl_block->acceleration;
+      float inv_2_accel = 0.5/plan_block_acceleration(pl_block);
+      #ifdef S_CURVE_ACCELERATION
+        if (settings.jerk > 0.0) {
+          st_s_curve_compute_profile();
+        } else
+      #endif
       if (sys.step_control & STEP_CONTROL_EXECUTE_HOLD) { // [Forced Deceleration to Zero Velocity]
         // Compute velocity profile parameters for a feed hold in-progress. This profile overrides
         // the planner block profile, enforcing a deceleration to zero speed.
@@ -1069,7 +1958,7 @@ void st_prep_buffer()
         float decel_dist = pl_block->millimeters - inv_2_accel*pl_block->entry_speed_sqr;
         if (decel_dist < 0.0) {
           // Deceleration through entire planner block. End of feed hold is not in this block.
-          prep.exit_speed = sqrt(pl_block->entry_speed_sqr-2*pl_block->acceleration*pl_block->millimeters);
+          prep.exit_speed = sqrt(pl_block->entry_speed_sqr-2*plan_block_acceleration(pl_block)*pl_block->millimeters);
         } else {
           prep.mm_complete = decel_dist; // End of feed hold.
           prep.exit_speed = 0.0;
@@ -1101,7 +1990,7 @@ void st_prep_buffer()
             // prep.maximum_speed = prep.current_speed;
 
             // Compute override block exit speed since it doesn't match the planner exit speed.
-            prep.exit_speed = sqrt(pl_block->entry_speed_sqr - 2*pl_block->acceleration*pl_block->millimeters);
+            prep.exit_speed = sqrt(pl_block->entry_speed_sqr - 2*plan_block_acceleration(pl_block)*pl_block->millimeters);
             prep.recalculate_flag |= PREP_FLAG_DECEL_OVERRIDE; // Flag to load next block as deceleration override.
 
             // TODO: Determine correct handling of parameters in deceleration-only.
@@ -1130,7 +2019,7 @@ void st_prep_buffer()
             } else { // Triangle type
               prep.accelerate_until = intersect_distance;
               prep.decelerate_after = intersect_distance;
-              prep.maximum_speed = sqrt(2.0*pl_block->acceleration*intersect_distance+exit_speed_sqr);
+              prep.maximum_speed = sqrt(2.0*plan_block_acceleration(pl_block)*intersect_distance+exit_speed_sqr);
             }
           } else { // Deceleration-only type
             prep.ramp_type = RAMP_DECEL;
@@ -1144,12 +2033,42 @@ void st_prep_buffer()
         }
       }
 
+      #ifdef STEPPER_FIXED_POINT
+        // Convert the velocity profile for the fixed-point segment generator.
+        prep.fp_maximum_speed = prep.maximum_speed*prep.fp_speed_scale;
+        prep.fp_exit_speed = prep.exit_speed*prep.fp_speed_scale;
+        prep.fp_acceleration = plan_block_acceleration(pl_block)*prep.fp_speed_scale*DT_SEGMENT;
+        prep.fp_accelerate_until = st_fp_distance(prep.accelerate_until);
+        prep.fp_decelerate_after = st_fp_distance(prep.decelerate_after);
+        prep.fp_complete = st_fp_distance(prep.mm_complete);
+      #endif
+
       bit_true(sys.step_control, STEP_CONTROL_UPDATE_SPINDLE_PWM); // Force update whenever updating block.
     }
 
     // Initialize new segment
     segment_t *prep_segment = &segment_buffer[segment_buffer_head];
 
+    #ifdef ADAPTIVE_SEGMENT_TIME
+      // Segments run several ticks where the cruise lasts at least that long. Wait until the segment
+      // buffer has room for the segment time, so it never holds more than SEGMENT_BUFFER_TICKS.
+      uint8_t segment_ticks = 1;
+      if (prep.ramp_type == RAMP_CRUISE) {
+        #ifdef STEPPER_FIXED_POINT
+          if ((prep.steps_remaining-prep.fp_decelerate_after)/CRUISE_SEGMENT_TICKS >= prep.fp_maximum_speed) {
+        #else
+          if (pl_block->millimeters-prep.decelerate_after >= (CRUISE_SEGMENT_TICKS*DT_SEGMENT)*prep.maximum_speed) {
+        #endif
+          segment_ticks = CRUISE_SEGMENT_TICKS;
+        }
+      }
+      #ifdef ARC_PLANNER_BLOCKS
+        if (prep.arc != NULL) { segment_ticks = 1; }
+      #endif
+      if (st_segment_buffer_ticks()+segment_ticks > SEGMENT_BUFFER_TICKS) { return; }
+      prep_segment->ticks = segment_ticks;
+    #endif
+
     // Set new segment to point to the current segment data block.
     prep_segment->st_block_index = prep.st_block_index;
 
@@ -1167,89 +2086,186 @@ void st_prep_buffer()
       the end of planner block (typical) or mid-block at the end of a forced deceleration,
       such as from a feed hold.
     */
-    float dt_max = DT_SEGMENT; // Maximum segment time
-    float dt = 0.0; // Initialize segment time
-    float time_var = dt_max; // Time worker variable
-    float mm_var; // mm-Distance worker variable
-    float speed_var; // Speed worker variable
-    float mm_remaining = pl_block->millimeters; // New segment distance from end of block.
-    float minimum_mm = mm_remaining-prep.req_mm_increment; // Guarantee at least one step.
-    if (minimum_mm < 0.0) { minimum_mm = 0.0; }
-
-    do {
-      switch (prep.ramp_type) {
-        case RAMP_DECEL_OVERRIDE:
-          speed_var = pl_block->acceleration*time_var;
-          if (prep.current_speed-prep.maximum_speed <= speed_var) {
-            // Cruise or cruise-deceleration types only for deceleration override.
-            mm_remaining = prep.accelerate_until;
-            time_var = 2.0*(pl_block->millimeters-mm_remaining)/(prep.current_speed+prep.maximum_speed);
-            prep.ramp_type = RAMP_CRUISE;
-            prep.current_speed = prep.maximum_speed;
-          } else { // Mid-deceleration override ramp.
-            mm_remaining -= time_var*(prep.current_speed - 0.5*speed_var);
-            prep.current_speed -= speed_var;
-          }
-          break;
-        case RAMP_ACCEL:
-          // NOTE: Acceleration ramp only computes during first do-while loop.
-          speed_var = pl_block->acceleration*time_var;
-          mm_remaining -= time_var*(prep.current_speed + 0.5*speed_var);
-          if (mm_remaining < prep.accelerate_until) { // End of acceleration ramp.
-            // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
-            mm_remaining = prep.accelerate_until; // NOTE: 0.0 at EOB
-            time_var = 2.0*(pl_block->millimeters-mm_remaining)/(prep.current_speed+prep.maximum_speed);
-            if (mm_remaining == prep.decelerate_after) { prep.ramp_type = RAMP_DECEL; }
-            else { prep.ramp_type = RAMP_CRUISE; }
-            prep.current_speed = prep.maximum_speed;
-          } else { // Acceleration only.
-            prep.current_speed += speed_var;
-          }
-          break;
-        case RAMP_CRUISE:
-          // NOTE: mm_var used to retain the last mm_remaining for incomplete segment time_var calculations.
-          // NOTE: If maximum_speed*time_var value is too low, round-off can cause mm_var to not change. To
-          //   prevent this, simply enforce a minimum speed threshold in the planner.
-          mm_var = mm_remaining - prep.maximum_speed*time_var;
-          if (mm_var < prep.decelerate_after) { // End of cruise.
-            // Cruise-deceleration junction or end of block.
-            time_var = (mm_remaining - prep.decelerate_after)/prep.maximum_speed;
-            mm_remaining = prep.decelerate_after; // NOTE: 0.0 at EOB
-            prep.ramp_type = RAMP_DECEL;
-          } else { // Cruising only.
-            mm_remaining = mm_var;
+    #ifdef STEPPER_FIXED_POINT
+      #ifdef ADAPTIVE_SEGMENT_TIME
+        uint32_t dt_max = segment_ticks*FP_ONE; // Maximum segment time
+      #else
+        uint32_t dt_max = FP_ONE; // Maximum segment time
+      #endif
+      uint32_t dt = 0; // Initialize segment time
+      uint32_t time_var = dt_max; // Time worker variable
+      uint32_t dist_var; // Distance worker variable
+      uint32_t speed_var; // Speed worker variable
+      uint32_t dist_remaining = prep.steps_remaining; // New segment distance from end of block.
+      uint32_t minimum_dist = 0; // Guarantee at least one step.
+      uint32_t req_increment = FP_REQ_INCREMENT >> (FP_SHIFT-prep.fp_shift);
+      if (dist_remaining > req_increment) { minimum_dist = dist_remaining-req_increment; }
+
+      do {
+        switch (prep.ramp_type) {
+          case RAMP_DECEL_OVERRIDE:
+            speed_var = st_fp_mul(prep.fp_acceleration, time_var);
+            if (prep.fp_current_speed <= prep.fp_maximum_speed+speed_var) {
+              // Cruise or cruise-deceleration types only for deceleration override.
+              dist_remaining = prep.fp_accelerate_until;
+              time_var = st_fp_ramp_time(prep.steps_remaining, dist_remaining, prep.fp_current_speed+prep.fp_maximum_speed);
+              prep.ramp_type = RAMP_CRUISE;
+              prep.fp_current_speed = prep.fp_maximum_speed;
+            } else { // Mid-deceleration override ramp.
+              dist_var = st_fp_mul(prep.fp_current_speed-(speed_var >> 1), time_var);
+              if (dist_remaining > prep.fp_accelerate_until+dist_var) { dist_remaining -= dist_var; }
+              else { dist_remaining = prep.fp_accelerate_until; }
+              prep.fp_current_speed -= speed_var;
+            }
+            break;
+          case RAMP_ACCEL:
+            // NOTE: Acceleration ramp only computes during first do-while loop.
+            speed_var = st_fp_mul(prep.fp_acceleration, time_var);
+            dist_var = st_fp_mul(prep.fp_current_speed+(speed_var >> 1), time_var);
+            if (dist_remaining < prep.fp_accelerate_until+dist_var) { // End of acceleration ramp.
+              // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
+              dist_remaining = prep.fp_accelerate_until; // NOTE: 0 at EOB
+              time_var = st_fp_ramp_time(prep.steps_remaining, dist_remaining, prep.fp_current_speed+prep.fp_maximum_speed);
+              if (dist_remaining == prep.fp_decelerate_after) { prep.ramp_type = RAMP_DECEL; }
+              else { prep.ramp_type = RAMP_CRUISE; }
+              prep.fp_current_speed = prep.fp_maximum_speed;
+            } else { // Acceleration only.
+              dist_remaining -= dist_var;
+              prep.fp_current_speed += speed_var;
+            }
+            break;
+          case RAMP_CRUISE:
+            dist_var = st_fp_mul(prep.fp_maximum_speed, time_var);
+            if (dist_remaining < prep.fp_decelerate_after+dist_var) { // End of cruise.
+              // Cruise-deceleration junction or end of block.
+              time_var = st_fp_ramp_time(dist_remaining, prep.fp_decelerate_after, 2*prep.fp_maximum_speed);
+              dist_remaining = prep.fp_decelerate_after; // NOTE: 0 at EOB
+              prep.ramp_type = RAMP_DECEL;
+            } else { // Cruising only.
+              dist_remaining -= dist_var;
+            }
+            break;
+          default: // case RAMP_DECEL:
+            speed_var = st_fp_mul(prep.fp_acceleration, time_var); // Used as delta speed
+            if (prep.fp_current_speed > speed_var) { // Check if at or below zero speed.
+              dist_var = st_fp_mul(prep.fp_current_speed-(speed_var >> 1), time_var);
+              if (dist_remaining > prep.fp_complete+dist_var) { // Typical case. In deceleration ramp.
+                dist_remaining -= dist_var;
+                prep.fp_current_speed -= speed_var;
+                break; // Segment complete. Exit switch-case statement. Continue do-while loop.
+              }
+            }
+            // Otherwise, at end of block or end of forced-deceleration.
+            time_var = st_fp_ramp_time(dist_remaining, prep.fp_complete, prep.fp_current_speed+prep.fp_exit_speed);
+            dist_remaining = prep.fp_complete;
+            prep.fp_current_speed = prep.fp_exit_speed;
+        }
+        dt += time_var; // Add computed ramp time to total segment time.
+        if (dt < dt_max) { time_var = dt_max - dt; } // **Incomplete** At ramp junction.
+        else {
+          if (dist_remaining > minimum_dist) { // Check for very slow segments with zero steps.
+            // Increase segment time to ensure at least one step in segment.
+            dt_max += FP_ONE;
+            time_var = dt_max - dt;
+          } else {
+            break; // **Complete** Exit loop. Segment execution time maxed.
           }
-          break;
-        default: // case RAMP_DECEL:
-          // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
-          speed_var = pl_block->acceleration*time_var; // Used as delta speed (mm/min)
-          if (prep.current_speed > speed_var) { // Check if at or below zero speed.
-            // Compute distance from end of segment to end of block.
-            mm_var = mm_remaining - time_var*(prep.current_speed - 0.5*speed_var); // (mm)
-            if (mm_var > prep.mm_complete) { // Typical case. In deceleration ramp.
-              mm_remaining = mm_var;
+        }
+      } while (dist_remaining > prep.fp_complete); // **Complete** Exit loop. Profile complete.
+    #else
+      #ifdef ADAPTIVE_SEGMENT_TIME
+        float dt_max = segment_ticks*DT_SEGMENT; // Maximum segment time
+      #else
+        float dt_max = DT_SEGMENT; // Maximum segment time
+      #endif
+      float dt = 0.0; // Initialize segment time
+      float time_var = dt_max; // Time worker variable
+      float mm_var; // mm-Distance worker variable
+      float speed_var; // Speed worker variable
+      float mm_remaining = pl_block->millimeters; // New segment distance from end of block.
+      float minimum_mm = mm_remaining-prep.req_mm_increment; // Guarantee at least one step.
+      if (minimum_mm < 0.0) { minimum_mm = 0.0; }
+
+      do {
+        switch (prep.ramp_type) {
+          case RAMP_DECEL_OVERRIDE:
+            speed_var = plan_block_acceleration(pl_block)*time_var;
+            if (prep.current_speed-prep.maximum_speed <= speed_var) {
+              // Cruise or cruise-deceleration types only for deceleration override.
+              mm_remaining = prep.accelerate_until;
+              time_var = 2.0*(pl_block->millimeters-mm_remaining)/(prep.current_speed+prep.maximum_speed);
+              prep.ramp_type = RAMP_CRUISE;
+              prep.current_speed = prep.maximum_speed;
+            } else { // Mid-deceleration override ramp.
+              mm_remaining -= time_var*(prep.current_speed - 0.5*speed_var);
               prep.current_speed -= speed_var;
-              break; // Segment complete. Exit switch-case statement. Continue do-while loop.
             }
+            break;
+          case RAMP_ACCEL:
+            // NOTE: Acceleration ramp only computes during first do-while loop.
+            speed_var = plan_block_acceleration(pl_block)*time_var;
+            mm_remaining -= time_var*(prep.current_speed + 0.5*speed_var);
+            if (mm_remaining < prep.accelerate_until) { // End of acceleration ramp.
+              // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
+              mm_remaining = prep.accelerate_until; // NOTE: 0.0 at EOB
+              time_var = 2.0*(pl_block->millimeters-mm_remaining)/(prep.current_speed+prep.maximum_speed);
+              if (mm_remaining == prep.decelerate_after) { prep.ramp_type = RAMP_DECEL; }
+              else { prep.ramp_type = RAMP_CRUISE; }
+              prep.current_speed = prep.maximum_speed;
+            } else { // Acceleration only.
+              prep.current_speed += speed_var;
+            }
+            break;
+          case RAMP_CRUISE:
+            // NOTE: mm_var used to retain the last mm_remaining for incomplete segment time_var calculations.
+            // NOTE: If maximum_speed*time_var value is too low, round-off can cause mm_var to not change. To
+            //   prevent this, simply enforce a minimum speed threshold in the planner.
+            mm_var = mm_remaining - prep.maximum_speed*time_var;
+            if (mm_var < prep.decelerate_after) { // End of cruise.
+              // Cruise-deceleration junction or end of block.
+              time_var = (mm_remaining - prep.decelerate_after)/prep.maximum_speed;
+              mm_remaining = prep.decelerate_after; // NOTE: 0.0 at EOB
+              prep.ramp_type = RAMP_DECEL;
+            } else { // Cruising only.
+              mm_remaining = mm_var;
+            }
+            break;
+          #ifdef S_CURVE_ACCELERATION
+            case RAMP_S_CURVE:
+              st_s_curve_advance(&time_var, &mm_remaining);
+              break;
+          #endif
+          default: // case RAMP_DECEL:
+            // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
+            speed_var = plan_block_acceleration(pl_block)*time_var; // Used as delta speed (mm/min)
+            if (prep.current_speed > speed_var) { // Check if at or below zero speed.
+              // Compute distance from end of segment to end of block.
+              mm_var = mm_remaining - time_var*(prep.current_speed - 0.5*speed_var); // (mm)
+              if (mm_var > prep.mm_complete) { // Typical case. In deceleration ramp.
+                mm_remaining = mm_var;
+                prep.current_speed -= speed_var;
+                break; // Segment complete. Exit switch-case statement. Continue do-while loop.
+              }
+            }
+            // Otherwise, at end of block or end of forced-deceleration.
+            time_var = 2.0*(mm_remaining-prep.mm_complete)/(prep.current_speed+prep.exit_speed);
+            mm_remaining = prep.mm_complete;
+            prep.current_speed = prep.exit_speed;
+        }
+        dt += time_var; // Add computed ramp time to total segment time.
+        if (dt < dt_max) { time_var = dt_max - dt; } // **Incomplete** At ramp junction.
+        else {
+          if (mm_remaining > minimum_mm) { // Check for very slow segments with zero steps.
+            // Increase segment time to ensure at least one step in segment. Override and loop
+            // through distance calculations until minimum_mm or mm_complete.
+            dt_max += DT_SEGMENT;
+            time_var = dt_max - dt;
+          } else {
+            break; // **Complete** Exit loop. Segment execution time maxed.
           }
-          // Otherwise, at end of block or end of forced-deceleration.
-          time_var = 2.0*(mm_remaining-prep.mm_complete)/(prep.current_speed+prep.exit_speed);
-          mm_remaining = prep.mm_complete;
-          prep.current_speed = prep.exit_speed;
-      }
-      dt += time_var; // Add computed ramp time to total segment time.
-      if (dt < dt_max) { time_var = dt_max - dt; } // **Incomplete** At ramp junction.
-      else {
-        if (mm_remaining > minimum_mm) { // Check for very slow segments with zero steps.
-          // Increase segment time to ensure at least one step in segment. Override and loop
-          // through distance calculations until minimum_mm or mm_complete.
-          dt_max += DT_SEGMENT;
-          time_var = dt_max - dt;
-        } else {
-          break; // **Complete** Exit loop. Segment execution time maxed.
         }
-      }
-    } while (mm_remaining > prep.mm_complete); // **Complete** Exit loop. Profile complete.
+      } while (mm_remaining > prep.mm_complete); // **Complete** Exit loop. Profile complete.
+    #endif
 
 
     /* -----------------------------------------------------------------------------------
@@ -1258,9 +2274,13 @@ void st_prep_buffer()
 
     if (st_prep_block->is_pwm_rate_adjusted || (sys.step_control & STEP_CONTROL_UPDATE_SPINDLE_PWM)) {
       if (pl_block->condition & (PL_COND_FLAG_SPINDLE_CW | PL_COND_FLAG_SPINDLE_CCW)) {
-        float rpm = pl_block->spindle_speed;
+        float rpm = plan_block_spindle_speed(pl_block);
         // NOTE: Feed and rapid overrides are independent of PWM value and do not alter laser power/rate.
-        if (st_prep_block->is_pwm_rate_adjusted) { rpm *= (prep.current_speed * prep.inv_rate); }
+        #ifdef STEPPER_FIXED_POINT
+          if (st_prep_block->is_pwm_rate_adjusted) { rpm *= (prep.fp_current_speed * prep.inv_rate); }
+        #else
+          if (st_prep_block->is_pwm_rate_adjusted) { rpm *= (prep.current_speed * prep.inv_rate); }
+        #endif
         // If current_speed is zero, then may need to be rpm_min*(100/MAX_SPINDLE_SPEED_OVERRIDE)
         // but this would be instantaneous only and during a motion. May not matter at all.
         prep.current_spindle_pwm = spindle_compute_pwm_value(rpm);
@@ -1283,9 +2303,16 @@ void st_prep_buffer()
        Fortunately, this scenario is highly unlikely and unrealistic in CNC machines
        supported by Grbl (i.e. exceeding 10 meters axis travel at 200 step/mm).
     */
-    float step_dist_remaining = prep.step_per_mm*mm_remaining; // Convert mm_remaining to steps
-    float n_steps_remaining = ceil(step_dist_remaining); // Round-up current steps remaining
-    float last_n_steps_remaining = ceil(prep.steps_remaining); // Round-up last steps remaining
+    #ifdef STEPPER_FIXED_POINT
+      // NOTE: With fixed-point, the exact step distance is tracked and none of the above applies.
+      uint32_t step_mask = ((uint32_t)1 << prep.fp_shift)-1;
+      uint32_t n_steps_remaining = (dist_remaining >> prep.fp_shift) + ((dist_remaining & step_mask) != 0); // Round-up current steps remaining
+      uint32_t last_n_steps_remaining = (prep.steps_remaining >> prep.fp_shift) + ((prep.steps_remaining & step_mask) != 0); // Round-up last steps remaining
+    #else
+      float step_dist_remaining = prep.step_per_mm*mm_remaining; // Convert mm_remaining to steps
+      float n_steps_remaining = ceil(step_dist_remaining); // Round-up current steps remaining
+      float last_n_steps_remaining = ceil(prep.steps_remaining); // Round-up last steps remaining
+    #endif
     prep_segment->n_step = last_n_steps_remaining-n_steps_remaining; // Compute number of steps to execute.
 
     // Bail if we are at the end of a feed hold and don't have a step to execute.
@@ -1294,6 +2321,9 @@ void st_prep_buffer()
         // Less than one step to decelerate to zero speed, but already very close. AMASS
         // requires full steps to execute. So, just bail.
         bit_true(sys.step_control,STEP_CONTROL_END_MOTION);
+        #ifdef S_CURVE_ACCELERATION
+          prep.current_speed = prep.current_accel = 0.0; // Resume from a standstill.
+        #endif
         #ifdef PARKING_ENABLE
           if (!(prep.recalculate_flag & PREP_FLAG_PARKING)) { prep.recalculate_flag |= PREP_FLAG_HOLD_PARTIAL_BLOCK; }
         #endif
@@ -1309,56 +2339,73 @@ void st_prep_buffer()
     // adjusts the whole segment rate to keep step output exact. These rate adjustments are
     // typically very small and do not adversely effect performance, but ensures that Grbl
     // outputs the exact acceleration and velocity profiles as computed by the planner.
-    dt += prep.dt_remainder; // Apply previous segment partial step execute time
-    float inv_rate = dt/(last_n_steps_remaining - step_dist_remaining); // Compute adjusted step rate inverse
+    #ifdef STEPPER_FIXED_POINT
+      // Segment time in CPU cycles, divided by the distance from the last whole step of the
+      // previous segment to the exact end of this one. Segment step distances are in FP_ONE steps.
+      uint8_t step_shift = FP_SHIFT-prep.fp_shift;
+      uint32_t dt_cycles = st_fp_mul(dt, FP_SEGMENT_CYCLES) + prep.dt_remainder;
+      uint32_t cycles = st_fp_div(dt_cycles, ((last_n_steps_remaining << prep.fp_shift)-dist_remaining) << step_shift); // (cycles/step)
+      if (cycles > FP_MAX_CYCLES) { cycles = FP_MAX_CYCLES; }
+      uint32_t dt_remainder = st_fp_mul(cycles, ((n_steps_remaining << prep.fp_shift)-dist_remaining) << step_shift);
+    #else
+      dt += prep.dt_remainder; // Apply previous segment partial step execute time
+      float inv_rate = dt/(last_n_steps_remaining - step_dist_remaining); // Compute adjusted step rate inverse
 
-    // Compute CPU cycles per step for the prepped segment.
-    uint32_t cycles = ceil( (TICKS_PER_MICROSECOND*1000000*60)*inv_rate ); // (cycles/step)
+      // Compute CPU cycles per step for the prepped segment.
+      uint32_t cycles = ceil( (TICKS_PER_MICROSECOND*1000000*60)*inv_rate ); // (cycles/step)
+    #endif
 
-    #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
-      // Compute step timing and multi-axis smoothing level.
-      // NOTE: AMASS overdrives the timer with each level, so only one prescalar is required.
-      if (cycles < AMASS_LEVEL1) { prep_segment->amass_level = 0; }
-      else {
-        if (cycles < AMASS_LEVEL2) { prep_segment->amass_level = 1; }
-        else if (cycles < AMASS_LEVEL3) { prep_segment->amass_level = 2; }
-        else { prep_segment->amass_level = 3; }
-        cycles >>= prep_segment->amass_level;
-        prep_segment->n_step <<= prep_segment->amass_level;
-      }
-      if (cycles < (1UL << 16)) { prep_segment->cycles_per_tick = cycles; } // < 65536 (4.1ms @ 16MHz)
-      else { prep_segment->cycles_per_tick = 0xffff; } // Just set the slowest speed possible.
-    #else
-      // Compute step timing and timer prescalar for normal step generation.
-      if (cycles < (1UL << 16)) { // < 65536  (4.1ms @ 16MHz)
-        prep_segment->prescaler = 1; // prescaler: 0
-        prep_segment->cycles_per_tick = cycles;
-      } else if (cycles < (1UL << 19)) { // < 524288 (32.8ms@16MHz)
-        prep_segment->prescaler = 2; // prescaler: 8
-        prep_segment->cycles_per_tick = cycles >> 3;
-      } else {
-        prep_segment->prescaler = 3; // prescaler: 64
-        if (cycles < (1UL << 22)) { // < 4194304 (262ms@16MHz)
-          prep_segment->cycles_per_tick =  cycles >> 6;
-        } else { // Just set the slowest speed possible. (Around 4 step/sec.)
-          prep_segment->cycles_per_tick = 0xffff;
+    #ifdef ARC_PLANNER_BLOCKS
+      if (prep.arc != NULL) {
+        // Arc segments step along a chord to the point on the arc at the last whole step above,
+        // in the step time computed for the segment and for any earlier segment without steps.
+        prep.arc_cycles += (float)cycles*prep_segment->n_step;
+        prep_segment->n_step = st_prep_arc_segment(prep_segment, n_steps_remaining/prep.step_per_mm);
+        if (prep_segment->n_step != 0) {
+          cycles = ceil(prep.arc_cycles/prep_segment->n_step);
+          prep.arc_segment_cycles = prep.arc_cycles;
+          prep.arc_cycles = 0.0;
+        } else if (n_steps_remaining == 0) {
+          st_prep_arc_carry_cycles(); // End of the arc. Its time goes to the segment before.
         }
       }
     #endif
 
+    st_set_segment_cycles(prep_segment, cycles);
+
     // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
+    #ifdef ARC_PLANNER_BLOCKS
+      if (prep_segment->n_step != 0) { // Arc segments without steps are dropped. Their time carries over.
+    #endif
     segment_buffer_head = segment_next_head;
     if ( ++segment_next_head == SEGMENT_BUFFER_SIZE ) { segment_next_head = 0; }
+    #ifdef ARC_PLANNER_BLOCKS
+      }
+    #endif
 
     // Update the appropriate planner and segment data.
-    pl_block->millimeters = mm_remaining;
-    prep.steps_remaining = n_steps_remaining;
-    prep.dt_remainder = (n_steps_remaining - step_dist_remaining)*inv_rate;
+    #ifdef STEPPER_FIXED_POINT
+      // NOTE: Planner block millimeters are updated only when needed. See st_fp_update_plan_block().
+      prep.steps_remaining = dist_remaining;
+      prep.dt_remainder = dt_remainder;
+    #else
+      pl_block->millimeters = mm_remaining;
+      prep.steps_remaining = n_steps_remaining;
+      prep.dt_remainder = (n_steps_remaining - step_dist_remaining)*inv_rate;
+    #endif
 
     // Check for exit conditions and flag to load next planner block.
+    #ifdef STEPPER_FIXED_POINT
+    if (dist_remaining == prep.fp_complete) {
+    #else
     if (mm_remaining == prep.mm_complete) {
+    #endif
       // End of planner block or forced-termination. No more distance to be executed.
+      #ifdef STEPPER_FIXED_POINT
+      if (dist_remaining > 0) { // At end of forced-termination.
+      #else
       if (mm_remaining > 0.0) { // At end of forced-termination.
+      #endif
         // Reset prep parameters for resuming and then bail. Allow the stepper ISR to complete
         // the segment queue, where realtime protocol will set new state upon receiving the
         // cycle stop flag from the ISR. Prep_segment is blocked until then.
@@ -1389,7 +2436,11 @@ void st_prep_buffer()
 float st_get_realtime_rate()
 {
   if (sys.state & (STATE_CYCLE | STATE_HOMING | STATE_HOLD | STATE_JOG | STATE_SAFETY_DOOR)){
-    return prep.current_speed;
+    #ifdef STEPPER_FIXED_POINT
+      return st_fp_get_current_speed();
+    #else
+      return prep.current_speed;
+    #endif
   }
   return 0.0f;
 }
@@ -26,6 +26,15 @@
   #define SEGMENT_BUFFER_SIZE 10
 #endif
 
+#ifdef ADAPTIVE_SEGMENT_TIME
+  #ifndef CRUISE_SEGMENT_TICKS
+    #define CRUISE_SEGMENT_TICKS 4 // Cruise segment time in acceleration ticks
+  #endif
+  #ifndef SEGMENT_BUFFER_TICKS
+    #define SEGMENT_BUFFER_TICKS (SEGMENT_BUFFER_SIZE-1) // Queued segment time in acceleration ticks
+  #endif
+#endif
+
 // Initialize and setup the stepper motor subsystem
 void stepper_init();
 
@@ -56,4 +65,89 @@ void st_update_plan_block_parameters();
 // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
 float st_get_realtime_rate();
 
+#ifdef STEPPER_ISR_PROFILE
+  #define ST_PROFILE_BINS 8 // Number of histogram bins. The last bin collects all longer calls.
+  #define ST_PROFILE_BIN_CYCLES (5*TICKS_PER_MICROSECOND) // Histogram bin width in CPU cycles.
+  #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+    #define ST_PROFILE_LEVELS 4 // AMASS levels 0-3
+  #else
+    #define ST_PROFILE_LEVELS 1
+  #endif
+
+  // Profile buckets. Stepper interrupt buckets are indexed by load type times ST_PROFILE_LEVELS
+  // plus the AMASS level of the executing segment.
+  #define ST_PROFILE_LOAD_NONE    0 // Steps within the executing segment.
+  #define ST_PROFILE_LOAD_SEGMENT 1 // Loaded a new segment of the same stepper block.
+  #define ST_PROFILE_LOAD_BLOCK   2 // Loaded a new segment and a new stepper block.
+  #define ST_PROFILE_IDLE         (3*ST_PROFILE_LEVELS) // Segment buffer empty. Steppers shut down.
+  #define ST_PROFILE_PORT_RESET   (ST_PROFILE_IDLE+1)   // Timer0 step port reset interrupt.
+  #define ST_PROFILE_BUCKETS      (ST_PROFILE_PORT_RESET+1)
+
+  typedef struct {
+    uint32_t count;      // Number of recorded interrupt calls
+    uint32_t cycles;     // Sum of cycles over all calls, low 32 bits. Average is cycles/count.
+    uint8_t cycles_high; // Carries of the cycle sum, which wraps after a few minutes of stepping.
+    uint16_t min;
+    uint16_t max;
+    uint16_t histogram[ST_PROFILE_BINS]; // Saturating call counts per ST_PROFILE_BIN_CYCLES bin
+  } st_profile_t;
+
+  // Copies one profile bucket atomically.
+  void st_profile_get(uint8_t bucket, st_profile_t *profile);
+
+  // Returns the number of stepper interrupts that fired while the previous one was still busy.
+  uint16_t st_profile_get_overruns();
+
+  // Clears all profile buckets.
+  void st_profile_reset();
+#endif
+
+#ifdef STEPPER_TRACE
+  #define ST_TRACE_SIZE 64   // Number of trace records kept. Must be a power of two, at most 128.
+  #define ST_TRACE_TICK_US 4 // Timestamp resolution in microseconds. Timestamps wrap after 262msec.
+
+  // Trace events, recorded by the stepper interrupt.
+  #define ST_TRACE_SEGMENT  0 // Loaded a new segment of the same stepper block.
+  #define ST_TRACE_AMASS    1 // Loaded a new segment of the same stepper block at another AMASS level.
+  #define ST_TRACE_BLOCK    2 // Loaded a new segment and a new stepper block.
+  #define ST_TRACE_IDLE     3 // Segment buffer empty and planner empty. Steppers shut down.
+  #define ST_TRACE_UNDERRUN 4 // Segment buffer empty while the planner still holds blocks.
+
+  typedef struct {
+    uint16_t time;            // Timer5 count in ST_TRACE_TICK_US units
+    uint16_t cycles_per_tick; // Stepper timer period of the loaded segment. Zero when going idle.
+    uint8_t event;            // ST_TRACE_* event
+    uint8_t level;            // AMASS level of the loaded segment, or Timer1 prescaler without AMASS
+    uint8_t queued;           // Segments in the segment buffer, or planner blocks when going idle
+  } st_trace_t;
+
+  // Copies a trace record atomically. Index zero is the oldest record. Returns false past the
+  // newest record.
+  uint8_t st_trace_get(uint8_t index, st_trace_t *record);
+
+  // Stops recording, so the trace can be read out unchanged.
+  void st_trace_stop();
+
+  // Clears the trace and restarts recording.
+  void st_trace_reset();
+#endif
+
+#ifdef SEGMENT_BUFFER_STATS
+  // Segment buffer health counters. Counters saturate at 65535. Motion counts as ongoing while the
+  // planner holds a block that is not fully prepped, so the buffer draining at the end of a motion
+  // or in a feed hold is not counted.
+  typedef struct {
+    uint16_t underruns;       // Segment buffer ran empty and stopped the steppers mid-motion.
+    uint16_t near_underruns;  // Stepper loaded the last queued segment mid-motion.
+    uint16_t planner_starved; // Planner ran empty while the steppers moved and was refilled in time.
+    uint8_t low_water;        // Fewest queued segments at a segment load mid-motion.
+  } st_buffer_stats_t;
+
+  // Copies the segment buffer counters atomically.
+  void st_get_buffer_stats(st_buffer_stats_t *stats);
+
+  // Clears the segment buffer counters.
+  void st_reset_buffer_stats();
+#endif
+
 #endif
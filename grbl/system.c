@@ -89,10 +89,9 @@ void system_execute_startup(char *line)
   uint8_t n;
   for (n=0; n < N_STARTUP_LINE; n++) {
     if (!(settings_read_startup_line(n, line))) {
-      line[0] = 0;
       report_execute_startup_message(line,STATUS_SETTING_READ_FAIL);
     } else {
-      if (line[0] != 0) {
+      if (line_get_char(line, 0) != 0) {
         uint8_t status_code = gc_execute_line(line);
         report_execute_startup_message(line,status_code);
       }
@@ -109,9 +108,23 @@ void system_execute_startup(char *line)
 // the lines that are processed afterward, not necessarily real-time during a cycle,
 // since there are motions already stored in the buffer. However, this 'lag' should not
 // be an issue, since these commands are not typically used during a cycle.
-uint8_t system_execute_line(char *line)
+uint8_t system_execute_line(char *line) { return(system_execute_line_at(line, 0)); }
+
+
+// Character i of the line passed to system_execute_line_at(). Its index wraps around at 256.
+#define LINE_AT(i) line[(uint8_t)(line_start+(i))]
+// Scratch line for the stored startup lines and build info. With PARSE_LINES_IN_RX_BUFFER, they
+// are read in place in EEPROM instead, see line_get_char().
+#ifdef PARSE_LINES_IN_RX_BUFFER
+  #define STORED_LINE NULL
+#else
+  #define STORED_LINE line
+#endif
+
+// Executes the '$' line starting at line[line_start], such as a line in the serial RX buffer.
+uint8_t system_execute_line_at(char *line, uint8_t line_start)
 {
-  uint8_t char_counter = 1;
+  uint8_t char_counter = line_start+1;
   uint8_t helper_var = 0; // Helper variable
   float parameter, value;
   switch( line[char_counter] ) {
@@ -119,12 +132,12 @@ uint8_t system_execute_line(char *line)
     case 'J' : // Jogging
       // Execute only if in IDLE or JOG states.
       if (sys.state != STATE_IDLE && sys.state != STATE_JOG) { return(STATUS_IDLE_ERROR); }
-      if(line[2] != '=') { return(STATUS_INVALID_STATEMENT); }
-      return(gc_execute_line(line)); // NOTE: $J= is ignored inside g-code parser and used to detect jog motions.
+      if(LINE_AT(2) != '=') { return(STATUS_INVALID_STATEMENT); }
+      return(gc_execute_line_at(line, line_start)); // NOTE: $J= is ignored inside g-code parser and used to detect jog motions.
       break;
     case '$': case 'G': case 'C': case 'X':
-      if ( line[2] != 0 ) { return(STATUS_INVALID_STATEMENT); }
-      switch( line[1] ) {
+      if ( LINE_AT(2) != 0 ) { return(STATUS_INVALID_STATEMENT); }
+      switch( LINE_AT(1) ) {
         case '$' : // Prints Grbl settings
           if ( sys.state & (STATE_CYCLE | STATE_HOLD) ) { return(STATUS_IDLE_ERROR); } // Block during cycle. Takes too long to print.
           else { report_grbl_settings(); }
@@ -157,23 +170,65 @@ uint8_t system_execute_line(char *line)
           break;
       }
       break;
+    #ifdef STEPPER_ISR_PROFILE
+      case 'P' : // Print or clear stepper interrupt profile. Allowed while running.
+        if ( LINE_AT(2) == 0 ) { report_stepper_isr_profile(); }
+        else if ( (LINE_AT(2) == '=') && (LINE_AT(3) == '0') && (LINE_AT(4) == 0) ) { st_profile_reset(); }
+        else { return(STATUS_INVALID_STATEMENT); }
+        break;
+    #endif
+    #ifdef STEPPER_TRACE
+      case 'T' : // Stop and print, or clear and restart step event trace. Allowed while running.
+        if ( LINE_AT(2) == 0 ) {
+          st_trace_stop();
+          report_stepper_trace();
+        }
+        else if ( (LINE_AT(2) == '=') && (LINE_AT(3) == '0') && (LINE_AT(4) == 0) ) { st_trace_reset(); }
+        else { return(STATUS_INVALID_STATEMENT); }
+        break;
+    #endif
+    #ifdef SEGMENT_BUFFER_STATS
+      case 'U' : // Print or clear segment buffer counters. Allowed while running.
+        if ( LINE_AT(2) == 0 ) { report_segment_buffer_stats(); }
+        else if ( (LINE_AT(2) == '=') && (LINE_AT(3) == '0') && (LINE_AT(4) == 0) ) { st_reset_buffer_stats(); }
+        else { return(STATUS_INVALID_STATEMENT); }
+        break;
+    #endif
+    #ifdef ENABLE_POSITION_PUSH
+      case 'D' : // Set position push period in milliseconds. Zero disables. Allowed while running.
+        if ( LINE_AT(2) != '=' ) { return(STATUS_INVALID_STATEMENT); }
+        char_counter = line_start+3;
+        if (!read_float(line, &char_counter, &value)) { return(STATUS_BAD_NUMBER_FORMAT); }
+        if ( (line[char_counter] != 0) || (value != trunc(value)) || (value > 255) ) { return(STATUS_INVALID_STATEMENT); }
+        if (value < 0) { return(STATUS_NEGATIVE_VALUE); }
+        push_set_period(value);
+        break;
+    #endif
+    #ifdef ENABLE_BINARY_GCODE
+      case 'B' : // Enable or disable binary g-code frames. Allowed while running.
+        if ( (LINE_AT(2) != '=') || (LINE_AT(4) != 0) ) { return(STATUS_INVALID_STATEMENT); }
+        if ( LINE_AT(3) == '1' ) { serial_enable_binary_frames(true); }
+        else if ( LINE_AT(3) == '0' ) { serial_enable_binary_frames(false); }
+        else { return(STATUS_INVALID_STATEMENT); }
+        break;
+    #endif
     default :
       // Block any system command that requires the state as IDLE/ALARM. (i.e. EEPROM, homing)
       if ( !(sys.state == STATE_IDLE || sys.state == STATE_ALARM) ) { return(STATUS_IDLE_ERROR); }
-      switch( line[1] ) {
+      switch( LINE_AT(1) ) {
         case '#' : // Print Grbl NGC parameters
-          if ( line[2] != 0 ) { return(STATUS_INVALID_STATEMENT); }
+          if ( LINE_AT(2) != 0 ) { return(STATUS_INVALID_STATEMENT); }
           else { report_ngc_parameters(); }
           break;
         case 'H' : // Perform homing cycle [IDLE/ALARM]
           if (bit_isfalse(settings.flags,BITFLAG_HOMING_ENABLE)) {return(STATUS_SETTING_DISABLED); }
           if (system_check_safety_door_ajar()) { return(STATUS_CHECK_DOOR); } // Block if safety door is ajar.
           sys.state = STATE_HOMING; // Set system state variable
-          if (line[2] == 0) {
+          if (LINE_AT(2) == 0) {
             mc_homing_cycle(HOMING_CYCLE_ALL);
           #ifdef HOMING_SINGLE_AXIS_COMMANDS
-            } else if (line[3] == 0) {
-              switch (line[2]) {
+            } else if (LINE_AT(3) == 0) {
+              switch (LINE_AT(2)) {
                 case 'X': mc_homing_cycle(axis_X_mask); break;
                 case 'Y': mc_homing_cycle(axis_Y_mask); break;
                 case 'Z': mc_homing_cycle(axis_Z_mask); break;
@@ -226,31 +281,31 @@ uint8_t system_execute_line(char *line)
           if (!sys.abort) {  // Execute startup scripts after successful homing.
             sys.state = STATE_IDLE; // Set to IDLE when complete.
             st_go_idle(); // Set steppers to the settings idle state before returning.
-            if (line[2] == 0) { system_execute_startup(line); }
+            if (LINE_AT(2) == 0) { system_execute_startup(STORED_LINE); }
           }
           break;
         case 'S' : // Puts Grbl to sleep [IDLE/ALARM]
-          if ((line[2] != 'L') || (line[3] != 'P') || (line[4] != 0)) { return(STATUS_INVALID_STATEMENT); }
+          if ((LINE_AT(2) != 'L') || (LINE_AT(3) != 'P') || (LINE_AT(4) != 0)) { return(STATUS_INVALID_STATEMENT); }
           system_set_exec_state_flag(EXEC_SLEEP); // Set to execute sleep mode immediately
           break;
         case 'I' : // Print or store build info. [IDLE/ALARM]
           if ( line[++char_counter] == 0 ) {
-            settings_read_build_info(line);
-            report_build_info(line);
+            settings_read_build_info(STORED_LINE);
+            report_build_info(STORED_LINE);
           #ifdef ENABLE_BUILD_INFO_WRITE_COMMAND
             } else { // Store startup line [IDLE/ALARM]
               if(line[char_counter++] != '=') { return(STATUS_INVALID_STATEMENT); }
               helper_var = char_counter; // Set helper variable as counter to start of user info line.
               do {
-                line[char_counter-helper_var] = line[char_counter];
+                LINE_AT(char_counter-helper_var) = line[char_counter];
               } while (line[char_counter++] != 0);
-              settings_store_build_info(line);
+              return(settings_store_build_info(line, line_start));
           #endif
           }
           break;
         case 'R' : // Restore defaults [IDLE/ALARM]
-          if ((line[2] != 'S') || (line[3] != 'T') || (line[4] != '=') || (line[6] != 0)) { return(STATUS_INVALID_STATEMENT); }
-          switch (line[5]) {
+          if ((LINE_AT(2) != 'S') || (LINE_AT(3) != 'T') || (LINE_AT(4) != '=') || (LINE_AT(6) != 0)) { return(STATUS_INVALID_STATEMENT); }
+          switch (LINE_AT(5)) {
             #ifdef ENABLE_RESTORE_EEPROM_DEFAULT_SETTINGS
               case '$': settings_restore(SETTINGS_RESTORE_DEFAULTS); break;
             #endif
@@ -262,16 +317,23 @@ uint8_t system_execute_line(char *line)
             #endif
             default: return(STATUS_INVALID_STATEMENT);
           }
+          #ifdef EEPROM_WRITE_QUEUE
+            // Finish writing before the reply, so a host may power cycle or reset the board after it.
+            while (eeprom_write_pending()) {
+              protocol_execute_realtime();
+              if (sys.abort) { return(STATUS_OK); }
+            }
+          #endif
           report_feedback_message(MESSAGE_RESTORE_DEFAULTS);
           mc_reset(); // Force reset to ensure settings are initialized correctly.
           break;
         case 'N' : // Startup lines. [IDLE/ALARM]
           if ( line[++char_counter] == 0 ) { // Print startup lines
             for (helper_var=0; helper_var < N_STARTUP_LINE; helper_var++) {
-              if (!(settings_read_startup_line(helper_var, line))) {
+              if (!(settings_read_startup_line(helper_var, STORED_LINE))) {
                 report_status_message(STATUS_SETTING_READ_FAIL);
               } else {
-                report_startup_line(helper_var,line);
+                report_startup_line(helper_var,STORED_LINE);
               }
             }
             break;
@@ -287,15 +349,15 @@ uint8_t system_execute_line(char *line)
             // Prepare sending gcode block to gcode parser by shifting all characters
             helper_var = char_counter; // Set helper variable as counter to start of gcode block
             do {
-              line[char_counter-helper_var] = line[char_counter];
+              LINE_AT(char_counter-helper_var) = line[char_counter];
             } while (line[char_counter++] != 0);
-            if (char_counter > EEPROM_LINE_SIZE) { return(STATUS_LINE_LENGTH_EXCEEDED); }
+            if ((uint8_t)(char_counter-line_start) > EEPROM_LINE_SIZE) { return(STATUS_LINE_LENGTH_EXCEEDED); }
             // Execute gcode block to ensure block is valid.
-            helper_var = gc_execute_line(line); // Set helper_var to returned status code.
+            helper_var = gc_execute_line_at(line, line_start); // Set helper_var to returned status code.
             if (helper_var) { return(helper_var); }
             else {
               helper_var = trunc(parameter); // Set helper_var to int value of parameter
-              settings_store_startup_line(helper_var,line);
+              return(settings_store_startup_line(helper_var,line,line_start));
             }
           } else { // Store global setting.
             if(!read_float(line, &char_counter, &value)) { return(STATUS_BAD_NUMBER_FORMAT); }
@@ -326,14 +388,14 @@ float system_convert_axis_steps_to_mpos(int32_t *steps, uint8_t idx)
   float pos;
   #ifdef COREXY
     if (idx==AXIS_1) {
-      pos = (float)system_convert_corexy_to_x_axis_steps(steps) / settings.steps_per_mm[idx];
+      pos = (float)system_convert_corexy_to_x_axis_steps(steps) * settings_inverse.mm_per_step[idx];
     } else if (idx==AXIS_2) {
-      pos = (float)system_convert_corexy_to_y_axis_steps(steps) / settings.steps_per_mm[idx];
+      pos = (float)system_convert_corexy_to_y_axis_steps(steps) * settings_inverse.mm_per_step[idx];
     } else {
-      pos = steps[idx]/settings.steps_per_mm[idx];
+      pos = steps[idx]*settings_inverse.mm_per_step[idx];
     }
   #else
-    pos = steps[idx]/settings.steps_per_mm[idx];
+    pos = steps[idx]*settings_inverse.mm_per_step[idx];
   #endif
   return(pos);
 }
@@ -22,6 +22,7 @@
 #define system_h
 
 #include "grbl.h"
+#include "cpu_map.h" // For STEP_PORT_GROUPS
 
 // Define system executor bit map. Used internally by realtime protocol as realtime command flags,
 // which notifies the main program to execute the specified realtime command asynchronously.
@@ -124,7 +125,7 @@ typedef struct {
   uint8_t step_control;        // Governs the step segment generator depending on system state.
   uint8_t probe_succeeded;     // Tracks if last probing cycle was successful.
   #ifdef DEFAULTS_RAMPS_BOARD
-    uint8_t homing_axis_lock[N_AXIS];    // Locks axes when limits engage. Used as an axis motion mask in the stepper ISR.
+    uint8_t homing_axis_lock[STEP_PORT_GROUPS];    // Locks axes when limits engage. Step pin mask per step port group.
   #else
     uint8_t homing_axis_lock;    // Locks axes when limits engage. Used as an axis motion mask in the stepper ISR.
   #endif
@@ -164,6 +165,9 @@ extern unsigned char axis_name[N_AXIS]; // Global table of axis names
   #define EXEC_DEBUG_REPORT  bit(0)
   extern volatile uint8_t sys_rt_exec_debug;
 #endif
+#ifdef ENABLE_BINARY_STATUS_REPORT
+  extern volatile uint8_t sys_rt_exec_status_frame; // Set by RX ISR to request a binary status frame.
+#endif
 
 // Initialize the serial protocol
 void system_init();
@@ -177,7 +181,11 @@ uint8_t system_check_safety_door_ajar();
 // Executes an internal system command, defined as a string starting with a '$'
 uint8_t system_execute_line(char *line);
 
-// Execute the startup script lines stored in EEPROM upon initialization
+// Executes a '$' line starting at line[line_start], such as a line in the serial RX buffer
+uint8_t system_execute_line_at(char *line, uint8_t line_start);
+
+// Execute the startup script lines stored in EEPROM upon initialization. Line is scratch space
+// for them. With PARSE_LINES_IN_RX_BUFFER, a NULL line executes them in place in EEPROM.
 void system_execute_startup(char *line);
 
 
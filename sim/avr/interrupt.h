@@ -0,0 +1,33 @@
+/*
+  avr/interrupt.h - Stand-in interrupt handling for the host simulator build
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef sim_avr_interrupt_h
+#define sim_avr_interrupt_h
+
+// Interrupt vectors become ordinary functions. The simulator runs them on the firmware thread
+// from a signal handler, so they preempt the main program exactly like a hardware interrupt.
+#define ISR(vector, ...) void vector(void)
+// An aliased vector is left as a declaration. The simulator never raises it.
+#define ISR_ALIASOF(vector)
+
+// The global interrupt flag lives in SREG bit 7. Clearing it defers any pending vector until
+// it is set again.
+#define cli() do { SREG &= ~(1<<SREG_I); __sync_synchronize(); } while (0)
+#define sei() do { __sync_synchronize(); SREG |= (1<<SREG_I); } while (0)
+
+#endif
@@ -0,0 +1,243 @@
+/*
+  avr/io.h - Stand-in ATmega2560 register file for the host simulator build
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Every I/O register Grbl touches is a plain volatile variable here. The simulator in sim.c
+// watches the timer, USART and EEPROM registers to decide when to raise the matching interrupt
+// vectors. Bit positions are those of the ATmega2560 datasheet.
+
+#ifndef sim_avr_io_h
+#define sim_avr_io_h
+
+#include <stdint.h>
+
+// The 24-bit integer types built into avr-gcc. Wider on the host.
+typedef uint32_t __uint24;
+typedef int32_t __int24;
+
+#ifndef SIM_REG8
+  #define SIM_REG8(r) extern volatile uint8_t r;
+  #define SIM_REG16(r) extern volatile uint16_t r;
+#endif
+
+// General purpose I/O ports
+SIM_REG8(PORTA) SIM_REG8(DDRA) SIM_REG8(PINA)
+SIM_REG8(PORTB) SIM_REG8(DDRB) SIM_REG8(PINB)
+SIM_REG8(PORTC) SIM_REG8(DDRC) SIM_REG8(PINC)
+SIM_REG8(PORTD) SIM_REG8(DDRD) SIM_REG8(PIND)
+SIM_REG8(PORTE) SIM_REG8(DDRE) SIM_REG8(PINE)
+SIM_REG8(PORTF) SIM_REG8(DDRF) SIM_REG8(PINF)
+SIM_REG8(PORTG) SIM_REG8(DDRG) SIM_REG8(PING)
+SIM_REG8(PORTH) SIM_REG8(DDRH) SIM_REG8(PINH)
+SIM_REG8(PORTJ) SIM_REG8(DDRJ) SIM_REG8(PINJ)
+SIM_REG8(PORTK) SIM_REG8(DDRK) SIM_REG8(PINK)
+SIM_REG8(PORTL) SIM_REG8(DDRL) SIM_REG8(PINL)
+
+// Timer/Counter0 (8-bit)
+SIM_REG8(TCCR0A) SIM_REG8(TCCR0B) SIM_REG8(TCNT0) SIM_REG8(OCR0A) SIM_REG8(OCR0B)
+SIM_REG8(TIMSK0) SIM_REG8(TIFR0)
+
+// Timer/Counter1,3,4,5 (16-bit)
+SIM_REG8(TCCR1A) SIM_REG8(TCCR1B) SIM_REG8(TCCR1C) SIM_REG16(TCNT1) SIM_REG16(OCR1A)
+SIM_REG16(OCR1B) SIM_REG16(OCR1C) SIM_REG16(ICR1) SIM_REG8(TIMSK1) SIM_REG8(TIFR1)
+SIM_REG8(TCCR3A) SIM_REG8(TCCR3B) SIM_REG8(TCCR3C) SIM_REG16(TCNT3) SIM_REG16(OCR3A)
+SIM_REG16(OCR3B) SIM_REG16(OCR3C) SIM_REG16(ICR3) SIM_REG8(TIMSK3) SIM_REG8(TIFR3)
+SIM_REG8(TCCR4A) SIM_REG8(TCCR4B) SIM_REG8(TCCR4C) SIM_REG16(TCNT4) SIM_REG16(OCR4A)
+SIM_REG16(OCR4B) SIM_REG16(OCR4C) SIM_REG16(ICR4) SIM_REG8(TIMSK4) SIM_REG8(TIFR4)
+SIM_REG8(TCCR5A) SIM_REG8(TCCR5B) SIM_REG8(TCCR5C) SIM_REG16(OCR5A)
+SIM_REG16(OCR5B) SIM_REG16(OCR5C) SIM_REG16(ICR5) SIM_REG8(TIMSK5) SIM_REG8(TIFR5)
+
+// TCNT5 is read-only. Without a prescaler it counts host CPU time in F_CPU cycles, so a free-running
+// Timer5 measures how long the host takes to run firmware code. With a prescaler it counts the
+// virtual clock divided by the TCCR5B prescaler, as a timebase for events.
+uint16_t sim_tcnt5();
+#define TCNT5 sim_tcnt5()
+
+// Timer/Counter2 (8-bit)
+SIM_REG8(TCCR2A) SIM_REG8(TCCR2B) SIM_REG8(TCNT2) SIM_REG8(OCR2A) SIM_REG8(OCR2B)
+SIM_REG8(TIMSK2) SIM_REG8(TIFR2)
+
+// USART0
+SIM_REG8(UCSR0A) SIM_REG8(UCSR0B) SIM_REG8(UCSR0C) SIM_REG8(UBRR0H) SIM_REG8(UBRR0L)
+SIM_REG8(UDR0)
+
+// EEPROM. The control and data registers are routed through accessors, so a read strobe returns
+// data immediately and a write strobe is committed before the next register access.
+SIM_REG16(EEAR)
+volatile uint8_t *sim_eecr();
+volatile uint8_t *sim_eedr();
+#define EECR (*sim_eecr())
+#define EEDR (*sim_eedr())
+#define E2END 0x0FFF // Last EEPROM address of the ATmega2560, matching SIM_EEPROM_SIZE.
+
+// Pin change and external interrupts
+SIM_REG8(PCICR) SIM_REG8(PCIFR) SIM_REG8(PCMSK0) SIM_REG8(PCMSK1) SIM_REG8(PCMSK2)
+SIM_REG8(EICRA) SIM_REG8(EICRB) SIM_REG8(EIMSK) SIM_REG8(EIFR)
+
+// Watchdog and MCU status
+SIM_REG8(WDTCSR) SIM_REG8(MCUSR)
+
+// Status register. Thread-local, so the simulator's peripheral thread never touches the global
+// interrupt flag of the firmware thread.
+extern __thread volatile uint8_t sim_sreg;
+#define SREG sim_sreg
+#define SREG_I 7
+
+// Timer/Counter control bits. Identical positions for all 8- and 16-bit timers.
+#define COM0A1 7
+#define COM0A0 6
+#define COM0B1 5
+#define COM0B0 4
+#define WGM01 1
+#define WGM00 0
+#define WGM02 3
+#define CS02 2
+#define CS01 1
+#define CS00 0
+#define OCIE0B 2
+#define OCIE0A 1
+#define TOIE0 0
+#define TOV0 0
+
+#define COM1A1 7
+#define COM1A0 6
+#define COM1B1 5
+#define COM1B0 4
+#define COM1C1 3
+#define COM1C0 2
+#define WGM11 1
+#define WGM10 0
+#define WGM13 4
+#define WGM12 3
+#define CS12 2
+#define CS11 1
+#define CS10 0
+#define OCIE1C 3
+#define OCIE1B 2
+#define OCIE1A 1
+#define TOIE1 0
+
+#define COM2A1 7
+#define COM2A0 6
+#define COM2B1 5
+#define COM2B0 4
+#define WGM21 1
+#define WGM20 0
+#define WGM22 3
+#define CS22 2
+#define CS21 1
+#define CS20 0
+#define OCIE2B 2
+#define OCIE2A 1
+#define TOIE2 0
+
+#define COM3A1 7
+#define COM3A0 6
+#define COM3B1 5
+#define COM3B0 4
+#define WGM31 1
+#define WGM30 0
+#define WGM33 4
+#define WGM32 3
+#define CS32 2
+#define CS31 1
+#define CS30 0
+#define OCIE3A 1
+#define TOIE3 0
+
+#define COM4A1 7
+#define COM4A0 6
+#define COM4B1 5
+#define COM4B0 4
+#define COM4C1 3
+#define COM4C0 2
+#define WGM41 1
+#define WGM40 0
+#define WGM43 4
+#define WGM42 3
+#define CS42 2
+#define CS41 1
+#define CS40 0
+#define OCIE4A 1
+#define TOIE4 0
+
+#define COM5A1 7
+#define COM5A0 6
+#define COM5B1 5
+#define COM5B0 4
+#define WGM51 1
+#define WGM50 0
+#define WGM53 4
+#define WGM52 3
+#define CS52 2
+#define CS51 1
+#define CS50 0
+#define OCIE5A 1
+#define TOIE5 0
+
+// USART0 bits
+#define RXC0 7
+#define TXC0 6
+#define UDRE0 5
+#define U2X0 1
+#define RXCIE0 7
+#define TXCIE0 6
+#define UDRIE0 5
+#define RXEN0 4
+#define TXEN0 3
+
+// EEPROM control bits
+#define EERIE 3
+#define EEMPE 2
+#define EEPE 1
+#define EERE 0
+
+// Pin change and external interrupt bits
+#define PCIE2 2
+#define PCIE1 1
+#define PCIE0 0
+#define INT7 7
+#define INT6 6
+#define INT5 5
+#define INT4 4
+#define INT3 3
+#define INT2 2
+#define INT1 1
+#define INT0 0
+#define ISC51 3
+#define ISC50 2
+#define ISC41 1
+#define ISC40 0
+#define ISC31 7
+#define ISC30 6
+#define ISC21 5
+#define ISC20 4
+#define PCINT10 2
+#define PCINT9 1
+
+// Watchdog and MCU status bits
+#define WDIF 7
+#define WDIE 6
+#define WDP3 5
+#define WDCE 4
+#define WDE 3
+#define WDP2 2
+#define WDP1 1
+#define WDP0 0
+#define WDRF 3
+
+#endif
@@ -0,0 +1,26 @@
+/*
+  avr/wdt.h - Stand-in watchdog support for the host simulator build
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef sim_avr_wdt_h
+#define sim_avr_wdt_h
+
+// Grbl only uses the watchdog as a debounce timer through WDTCSR. There is no reset to emulate.
+#define wdt_reset()
+#define wdt_disable() (WDTCSR = 0)
+
+#endif
@@ -0,0 +1,103 @@
+/*
+  avr_io.c - Register storage and EEPROM emulation for the host simulator build
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+// Instantiate every register declared by the stand-in <avr/io.h>.
+#define SIM_REG8(r) volatile uint8_t r;
+#define SIM_REG16(r) volatile uint16_t r;
+#include <avr/io.h>
+#include "sim.h"
+
+// EEPROM programming mode bits. Not defined in the device headers either. See eeprom.c.
+#define EEPM1 5
+#define EEPM0 4
+
+__thread volatile uint8_t sim_sreg;
+volatile uint64_t sim_cycles;
+
+static volatile uint8_t eecr;
+static volatile uint8_t eedr;
+static uint8_t eeprom_mem[SIM_EEPROM_SIZE];
+static int eeprom_fd = -1;
+
+
+void sim_eeprom_open(const char *path)
+{
+  memset(eeprom_mem, 0xFF, SIM_EEPROM_SIZE);
+  eeprom_fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (eeprom_fd < 0) { perror(path); return; }
+  if (read(eeprom_fd, eeprom_mem, SIM_EEPROM_SIZE) != SIM_EEPROM_SIZE) {
+    if (pwrite(eeprom_fd, eeprom_mem, SIM_EEPROM_SIZE, 0) != SIM_EEPROM_SIZE) { perror(path); }
+  }
+}
+
+
+// Completes a read or write strobe. Writes take effect immediately, but EEPE stays visible to
+// the firmware until the next register access, like the real programming delay.
+void sim_eeprom_sync()
+{
+  uint8_t cr = eecr;
+  if (cr & (1<<EERE)) {
+    eedr = eeprom_mem[EEAR % SIM_EEPROM_SIZE];
+    cr &= ~(1<<EERE);
+  }
+  if (cr & (1<<EEPE)) {
+    uint16_t addr = EEAR % SIM_EEPROM_SIZE;
+    switch (cr & ((1<<EEPM1)|(1<<EEPM0))) {
+      case 0: eeprom_mem[addr] = eedr; break; // Erase+Write
+      case (1<<EEPM0): eeprom_mem[addr] = 0xFF; break; // Erase-only
+      case (1<<EEPM1): eeprom_mem[addr] &= eedr; break; // Write-only
+    }
+    if (eeprom_fd >= 0) {
+      if (pwrite(eeprom_fd, &eeprom_mem[addr], 1, addr) != 1) { perror("eeprom"); }
+    }
+    cr &= ~((1<<EEPE)|(1<<EEMPE));
+  }
+  eecr = cr;
+}
+
+
+volatile uint8_t *sim_eecr()
+{
+  if (eecr & (1<<EEPE)) { sim_eeprom_sync(); }
+  return(&eecr);
+}
+
+
+uint8_t sim_eecr_peek() { return(eecr); }
+
+
+volatile uint8_t *sim_eedr()
+{
+  sim_eeprom_sync();
+  return(&eedr);
+}
+
+
+uint16_t sim_tcnt5()
+{
+  static const uint16_t prescaler[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+  uint16_t div = prescaler[TCCR5B & 0x07];
+  if (div == 0) { return(0); } // Stopped or clocked externally
+  return((uint16_t)(sim_cycles/div));
+}
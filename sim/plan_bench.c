@@ -0,0 +1,282 @@
+/*
+  plan_bench.c - Host-native planner microbenchmark
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  Times plan_buffer_line() on the host. Toolpaths are fed through the real g-code parser and
+  motion control, so arcs are segmented by mc_arc() as on the machine. There is no stepper and
+  no peripheral thread. Instead, the oldest block is discarded whenever the parser finds the
+  planner buffer full, which keeps the buffer full and every new block planned against the
+  whole buffer, like a job streaming faster than it runs.
+
+  Every discarded block adds its planned entry and exit speeds to a checksum. Builds that plan
+  identically print identical checksums, so planner changes can be checked against the baseline
+  along with their timing.
+*/
+
+#define _GNU_SOURCE
+#include "grbl.h"
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+static struct {
+  uint32_t calls;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint32_t errors;
+  uint64_t visits;
+  double checksum;
+} bench;
+
+extern uint32_t planner_visits;
+
+
+static uint64_t bench_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return((uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec);
+}
+
+
+// Stands in for the stepper consuming the oldest block.
+static void bench_discard_block()
+{
+  plan_block_t *block = plan_get_current_block();
+  bench.checksum += block->entry_speed_sqr + plan_get_exec_block_exit_speed_sqr();
+  plan_discard_current_block();
+}
+
+
+uint8_t __real_plan_buffer_line(float *target, plan_line_data_t *pl_data);
+uint8_t __wrap_plan_buffer_line(float *target, plan_line_data_t *pl_data)
+{
+  uint64_t start = bench_ns();
+  uint32_t visits = planner_visits;
+  uint8_t status = __real_plan_buffer_line(target, pl_data);
+  uint64_t ns = bench_ns() - start;
+  bench.visits += planner_visits - visits;
+  bench.calls++;
+  bench.total_ns += ns;
+  if (ns > bench.max_ns) { bench.max_ns = ns; }
+  return(status);
+}
+
+
+#ifdef ARC_PLANNER_BLOCKS
+  uint8_t __real_plan_buffer_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset,
+    float angular_travel, uint8_t axis_0, uint8_t axis_1, uint8_t axis_0_mask, uint8_t axis_1_mask);
+  uint8_t __wrap_plan_buffer_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset,
+    float angular_travel, uint8_t axis_0, uint8_t axis_1, uint8_t axis_0_mask, uint8_t axis_1_mask)
+  {
+    uint64_t start = bench_ns();
+    uint32_t visits = planner_visits;
+    uint8_t status = __real_plan_buffer_arc(target, pl_data, position, offset, angular_travel,
+                                            axis_0, axis_1, axis_0_mask, axis_1_mask);
+    uint64_t ns = bench_ns() - start;
+    bench.visits += planner_visits - visits;
+    bench.calls++;
+    bench.total_ns += ns;
+    if (ns > bench.max_ns) { bench.max_ns = ns; }
+    return(status);
+  }
+
+
+  uint8_t __real_plan_check_full_arc_buffer();
+  uint8_t __wrap_plan_check_full_arc_buffer()
+  {
+    while (__real_plan_check_full_arc_buffer()) { bench_discard_block(); }
+    return(false);
+  }
+#endif
+
+
+uint8_t __real_plan_check_full_buffer();
+uint8_t __wrap_plan_check_full_buffer()
+{
+  if (__real_plan_check_full_buffer()) { bench_discard_block(); }
+  return(false);
+}
+
+
+// Spindle, coolant and dwell commands wait for the buffer to empty. Empty it.
+void __wrap_protocol_buffer_synchronize()
+{
+  while (plan_get_current_block() != NULL) { bench_discard_block(); }
+}
+
+
+// Nothing drains the serial TX buffer, and nothing reads it.
+void __wrap_serial_write(uint8_t data) { }
+
+
+// No dwell or delay takes any time. The virtual clock never runs.
+void __wrap_sim_delay_us(double us) { }
+
+
+static void bench_begin()
+{
+  memset(&bench, 0, sizeof(bench));
+  memset(sys_position, 0, sizeof(sys_position));
+  plan_reset();
+  gc_init();
+}
+
+
+// Strips spaces and comments and converts to upper case, like protocol_main_loop().
+static void bench_execute_line(const char *raw)
+{
+  char line[LINE_BUFFER_SIZE];
+  uint8_t count = 0, comment = false;
+  for (; *raw != '\0' && *raw != '\n' && *raw != '\r'; raw++) {
+    char c = *raw;
+    if (comment) {
+      if (c == ')') { comment = false; }
+    } else if (c == '(') {
+      comment = true;
+    } else if (c == ';') {
+      break;
+    } else if (c > ' ' && count < LINE_BUFFER_SIZE-1) {
+      line[count++] = toupper(c);
+    }
+  }
+  line[count] = '\0';
+  if (count == 0 || line[0] == '$') { return; } // Settings and system commands are not benchmarked.
+  if (gc_execute_line(line) != STATUS_OK) { bench.errors++; }
+}
+
+
+static void bench_report(const char *name)
+{
+  __wrap_protocol_buffer_synchronize();
+  if (bench.calls == 0) {
+    printf("%-16s no planner blocks\n", name);
+    return;
+  }
+  printf("%-16s %8lu calls %8.3f us/call %8.3f us max %6.2f blocks/call  checksum %.9e",
+         name, (unsigned long)bench.calls, bench.total_ns/1000.0/bench.calls,
+         bench.max_ns/1000.0, (double)bench.visits/bench.calls, bench.checksum);
+  if (bench.errors) { printf("  (%lu errors)", (unsigned long)bench.errors); }
+  printf("\n");
+}
+
+
+// Collinear 0.05mm segments, as from a finely tessellated straight edge.
+static void bench_line(uint32_t segments)
+{
+  bench_begin();
+  bench_execute_line("G21G91G1F3000");
+  for (uint32_t i = 0; i < segments; i++) { bench_execute_line("X0.05"); }
+  bench_report("line");
+}
+
+
+// 0.05mm staircase segments turning 90 degrees at every junction.
+static void bench_stairs(uint32_t segments)
+{
+  bench_begin();
+  bench_execute_line("G21G91G1F3000");
+  for (uint32_t i = 0; i < segments; i++) {
+    bench_execute_line((i & 1) ? "Y0.05" : "X0.05");
+  }
+  bench_report("stairs");
+}
+
+
+// Full circles of 5mm radius, segmented by mc_arc() to the arc tolerance setting. One block per
+// circle with ARC_PLANNER_BLOCKS.
+static void bench_arc(uint32_t segments)
+{
+  bench_begin();
+  bench_execute_line("G21G91G17F3000");
+  while (bench.calls < segments) { bench_execute_line("G2X0Y0I5J0"); }
+  bench_report("arc");
+}
+
+
+static void bench_file(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  if (f == NULL) { perror(path); exit(EXIT_FAILURE); }
+  bench_begin();
+  char raw[1024];
+  while (fgets(raw, sizeof(raw), f) != NULL) { bench_execute_line(raw); }
+  fclose(f);
+  bench_report(path);
+}
+
+
+static void usage()
+{
+  fprintf(stderr, "usage: grbl_plan_bench [-n SEGMENTS] [FILE]...\n");
+  exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char *argv[])
+{
+  uint32_t segments = 20000;
+  int i = 1;
+  if (i+1 < argc && strcmp(argv[i], "-n") == 0) {
+    segments = strtoul(argv[i+1], NULL, 10);
+    i += 2;
+  }
+  for (int j = i; j < argc; j++) { if (argv[j][0] == '-') { usage(); } }
+
+  // Default settings without soft limits, so toolpaths may go anywhere.
+  settings_restore(SETTINGS_RESTORE_ALL);
+  settings.flags &= ~BITFLAG_SOFT_LIMIT_ENABLE;
+  // Axis names, as set up by main(). Cloned axes count once in the block distance.
+  axis_name[AXIS_1] = AXIS_1_NAME;
+  axis_name[AXIS_2] = AXIS_2_NAME;
+  axis_name[AXIS_3] = AXIS_3_NAME;
+  #if N_AXIS > 3
+    axis_name[AXIS_4] = AXIS_4_NAME;
+  #endif
+  #if N_AXIS > 4
+    axis_name[AXIS_5] = AXIS_5_NAME;
+  #endif
+  #if N_AXIS > 5
+    axis_name[AXIS_6] = AXIS_6_NAME;
+  #endif
+  memset(&sys, 0, sizeof(system_t));
+  sys.state = STATE_IDLE;
+  sys.f_override = DEFAULT_FEED_OVERRIDE;
+  sys.r_override = DEFAULT_RAPID_OVERRIDE;
+  sys.spindle_speed_ovr = DEFAULT_SPINDLE_SPEED_OVERRIDE;
+
+  printf("Grbl planner benchmark, BLOCK_BUFFER_SIZE %d", (int)BLOCK_BUFFER_SIZE);
+  #ifdef PACKED_PLANNER_BLOCKS
+    printf(", PACKED_PLANNER_BLOCKS");
+  #endif
+  #ifdef ARC_PLANNER_BLOCKS
+    printf(", ARC_PLANNER_BLOCKS");
+  #endif
+  printf("\n");
+
+  if (i == argc) {
+    bench_line(segments);
+    bench_stairs(segments);
+    bench_arc(segments);
+  }
+  for (; i < argc; i++) { bench_file(argv[i]); }
+  return(EXIT_SUCCESS);
+}
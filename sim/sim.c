@@ -0,0 +1,664 @@
+/*
+  sim.c - Host-native simulator of the ATmega2560 peripherals used by Grbl
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+  The unmodified firmware runs on the process main thread, calling grbl_main() as if it had
+  just been reset. The firmware sources are compiled with -finstrument-functions, so every
+  function call enters the simulator. Each call advances the virtual CPU clock by a fixed
+  number of cycles, then runs any peripheral interrupt that has fallen due: Timer1 (stepper),
+  Timer0 (step port reset), Timer2 (position push), Timer3 (sleep), USART0 and the EEPROM ready
+  interrupt. Vectors run to completion on top of the main program, as on the real MCU, and wait
+  while SREG's I-bit is clear. They do not nest.
+
+  The clock depends only on the code the firmware runs, never on the host, so a run streaming
+  the same files always gives the same results. Delays advance the clock straight to their end,
+  running the interrupts due on the way. A few loops in the firmware spin on a variable without
+  calling any function. A watchdog thread finds the firmware stuck in one and signals it to
+  advance the clock to the next event.
+
+  The clock is held to wall time multiplied by a user-set scale, which only slows the run down
+  to follow a sender in real time. A scale of zero runs it as fast as the host can.
+
+  Serial data comes either from a pseudo-terminal, for use with any sender such as
+  doc/script/stream.py, or from G-code files streamed internally with the character-counting
+  protocol. On exit a summary of streaming throughput, planner stalls and step timing is
+  printed to stderr.
+*/
+
+#define _GNU_SOURCE
+#include "grbl.h"
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <errno.h>
+#include <unistd.h>
+
+// Interrupt vectors. Weak, so vectors left out by the build configuration resolve to NULL.
+#define SIM_VECTOR(v) extern void v(void) __attribute__((weak));
+SIM_VECTOR(TIMER1_COMPA_vect)
+SIM_VECTOR(TIMER0_OVF_vect)
+SIM_VECTOR(TIMER0_COMPA_vect)
+SIM_VECTOR(TIMER3_OVF_vect)
+SIM_VECTOR(TIMER2_COMPA_vect)
+SIM_VECTOR(USART0_RX_vect)
+SIM_VECTOR(USART0_UDRE_vect)
+SIM_VECTOR(EE_READY_vect)
+
+#define NEVER UINT64_MAX
+#define CALL_CYCLES 100 // Default clock advance per firmware function call.
+#define POLL_CYCLES (F_CPU/1000) // Host I/O is polled and the wall clock checked every 1msec.
+#define WATCHDOG_NS 200000 // Time without a firmware function call to assume a spin loop.
+#define EEPROM_WRITE_CYCLES ((uint64_t)F_CPU*34/10000) // 3.4msec EEPROM programming time.
+
+#define MAX_STREAM_FILES 16
+#define STREAM_LINE_MAX 256
+#define STREAM_QUEUE_SIZE 256 // Power of two. Lines in flight in the RX buffer.
+#define RX_FIFO_SIZE 4096 // Power of two. Host-side bytes waiting for the USART.
+
+// Simulation options
+static double time_scale = 1.0;
+static uint32_t call_cycles = CALL_CYCLES;
+static uint32_t baud_rate = BAUD_RATE;
+static const char *eeprom_path = "grbl_sim_eeprom.bin";
+static const char *stream_files[MAX_STREAM_FILES];
+static uint8_t stream_file_count = 0;
+static uint8_t verbose = false;
+static FILE *step_log = NULL;
+
+// Interrupt dispatch on the firmware thread
+static pthread_t firmware_thread;
+static volatile sig_atomic_t servicing = false; // Set while events are run. Vectors do not nest.
+static volatile uint32_t call_count = 0; // Firmware function calls. Checked by the watchdog.
+static volatile sig_atomic_t sim_quit = false;
+static struct timespec wall_start;
+static uint64_t poll_next = 0;
+
+// Peripheral state
+static uint64_t char_cycles; // Cycles per serial character (10 bits). Zero if unthrottled.
+static uint64_t t1_next = NEVER, t0_ovf_next = NEVER, t0_compa_next = NEVER, t3_next = NEVER;
+static uint64_t t2_next = NEVER;
+static uint64_t rx_next = 0, tx_next = 0, ee_next = NEVER;
+static uint64_t rx_due = NEVER, tx_due = NEVER; // USART events, while their interrupt is enabled
+static uint8_t usart_served = false; // Set when a USART vector runs. See spin_handler().
+static uint8_t rx_fifo[RX_FIFO_SIZE];
+static uint16_t rx_fifo_head = 0, rx_fifo_tail = 0;
+static int pty_fd = -1;
+
+// Internal streamer state
+static FILE *stream_fp = NULL;
+static uint8_t stream_index = 0;
+static uint8_t stream_eof = false;
+static uint8_t stream_ready = false; // Set by Grbl's welcome message. Reset flushes the RX buffer.
+static char stream_line[STREAM_LINE_MAX+1];
+static uint16_t stream_line_len = 0;
+static uint16_t stream_queue[STREAM_QUEUE_SIZE];
+static uint16_t stream_queue_head = 0, stream_queue_tail = 0;
+static uint16_t stream_in_flight = 0;
+static char response[STREAM_LINE_MAX+1];
+static uint16_t response_len = 0;
+static int16_t response_frame_remaining = 0; // Binary frame bytes to skip. Negative for the length byte.
+
+// Statistics
+static struct {
+  struct timespec wall_start;
+  uint64_t cycles_start;
+  uint8_t started;
+  uint32_t lines;
+  uint32_t errors;
+  uint64_t bytes;
+  uint32_t planner_stalls;
+  uint64_t planner_stall_cycles;
+  uint8_t planner_full;
+  uint64_t planner_full_since;
+  uint64_t stepper_isr_count;
+  uint32_t stepper_starved;
+  uint64_t steps[N_AXIS];
+  uint64_t last_step[N_AXIS];
+  uint64_t min_step_interval[N_AXIS];
+} stats;
+
+
+static double wall_seconds_since(struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return((now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec)*1e-9);
+}
+
+
+// Runs an interrupt vector. Only called while the I-bit is set, which the hardware clears on
+// entry. The clock keeps advancing with the calls the vector makes.
+static void run_vector(void (*vector)(void))
+{
+  uint8_t sreg = SREG;
+  SREG = sreg & ~(1<<SREG_I);
+  vector();
+  SREG = sreg;
+}
+
+
+static uint32_t timer_prescaler(uint8_t tccrb)
+{
+  switch (tccrb & 0x07) {
+    case 1: return(1);
+    case 2: return(8);
+    case 3: return(64);
+    case 4: return(256);
+    case 5: return(1024);
+  }
+  return(0); // Stopped or external clock.
+}
+
+
+// Timer2 has its own prescaler steps.
+static uint32_t timer2_prescaler(uint8_t tccrb)
+{
+  static const uint16_t prescaler[8] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+  return(prescaler[tccrb & 0x07]);
+}
+
+
+// Called by the wrapped plan_check_full_buffer() on the firmware thread. Each run of calls that
+// find the planner buffer full counts as one stall of the parser.
+uint8_t __real_plan_check_full_buffer();
+uint8_t __wrap_plan_check_full_buffer()
+{
+  uint8_t full = __real_plan_check_full_buffer();
+  if (full && !stats.planner_full) {
+    stats.planner_stalls++;
+    stats.planner_full_since = sim_cycles;
+  } else if (!full && stats.planner_full) {
+    stats.planner_stall_cycles += sim_cycles - stats.planner_full_since;
+  }
+  stats.planner_full = full;
+  return(full);
+}
+
+
+static void print_stats()
+{
+  double wall = 0.0, machine = 0.0;
+  if (stats.started) {
+    wall = wall_seconds_since(&stats.wall_start);
+    machine = (double)(sim_cycles - stats.cycles_start)/F_CPU;
+  }
+  fprintf(stderr, "\n[sim] %u lines (%u errors), %llu bytes in %.3f s wall, %.3f s machine time\n",
+    stats.lines, stats.errors, (unsigned long long)stats.bytes, wall, machine);
+  if (wall > 0.0 && machine > 0.0) {
+    fprintf(stderr, "[sim] throughput: %.1f lines/s wall, %.1f lines/s machine\n",
+      stats.lines/wall, stats.lines/machine);
+  }
+  fprintf(stderr, "[sim] planner stalls: %u, %.3f s machine time with a full planner buffer\n",
+    stats.planner_stalls, (double)stats.planner_stall_cycles/F_CPU);
+  fprintf(stderr, "[sim] stepper ISR: %llu calls, %u stops with planner blocks still queued\n",
+    (unsigned long long)stats.stepper_isr_count, stats.stepper_starved);
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    double peak = 0.0;
+    if (stats.min_step_interval[idx]) { peak = (double)F_CPU/stats.min_step_interval[idx]; }
+    fprintf(stderr, "[sim] axis %u (%c): %llu steps, peak %.0f steps/s\n", idx, axis_name[idx],
+      (unsigned long long)stats.steps[idx], peak);
+  }
+}
+
+
+static void sim_exit(int status)
+{
+  print_stats();
+  sim_eeprom_sync();
+  if (step_log) { fclose(step_log); }
+  fflush(NULL);
+  _exit(status);
+}
+
+
+static void quit_handler(int sig) { sim_quit = true; }
+
+
+// Starts the throughput clock on the first byte sent to Grbl.
+static void stats_start()
+{
+  if (!stats.started) {
+    stats.started = true;
+    clock_gettime(CLOCK_MONOTONIC, &stats.wall_start);
+    stats.cycles_start = sim_cycles;
+  }
+}
+
+
+// Opens the next G-code file of the stream list. Sets stream_eof when all files are done.
+static void stream_open_next()
+{
+  if (stream_fp) { fclose(stream_fp); stream_fp = NULL; }
+  while (stream_index < stream_file_count) {
+    const char *path = stream_files[stream_index++];
+    stream_fp = fopen(path, "r");
+    if (stream_fp) { return; }
+    perror(path);
+  }
+  stream_eof = true;
+}
+
+
+// Character-counting streaming protocol. Sends as many lines as fit in Grbl's RX buffer, one
+// more each time an 'ok' or 'error' frees space.
+static void stream_fill()
+{
+  if (!stream_ready) { return; }
+  for (;;) {
+    if (!stream_line_len) {
+      if (stream_eof) { return; }
+      if (!stream_fp) { stream_open_next(); continue; }
+      if (!fgets(stream_line, STREAM_LINE_MAX, stream_fp)) { stream_open_next(); continue; }
+      // Strip trailing whitespace and line endings, and skip blank lines.
+      stream_line_len = strlen(stream_line);
+      while (stream_line_len && (stream_line[stream_line_len-1] <= ' ')) { stream_line_len--; }
+      if (!stream_line_len) { continue; }
+      stream_line[stream_line_len++] = '\n';
+    }
+    if (stream_in_flight + stream_line_len > RX_BUFFER_SIZE-1) { return; }
+    if (((stream_queue_head+1) & (STREAM_QUEUE_SIZE-1)) == stream_queue_tail) { return; }
+    if (RX_FIFO_SIZE - ((rx_fifo_head - rx_fifo_tail) & (RX_FIFO_SIZE-1)) <= stream_line_len) { return; }
+    stats_start();
+    uint16_t i;
+    for (i=0; i<stream_line_len; i++) {
+      rx_fifo[rx_fifo_head] = stream_line[i];
+      rx_fifo_head = (rx_fifo_head+1) & (RX_FIFO_SIZE-1);
+    }
+    stream_queue[stream_queue_head] = stream_line_len;
+    stream_queue_head = (stream_queue_head+1) & (STREAM_QUEUE_SIZE-1);
+    stream_in_flight += stream_line_len;
+    stats.bytes += stream_line_len;
+    stream_line_len = 0;
+  }
+}
+
+
+// Collects Grbl's output into lines and counts each 'ok' or 'error' as a completed line. When
+// streaming internally, it also retires the oldest line in flight and echoes the response.
+static void stream_response(uint8_t c)
+{
+  // Skip binary status and position push frames. They start where a line would, with a control
+  // character no line starts with, followed by their payload length.
+  if (response_frame_remaining) {
+    response_frame_remaining = (response_frame_remaining < 0) ? c+2 : response_frame_remaining-1;
+    return;
+  }
+  if ((response_len == 0) && (c == 0x02 || c == 0x03)) {
+    response_frame_remaining = -1;
+    return;
+  }
+  if (c == '\r') { return; }
+  if (c != '\n') {
+    if (response_len < STREAM_LINE_MAX) { response[response_len++] = c; }
+    return;
+  }
+  response[response_len] = 0;
+  response_len = 0;
+  if (strncmp(response, "Grbl ", 5) == 0) { stream_ready = true; }
+  uint8_t is_ok = (strcmp(response, "ok") == 0);
+  uint8_t is_error = (strncmp(response, "error", 5) == 0);
+  if (!(is_ok || is_error)) {
+    if (pty_fd < 0) { printf("%s\n", response); }
+    return;
+  }
+  if (pty_fd < 0) {
+    if (verbose || is_error) { printf("%s\n", response); }
+    if (stream_queue_tail == stream_queue_head) { return; } // Not one of ours.
+    stream_in_flight -= stream_queue[stream_queue_tail];
+    stream_queue_tail = (stream_queue_tail+1) & (STREAM_QUEUE_SIZE-1);
+    stream_fill(); // Send the next line right away, like a sender waiting on the response.
+  }
+  stats.lines++;
+  if (is_error) { stats.errors++; }
+}
+
+
+// Exchanges bytes with the host side: the pseudo-terminal or the internal streamer.
+static void poll_host()
+{
+  if (pty_fd >= 0) {
+    uint8_t buf[256];
+    uint16_t room = RX_FIFO_SIZE - 1 - ((rx_fifo_head - rx_fifo_tail) & (RX_FIFO_SIZE-1));
+    if (room > sizeof(buf)) { room = sizeof(buf); }
+    ssize_t n = read(pty_fd, buf, room);
+    if (n > 0) {
+      stats_start();
+      stats.bytes += n;
+    }
+    ssize_t i;
+    for (i=0; i<n; i++) {
+      rx_fifo[rx_fifo_head] = buf[i];
+      rx_fifo_head = (rx_fifo_head+1) & (RX_FIFO_SIZE-1);
+    }
+  } else {
+    stream_fill();
+    // Streaming is complete once every line is answered, the machine has come to rest and no
+    // EEPROM writes are left waiting on the EEPROM ready interrupt.
+    if (stream_eof && !stream_line_len && (stream_queue_tail == stream_queue_head)) {
+      if ((sys.state == STATE_IDLE || sys.state == STATE_ALARM) && (plan_get_current_block() == NULL)
+           && !(TIMSK1 & (1<<OCIE1A)) && !(sim_eecr_peek() & (1<<EERIE))) {
+        sim_exit(stats.errors ? EXIT_FAILURE : EXIT_SUCCESS);
+      }
+    }
+  }
+}
+
+
+static void host_write(uint8_t c)
+{
+  if (pty_fd >= 0) {
+    if (write(pty_fd, &c, 1) < 0) { } // Drop output while no client is reading.
+  }
+  stream_response(c);
+}
+
+
+// Records step events by comparing machine positions across a stepper interrupt.
+static void stepper_isr(void)
+{
+  int32_t position[N_AXIS];
+  memcpy(position, sys_position, sizeof(position));
+  run_vector(TIMER1_COMPA_vect);
+  stats.stepper_isr_count++;
+
+  uint8_t idx, stepped = false;
+  for (idx=0; idx<N_AXIS; idx++) {
+    if (sys_position[idx] != position[idx]) {
+      stepped = true;
+      stats.steps[idx]++;
+      if (stats.last_step[idx]) {
+        uint64_t interval = sim_cycles - stats.last_step[idx];
+        if (!stats.min_step_interval[idx] || interval < stats.min_step_interval[idx]) {
+          stats.min_step_interval[idx] = interval;
+        }
+      }
+      stats.last_step[idx] = sim_cycles;
+    }
+  }
+  if (stepped && step_log) {
+    fprintf(step_log, "%llu", (unsigned long long)sim_cycles);
+    for (idx=0; idx<N_AXIS; idx++) { fprintf(step_log, ",%ld", (long)sys_position[idx]); }
+    fprintf(step_log, "\n");
+  }
+
+  // The stepper going idle while the planner still holds blocks means the segment buffer ran dry.
+  if (!(TIMSK1 & (1<<OCIE1A))) {
+    if ((sys.state == STATE_CYCLE) && (plan_get_current_block() != NULL)) { stats.stepper_starved++; }
+  }
+
+  // Schedule the step port reset as Timer0 would count up from the reloaded TCNT0.
+  uint32_t ps = timer_prescaler(TCCR0B);
+  if (ps) {
+    if ((TIMSK0 & (1<<TOIE0)) && TIMER0_OVF_vect) { t0_ovf_next = sim_cycles + (uint64_t)(256-TCNT0)*ps; }
+    if ((TIMSK0 & (1<<OCIE0A)) && TIMER0_COMPA_vect) {
+      t0_compa_next = sim_cycles + (uint64_t)((uint8_t)(OCR0A-TCNT0))*ps;
+    }
+  }
+}
+
+
+// Re-evaluates which peripherals are armed. Timers are started when their interrupt is enabled
+// and stopped when it is disabled by the firmware.
+static void update_timers()
+{
+  uint32_t ps = timer_prescaler(TCCR1B);
+  if ((TIMSK1 & (1<<OCIE1A)) && ps && TIMER1_COMPA_vect) {
+    if (t1_next == NEVER) { t1_next = sim_cycles + (uint64_t)(OCR1A+1)*ps; }
+  } else {
+    t1_next = NEVER;
+  }
+  if (!timer_prescaler(TCCR0B)) { t0_ovf_next = NEVER; t0_compa_next = NEVER; }
+  ps = timer_prescaler(TCCR3B);
+  if ((TIMSK3 & (1<<TOIE3)) && ps && TIMER3_OVF_vect) {
+    if (t3_next == NEVER) { t3_next = sim_cycles + (uint64_t)65536*ps; }
+  } else {
+    t3_next = NEVER;
+  }
+  ps = timer2_prescaler(TCCR2B);
+  if ((TIMSK2 & (1<<OCIE2A)) && ps && TIMER2_COMPA_vect) { // CTC mode only.
+    if (t2_next == NEVER) { t2_next = sim_cycles + (uint64_t)(OCR2A+1)*ps; }
+  } else {
+    t2_next = NEVER;
+  }
+  if ((sim_eecr_peek() & (1<<EERIE)) && EE_READY_vect) {
+    if (ee_next == NEVER) { ee_next = sim_cycles + EEPROM_WRITE_CYCLES; }
+  } else {
+    ee_next = NEVER;
+  }
+}
+
+
+// Returns the clock cycle of the earliest pending event, including the next host poll.
+static uint64_t next_event()
+{
+  update_timers();
+  rx_due = NEVER;
+  tx_due = NEVER;
+  if ((rx_fifo_head != rx_fifo_tail) && (UCSR0B & (1<<RXCIE0)) && USART0_RX_vect) { rx_due = rx_next; }
+  if ((UCSR0B & (1<<UDRIE0)) && USART0_UDRE_vect) { tx_due = tx_next; }
+  return(min(min(min(t1_next, t0_ovf_next), min(t0_compa_next, t3_next)),
+             min(min(rx_due, tx_due), min(min(ee_next, t2_next), poll_next))));
+}
+
+
+// Holds the virtual clock to wall time multiplied by the time scale.
+static void pace()
+{
+  if (time_scale <= 0.0) { return; }
+  double ahead = (double)sim_cycles/(time_scale*F_CPU) - wall_seconds_since(&wall_start);
+  if (ahead > 0.0) {
+    struct timespec ts = { (time_t)ahead, (long)((ahead - (time_t)ahead)*1e9) };
+    while (nanosleep(&ts, &ts) != 0) { } // Resume, if interrupted by the watchdog.
+  }
+}
+
+
+// Runs the events that are due by the virtual clock, in a fixed order. Interrupts wait until the
+// I-bit is set. Called at every firmware function call, so vectors run as soon as they can.
+static void service()
+{
+  if (servicing) { return; } // Vectors run to completion, without nesting.
+  servicing = true;
+  if (sim_quit) { sim_exit(EXIT_SUCCESS); }
+  for (;;) {
+    uint64_t next = next_event();
+    if (next > sim_cycles) { break; }
+    if (next == poll_next) {
+      poll_host();
+      pace();
+      poll_next = next + POLL_CYCLES;
+      continue;
+    }
+    if (!(SREG & (1<<SREG_I))) { break; }
+    if (next == t0_ovf_next) {
+      run_vector(TIMER0_OVF_vect);
+      uint32_t ps = timer_prescaler(TCCR0B);
+      t0_ovf_next = ps ? next + (uint64_t)256*ps : NEVER;
+    } else if (next == t0_compa_next) {
+      t0_compa_next = NEVER;
+      run_vector(TIMER0_COMPA_vect);
+    } else if (next == t1_next) {
+      stepper_isr(); // Reload from the compare value the stepper just set up.
+      uint32_t ps = timer_prescaler(TCCR1B);
+      t1_next = ps ? next + (uint64_t)(OCR1A+1)*ps : NEVER;
+    } else if (next == rx_due) {
+      UDR0 = rx_fifo[rx_fifo_tail];
+      rx_fifo_tail = (rx_fifo_tail+1) & (RX_FIFO_SIZE-1);
+      rx_next = next + char_cycles;
+      run_vector(USART0_RX_vect);
+      usart_served = true;
+    } else if (next == tx_due) {
+      tx_next = next + char_cycles;
+      run_vector(USART0_UDRE_vect);
+      host_write(UDR0);
+      usart_served = true;
+    } else if (next == t3_next) {
+      t3_next += (uint64_t)65536*timer_prescaler(TCCR3B);
+      run_vector(TIMER3_OVF_vect);
+    } else if (next == t2_next) {
+      t2_next += (uint64_t)(OCR2A+1)*timer2_prescaler(TCCR2B);
+      run_vector(TIMER2_COMPA_vect);
+    } else if (next == ee_next) {
+      ee_next = NEVER;
+      run_vector(EE_READY_vect);
+    }
+  }
+  servicing = false;
+}
+
+
+// Called on entry to every firmware function. Charges the call to the virtual clock.
+void __cyg_profile_func_enter(void *function, void *call_site)
+{
+  sim_cycles += call_cycles;
+  call_count++;
+  service();
+}
+
+
+void __cyg_profile_func_exit(void *function, void *call_site) { }
+
+
+// Busy-wait delays advance the clock to their end, running the events due on the way. Inside an
+// interrupt, the events wait until it returns.
+void sim_delay_us(double us)
+{
+  uint64_t target = sim_cycles + (uint64_t)(us*(F_CPU/1000000.0));
+  while (!servicing && (SREG & (1<<SREG_I)) && (sim_cycles < target)) {
+    uint64_t next = next_event();
+    if (next > sim_cycles) { sim_cycles = min(next, target); }
+    service();
+  }
+  if (sim_cycles < target) { sim_cycles = target; }
+}
+
+
+// Advances the clock of a firmware stuck in a loop that calls no function. These loops wait for
+// room in the serial TX buffer or for a reset, so events are run up to the next USART vector, or
+// for one host poll interval. Runs on the firmware thread, from the watchdog signal.
+static void spin_handler(int sig)
+{
+  if (servicing || !(SREG & (1<<SREG_I))) { return; } // Pacing or running a vector. Not stuck.
+  uint64_t until = sim_cycles + POLL_CYCLES;
+  usart_served = false;
+  while (!usart_served && !sim_quit && (sim_cycles < until)) {
+    uint64_t next = next_event();
+    if (next > sim_cycles) { sim_cycles = next; }
+    service();
+  }
+  service();
+}
+
+
+static void *watchdog_thread(void *arg)
+{
+  uint32_t last_count = call_count;
+  for (;;) {
+    struct timespec ts = { 0, WATCHDOG_NS };
+    nanosleep(&ts, NULL);
+    uint32_t count = call_count;
+    if ((count == last_count) || sim_quit) { pthread_kill(firmware_thread, SIGUSR1); }
+    last_count = count;
+  }
+  return(NULL);
+}
+
+
+static int open_pty()
+{
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0) { perror("pty"); exit(EXIT_FAILURE); }
+  // Keep the slave side open in raw mode, so the master never reads EOF between clients.
+  int slave = open(ptsname(fd), O_RDWR | O_NOCTTY);
+  struct termios tio;
+  if (slave >= 0 && tcgetattr(slave, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  fprintf(stderr, "[sim] serial port: %s\n", ptsname(fd));
+  return(fd);
+}
+
+
+static void usage(const char *name)
+{
+  fprintf(stderr,
+    "Usage: %s [options]\n"
+    "  -f FILE   stream a G-code file with the character-counting protocol (repeatable)\n"
+    "            and exit when done. Without -f, a pseudo-terminal is opened instead.\n"
+    "  -t SCALE  pace the virtual clock at SCALE times wall time (default 1.0, 0 = no pacing)\n"
+    "  -c CYCLES CPU cycles charged per firmware function call (default %d)\n"
+    "  -b BAUD   simulated serial baud rate (default %d, 0 = unthrottled)\n"
+    "  -e FILE   EEPROM image (default %s)\n"
+    "  -s FILE   log every step event as cycle,position[0..N_AXIS-1]\n"
+    "  -v        echo every response line, including 'ok'\n", name, CALL_CYCLES, BAUD_RATE, eeprom_path);
+}
+
+
+int main(int argc, char *argv[])
+{
+  int opt;
+  while ((opt = getopt(argc, argv, "f:t:c:b:e:s:vh")) != -1) {
+    switch (opt) {
+      case 'f':
+        if (stream_file_count < MAX_STREAM_FILES) { stream_files[stream_file_count++] = optarg; }
+        break;
+      case 't': time_scale = atof(optarg); break;
+      case 'c': call_cycles = atol(optarg); break;
+      case 'b': baud_rate = atol(optarg); break;
+      case 'e': eeprom_path = optarg; break;
+      case 's':
+        step_log = fopen(optarg, "w");
+        if (!step_log) { perror(optarg); return(EXIT_FAILURE); }
+        break;
+      case 'v': verbose = true; break;
+      default: usage(argv[0]); return(opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+  }
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  if (baud_rate) { char_cycles = (uint64_t)F_CPU*10/baud_rate; }
+  sim_eeprom_open(eeprom_path);
+  if (!stream_file_count) { pty_fd = open_pty(); }
+
+  // Input pins idle high with their pull-ups: no limits, controls or probe asserted.
+  PINA = PINB = PINC = PIND = PINE = PINF = PING = PINH = PINJ = PINK = PINL = 0xFF;
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = spin_handler;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGUSR1, &sa, NULL);
+  signal(SIGINT, quit_handler);
+  signal(SIGTERM, quit_handler);
+
+  clock_gettime(CLOCK_MONOTONIC, &wall_start);
+  firmware_thread = pthread_self();
+  pthread_t watchdog;
+  pthread_create(&watchdog, NULL, watchdog_thread, NULL);
+
+  return(grbl_main());
+}
@@ -0,0 +1,45 @@
+/*
+  sim.h - Host-native simulator of the ATmega2560 peripherals used by Grbl
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef sim_h
+#define sim_h
+
+#include <stdint.h>
+
+// Virtual CPU clock in F_CPU cycles since power-up. Charged for every firmware function call and
+// delay, and advanced to the next event while the firmware is idle.
+extern volatile uint64_t sim_cycles;
+
+// Size of the emulated EEPROM in bytes.
+#define SIM_EEPROM_SIZE 4096
+
+// Loads the EEPROM image from a file, creating it erased (0xFF) if it does not exist. Every
+// committed write is written through to the file.
+void sim_eeprom_open(const char *path);
+
+// Commits a pending EEPROM write strobe, if any. Called by the register accessors and on exit.
+void sim_eeprom_sync();
+
+// Returns the EEPROM control register without committing a pending strobe. For the event
+// scheduler, which may run in the middle of the firmware's own register accesses.
+uint8_t sim_eecr_peek();
+
+// Grbl's main(), renamed when main.c is compiled for the simulator.
+int grbl_main(void);
+
+#endif
@@ -0,0 +1,36 @@
+/*
+  util/crc16.h - Stand-in CRC routines for the host simulator build
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef sim_util_crc16_h
+#define sim_util_crc16_h
+
+#include <stdint.h>
+
+// The C equivalent avr-libc documents for its inline assembly version. CRC-CCITT, polynomial
+// 0x1021, most significant bit first.
+static inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data)
+{
+  crc = crc ^ ((uint16_t)data << 8);
+  for (uint8_t i=0; i<8; i++) {
+    if (crc & 0x8000) { crc = (crc << 1) ^ 0x1021; }
+    else { crc <<= 1; }
+  }
+  return(crc);
+}
+
+#endif
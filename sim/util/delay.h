@@ -0,0 +1,29 @@
+/*
+  util/delay.h - Stand-in busy-wait delays for the host simulator build
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef sim_util_delay_h
+#define sim_util_delay_h
+
+// Delays advance the simulator's virtual clock, not wall time. Interrupts keep firing while
+// waiting, unless the delay runs with interrupts disabled.
+void sim_delay_us(double us);
+
+#define _delay_ms(ms) sim_delay_us((ms)*1000.0)
+#define _delay_us(us) sim_delay_us(us)
+
+#endif